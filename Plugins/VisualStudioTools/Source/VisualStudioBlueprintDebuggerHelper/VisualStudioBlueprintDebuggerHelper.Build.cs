@@ -23,9 +23,14 @@ public class VisualStudioBlueprintDebuggerHelper: ModuleRules
                 "EditorSubsystem",
                 "MainFrame",
                 "BlueprintGraph",
-                "VisualStudioDTE",
                 "EditorStyle",
                 "Projects"
         });
+
+        // DTE only exists on Windows.
+        if (Target.Platform == UnrealTargetPlatform.Win64)
+        {
+            PrivateDependencyModuleNames.Add("VisualStudioDTE");
+        }
     }
 }
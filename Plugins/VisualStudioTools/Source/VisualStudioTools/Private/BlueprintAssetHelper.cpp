@@ -3,13 +3,19 @@
 
 #include "BlueprintAssetHelpers.h"
 
+#include "Algo/Transform.h"
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "Blueprint/BlueprintSupport.h"
 #include "Engine/BlueprintCore.h"
 #include "Engine/BlueprintGeneratedClass.h"
 #include "Engine/Engine.h"
 #include "Engine/StreamableManager.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/PackageName.h"
 #include "Misc/ScopeExit.h"
+#include "UObject/UObjectGlobals.h"
 #include "VisualStudioTools.h"
 
 namespace VisualStudioTools
@@ -49,9 +55,75 @@ static FString GetObjectPathString(const FAssetData& InAssetData)
 
 #endif // FILTER_ASSETS_BY_CLASS_PATH
 
+static double ToMiB(uint64 Bytes)
+{
+	return Bytes / (1024.0 * 1024.0);
+}
+
+/**
+* Tracks the memory used while processing the assets, and reports it for every block of assets.
+*/
+struct FAssetMemoryReport
+{
+	static constexpr int32 BlockSize = 1000;
+
+	int32 BlockStart = 0;
+	int32 NumSamples = 0;
+	uint64 Peak = 0;
+	double Sum = 0.0;
+
+	void Sample(int32 AssetIdx, uint64 UsedPhysical)
+	{
+		Peak = FMath::Max(Peak, UsedPhysical);
+		Sum += UsedPhysical;
+		NumSamples++;
+
+		if (NumSamples == BlockSize)
+		{
+			Flush(AssetIdx);
+		}
+	}
+
+	void Flush(int32 LastAssetIdx)
+	{
+		if (NumSamples == 0)
+		{
+			return;
+		}
+
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Memory for blueprints [%d-%d]: peak %.1f MiB, average %.1f MiB."),
+			BlockStart + 1, LastAssetIdx + 1, ToMiB(Peak), ToMiB(static_cast<uint64>(Sum / NumSamples)));
+
+		BlockStart = LastAssetIdx + 1;
+		NumSamples = 0;
+		Peak = 0;
+		Sum = 0.0;
+	}
+};
+
+FString GetPackageFileKey(const FString& PackageName)
+{
+	FString PackageFileName;
+	FString PackageFile;
+	if (!FPackageName::TryConvertLongPackageNameToFilename(PackageName, PackageFileName) ||
+		!FPackageName::FindPackageFileWithoutExtension(PackageFileName, PackageFile))
+	{
+		return FString();
+	}
+
+	FFileStatData StatData = IFileManager::Get().GetStatData(*PackageFile);
+	if (!StatData.bIsValid)
+	{
+		return FString();
+	}
+
+	return FString::Printf(TEXT("%lld-%lld"), StatData.ModificationTime.GetTicks(), StatData.FileSize);
+}
+
 void ForEachAsset(
 	const TArray<FAssetData>& TargetAssets,
-	TFunctionRef<void(UBlueprintGeneratedClass*, const FAssetData& AssetData)> Callback)
+	TFunctionRef<void(UBlueprintGeneratedClass*, const FAssetData& AssetData)> Callback,
+	const FForEachAssetOptions& Options)
 {
 	// Show a simpler logging output.
 	// LogTimes are still useful to tell how long it takes to process each asset.
@@ -66,27 +138,77 @@ void ForEachAsset(
 		GEngine->Exec(nullptr, TEXT("log reset"));
 	};
 
+	const int32 LoadWindow = FMath::Max(Options.LoadWindow, 1);
+	const int32 ReleaseBatchSize = FMath::Max(Options.ReleaseBatchSize, 1);
+	const double StartTime = FPlatformTime::Seconds();
+
+	FAssetMemoryReport MemoryReport;
+	int32 NumGarbageCollections = 0;
+
+	// Memory used after the last garbage collection.
+	uint64 UsedAfterLastGC = 0;
+
 	FStreamableManager AssetLoader;
 
-	for (int32 Idx = 0; Idx < TargetAssets.Num(); Idx++)
+	TArray<FSoftClassPath> GenClassPaths;
+	Algo::Transform(TargetAssets, GenClassPaths, [](const FAssetData& AssetData)
+		{
+			return FSoftClassPath(AssetData.GetTagValueRef<FString>(FBlueprintTags::GeneratedClassPath));
+		});
+
+	// Handles for the requests in flight, indexed like `TargetAssets`.
+	TArray<TSharedPtr<FStreamableHandle>> PendingHandles;
+	PendingHandles.SetNum(TargetAssets.Num());
+
+	// Handles for the processed assets, waiting to be released in a batch.
+	TArray<TSharedPtr<FStreamableHandle>> ProcessedHandles;
+	ProcessedHandles.Reserve(ReleaseBatchSize);
+
+	auto ReleaseHandles = [](TArray<TSharedPtr<FStreamableHandle>>& Handles)
 	{
-		const FAssetData AssetData = TargetAssets[Idx];
-		FSoftClassPath GenClassPath = AssetData.GetTagValueRef<FString>(FBlueprintTags::GeneratedClassPath);
-		UE_LOG(LogVisualStudioTools, Display, TEXT("Processing blueprints [%d/%d]: %s"), Idx + 1, TargetAssets.Num(), *GenClassPath.ToString());
+		for (TSharedPtr<FStreamableHandle>& Handle : Handles)
+		{
+			if (Handle.IsValid())
+			{
+				// We're done, notify an unload.
+				Handle->ReleaseHandle();
+			}
+		}
+		Handles.Reset();
+	};
+
+	ON_SCOPE_EXIT
+	{
+		ReleaseHandles(ProcessedHandles);
+		ReleaseHandles(PendingHandles);
+	};
 
-		TSharedPtr<FStreamableHandle> Handle = AssetLoader.RequestSyncLoad(GenClassPath);
-		ON_SCOPE_EXIT
+	int32 NextRequestIdx = 0;
+	for (int32 Idx = 0; Idx < TargetAssets.Num(); Idx++)
+	{
+		// Keep the window of requests ahead of the current asset full,
+		// so the loader can work on them while we process this one.
+		const int32 LastRequestIdx = FMath::Min(Idx + LoadWindow, TargetAssets.Num());
+		for (; NextRequestIdx < LastRequestIdx; NextRequestIdx++)
 		{
-			// We're done, notify an unload.
-			Handle->ReleaseHandle();
-		};
+			PendingHandles[NextRequestIdx] = AssetLoader.RequestAsyncLoad(GenClassPaths[NextRequestIdx]);
+		}
+
+		const FAssetData& AssetData = TargetAssets[Idx];
+		const FSoftClassPath& GenClassPath = GenClassPaths[Idx];
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Processing blueprints [%d/%d]: %s"), Idx + 1, TargetAssets.Num(), *GenClassPath.ToString());
 
+		TSharedPtr<FStreamableHandle> Handle = MoveTemp(PendingHandles[Idx]);
 		if (!Handle.IsValid())
 		{
 			UE_LOG(LogVisualStudioTools, Warning, TEXT("Failed to get a streamable handle for Blueprint. Skipping. GenClassPath: %s"), *GenClassPath.ToString());
 			continue;
 		}
 
+		// Only blocks until this asset is loaded, the rest of the window keeps loading.
+		Handle->WaitUntilComplete();
+		ProcessedHandles.Add(Handle);
+
 		if (auto BlueprintGeneratedClass = Cast<UBlueprintGeneratedClass>(Handle->GetLoadedAsset()))
 		{
 			Callback(BlueprintGeneratedClass, AssetData);
@@ -106,7 +228,50 @@ void ForEachAsset(
 
 			UE_LOG(LogVisualStudioTools, Warning, TEXT("Failed to load Blueprint. Skipping. %s"), *Msg);
 		}
+
+		const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+		MemoryReport.Sample(Idx, UsedPhysical);
+
+		if (ProcessedHandles.Num() >= ReleaseBatchSize)
+		{
+			ReleaseHandles(ProcessedHandles);
+
+			// The released assets are only unloaded by a garbage collection, which is too slow to run on every batch.
+			// When a collection doesn't bring the memory back under the ceiling, wait for it to grow again before the next one.
+			if (Options.MemoryCeiling > 0 && UsedPhysical > Options.MemoryCeiling &&
+				UsedPhysical > UsedAfterLastGC + Options.MemoryGrowthBeforeCollection)
+			{
+				// Let the caller release the objects it still holds, so this collection can reclaim them.
+				if (Options.OnBeforeGarbageCollection)
+				{
+					Options.OnBeforeGarbageCollection();
+				}
+
+				const double GCStartTime = FPlatformTime::Seconds();
+				CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+				NumGarbageCollections++;
+
+				const uint64 UsedAfterGC = FPlatformMemory::GetStats().UsedPhysical;
+				UsedAfterLastGC = UsedAfterGC;
+				UE_LOG(LogVisualStudioTools, Display, TEXT("Memory above the %.1f MiB ceiling, collected garbage in %.2fs: %.1f MiB -> %.1f MiB (%.1f MiB reclaimed)."),
+					ToMiB(Options.MemoryCeiling),
+					FPlatformTime::Seconds() - GCStartTime,
+					ToMiB(UsedPhysical),
+					ToMiB(UsedAfterGC),
+					UsedAfterGC < UsedPhysical ? ToMiB(UsedPhysical - UsedAfterGC) : 0.0);
+			}
+		}
 	}
+
+	MemoryReport.Flush(TargetAssets.Num() - 1);
+
+	const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Processed %d blueprints in %.2fs (%.1f assets/s). Peak memory: %.1f MiB. Garbage collections: %d."),
+		TargetAssets.Num(),
+		ElapsedSeconds,
+		ElapsedSeconds > 0.0 ? TargetAssets.Num() / ElapsedSeconds : 0.0,
+		ToMiB(FPlatformMemory::GetStats().PeakUsedPhysical),
+		NumGarbageCollections);
 }
 
 }
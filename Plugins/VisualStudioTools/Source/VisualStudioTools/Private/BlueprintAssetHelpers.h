@@ -13,14 +13,54 @@ namespace AssetHelpers
 {
 void SetBlueprintClassFilter(FARFilter& InOutFilter);
 
+/**
+* Returns a key identifying the current version of the package file on disk, built from its timestamp and size.
+* Returns an empty string if the package file can't be found.
+*/
+FString GetPackageFileKey(const FString& PackageName);
+
+/**
+* Controls how ForEachAsset pipelines the asset loads.
+*/
+struct FForEachAssetOptions
+{
+	/** Number of async load requests kept in flight ahead of the asset being processed. */
+	int32 LoadWindow = 32;
+
+	/** Number of processed assets whose streamable handles are released together. */
+	int32 ReleaseBatchSize = 64;
+
+	/**
+	* Physical memory, in bytes, above which garbage is collected after releasing a batch of handles.
+	* Zero disables the ceiling. Callers must not keep raw pointers to the loaded objects across callbacks.
+	*/
+	uint64 MemoryCeiling = 0;
+
+	/**
+	* Growth of the physical memory, in bytes, since the last garbage collection before collecting again.
+	* Keeps the collections from running on every batch when the memory left after a collection is still above the ceiling.
+	*/
+	uint64 MemoryGrowthBeforeCollection = 256ull * 1024 * 1024;
+
+	/**
+	* Invoked right before garbage is collected.
+	* Callers holding loaded objects alive across callbacks should finish their work on them and release them here.
+	*/
+	TFunction<void()> OnBeforeGarbageCollection;
+};
+
 /**
 * Loads each blueprint asset and invokes the callback with the resulting blueprint generated class.
-* Each iteration will load the asset using a FStreamableHandle and verify that is a valid blueprint
-* before invoking the callback.
+* Loads are requested asynchronously for a sliding window of assets ahead of the one being processed,
+* so package loading overlaps with the callbacks. The callback is still invoked on the game thread,
+* in the same order as `TargetAssets`, and only for assets that loaded as a valid blueprint.
+* Handles are released in batches once their assets are processed, and garbage is collected
+* at that point if the memory used is above `MemoryCeiling` and grew enough since the last collection.
 */
 void ForEachAsset(
 	const TArray<FAssetData>& TargetAssets,
-	TFunctionRef<void(UBlueprintGeneratedClass*, const FAssetData& AssetData)> Callback);
+	TFunctionRef<void(UBlueprintGeneratedClass*, const FAssetData& AssetData)> Callback,
+	const FForEachAssetOptions& Options = FForEachAssetOptions());
 
 } // namespace AssetHelpers
 } // namespace VisualStudioTools
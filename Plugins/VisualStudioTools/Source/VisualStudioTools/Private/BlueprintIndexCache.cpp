@@ -0,0 +1,337 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+// Licensed under the MIT License.
+
+#include "BlueprintIndexCache.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Blueprint/BlueprintSupport.h"
+#include "BlueprintAssetHelpers.h"
+#include "Dom/JsonObject.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "VisualStudioTools.h"
+
+namespace VisualStudioTools
+{
+// Bump when the cached data or the way it's computed changes.
+static constexpr int32 CacheVersion = 2;
+
+bool FBlueprintIndexCache::Load(const FString& InFilePath)
+{
+	Entries.Reset();
+
+	FString Contents;
+	if (!FFileHelper::LoadFileToString(Contents, *InFilePath))
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Contents);
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+	{
+		UE_LOG(LogVisualStudioTools, Warning, TEXT("Failed to parse the blueprint index cache, it will be rebuilt. Path: %s"), *InFilePath);
+		return false;
+	}
+
+	// Property values are serialized by the engine, so don't reuse a cache from another version.
+	int32 Version = 0;
+	FString EngineVersion;
+	if (!Root->TryGetNumberField(TEXT("version"), Version) || Version != CacheVersion
+		|| !Root->TryGetStringField(TEXT("engine"), EngineVersion) || EngineVersion != FEngineVersion::Current().ToString())
+	{
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Blueprint index cache is out of date, it will be rebuilt."));
+		return false;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* EntryValues = nullptr;
+	if (!Root->TryGetArrayField(TEXT("entries"), EntryValues))
+	{
+		UE_LOG(LogVisualStudioTools, Warning, TEXT("Malformed blueprint index cache, it will be rebuilt. Path: %s"), *InFilePath);
+		return false;
+	}
+
+	for (const TSharedPtr<FJsonValue>& EntryValue : *EntryValues)
+	{
+		FString PackageName;
+		FEntry Entry;
+		if (!EntryValue.IsValid() || !ParseEntry(*EntryValue, PackageName, Entry))
+		{
+			// A partly read cache can't be trusted, discard all of it.
+			UE_LOG(LogVisualStudioTools, Warning, TEXT("Malformed blueprint index cache, it will be rebuilt. Path: %s"), *InFilePath);
+			Entries.Reset();
+			return false;
+		}
+
+		Entries.Add(MoveTemp(PackageName), MoveTemp(Entry));
+	}
+
+	return true;
+}
+
+bool FBlueprintIndexCache::ParseEntry(const FJsonValue& EntryValue, FString& OutPackageName, FEntry& OutEntry)
+{
+	const TSharedPtr<FJsonObject>* EntryObject = nullptr;
+	const TArray<TSharedPtr<FJsonValue>>* ParentValues = nullptr;
+	if (!EntryValue.TryGetObject(EntryObject)
+		|| !(*EntryObject)->TryGetStringField(TEXT("package"), OutPackageName)
+		|| !(*EntryObject)->TryGetStringField(TEXT("key"), OutEntry.PackageKey)
+		|| !(*EntryObject)->TryGetStringField(TEXT("name"), OutEntry.Data.Name)
+		|| !(*EntryObject)->TryGetStringField(TEXT("path"), OutEntry.Data.Path)
+		|| !(*EntryObject)->TryGetArrayField(TEXT("parents"), ParentValues))
+	{
+		return false;
+	}
+
+	for (const TSharedPtr<FJsonValue>& ParentValue : *ParentValues)
+	{
+		const TSharedPtr<FJsonObject>* ParentObject = nullptr;
+		const TArray<TSharedPtr<FJsonValue>>* PropertyValues = nullptr;
+		const TArray<TSharedPtr<FJsonValue>>* FunctionValues = nullptr;
+		FBlueprintParentData& ParentData = OutEntry.Data.Parents.AddDefaulted_GetRef();
+		double LayoutHash = 0.0;
+		if (!ParentValue.IsValid() || !ParentValue->TryGetObject(ParentObject)
+			|| !(*ParentObject)->TryGetStringField(TEXT("class"), ParentData.ClassPath)
+			|| !(*ParentObject)->TryGetNumberField(TEXT("hash"), LayoutHash)
+			|| !(*ParentObject)->TryGetArrayField(TEXT("properties"), PropertyValues)
+			|| !(*ParentObject)->TryGetArrayField(TEXT("functions"), FunctionValues))
+		{
+			return false;
+		}
+
+		OutEntry.LayoutHashes.Add(static_cast<uint32>(LayoutHash));
+
+		for (const TSharedPtr<FJsonValue>& PropertyValue : *PropertyValues)
+		{
+			const TSharedPtr<FJsonObject>* PropertyObject = nullptr;
+			FString PropertyName;
+			if (!PropertyValue.IsValid() || !PropertyValue->TryGetObject(PropertyObject)
+				|| !(*PropertyObject)->TryGetStringField(TEXT("name"), PropertyName))
+			{
+				return false;
+			}
+
+			// The value is optional, it's only stored for the property types that support it.
+			ParentData.Properties.Emplace(MoveTemp(PropertyName), (*PropertyObject)->TryGetField(TEXT("value")));
+		}
+
+		for (const TSharedPtr<FJsonValue>& FunctionValue : *FunctionValues)
+		{
+			FString FunctionName;
+			if (!FunctionValue.IsValid() || !FunctionValue->TryGetString(FunctionName))
+			{
+				return false;
+			}
+
+			ParentData.Functions.Add(MoveTemp(FunctionName));
+		}
+	}
+
+	return true;
+}
+
+bool FBlueprintIndexCache::Save(const FString& InFilePath) const
+{
+	TArray<TSharedPtr<FJsonValue>> EntryValues;
+	EntryValues.Reserve(Entries.Num());
+
+	for (const auto& Item : Entries)
+	{
+		const FEntry& Entry = Item.Value;
+
+		TSharedRef<FJsonObject> EntryObject = MakeShared<FJsonObject>();
+		EntryObject->SetStringField(TEXT("package"), Item.Key);
+		EntryObject->SetStringField(TEXT("key"), Entry.PackageKey);
+		EntryObject->SetStringField(TEXT("name"), Entry.Data.Name);
+		EntryObject->SetStringField(TEXT("path"), Entry.Data.Path);
+
+		TArray<TSharedPtr<FJsonValue>> ParentValues;
+		for (int32 Idx = 0; Idx < Entry.Data.Parents.Num(); Idx++)
+		{
+			const FBlueprintParentData& ParentData = Entry.Data.Parents[Idx];
+
+			TSharedRef<FJsonObject> ParentObject = MakeShared<FJsonObject>();
+			ParentObject->SetStringField(TEXT("class"), ParentData.ClassPath);
+			ParentObject->SetNumberField(TEXT("hash"), Entry.LayoutHashes[Idx]);
+
+			TArray<TSharedPtr<FJsonValue>> PropertyValues;
+			for (const TPair<FString, TSharedPtr<FJsonValue>>& Property : ParentData.Properties)
+			{
+				TSharedRef<FJsonObject> PropertyObject = MakeShared<FJsonObject>();
+				PropertyObject->SetStringField(TEXT("name"), Property.Key);
+				if (Property.Value.IsValid())
+				{
+					PropertyObject->SetField(TEXT("value"), Property.Value);
+				}
+				PropertyValues.Add(MakeShared<FJsonValueObject>(PropertyObject));
+			}
+			ParentObject->SetArrayField(TEXT("properties"), PropertyValues);
+
+			TArray<TSharedPtr<FJsonValue>> FunctionValues;
+			for (const FString& Function : ParentData.Functions)
+			{
+				FunctionValues.Add(MakeShared<FJsonValueString>(Function));
+			}
+			ParentObject->SetArrayField(TEXT("functions"), FunctionValues);
+
+			ParentValues.Add(MakeShared<FJsonValueObject>(ParentObject));
+		}
+		EntryObject->SetArrayField(TEXT("parents"), ParentValues);
+
+		EntryValues.Add(MakeShared<FJsonValueObject>(EntryObject));
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("version"), CacheVersion);
+	Root->SetStringField(TEXT("engine"), FEngineVersion::Current().ToString());
+	Root->SetArrayField(TEXT("entries"), EntryValues);
+
+	FString Contents;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Contents);
+	if (!FJsonSerializer::Serialize(Root, Writer))
+	{
+		return false;
+	}
+
+	if (!FFileHelper::SaveStringToFile(Contents, *InFilePath))
+	{
+		UE_LOG(LogVisualStudioTools, Warning, TEXT("Failed to write the blueprint index cache. Path: %s"), *InFilePath);
+		return false;
+	}
+
+	return true;
+}
+
+const FBlueprintData* FBlueprintIndexCache::Find(const FString& PackageName, const FString& PackageKey)
+{
+	const FEntry* Entry = Entries.Find(PackageName);
+	if (Entry == nullptr || PackageKey.IsEmpty() || Entry->PackageKey != PackageKey)
+	{
+		return nullptr;
+	}
+
+	// The changed properties are relative to the native defaults, so any change in the parents invalidates the entry.
+	for (int32 Idx = 0; Idx < Entry->Data.Parents.Num(); Idx++)
+	{
+		uint32 LayoutHash = GetClassLayoutHash(Entry->Data.Parents[Idx].ClassPath);
+		if (LayoutHash == 0 || LayoutHash != Entry->LayoutHashes[Idx])
+		{
+			return nullptr;
+		}
+	}
+
+	return &Entry->Data;
+}
+
+void FBlueprintIndexCache::Add(const FString& PackageName, const FString& PackageKey, const FBlueprintData& Data)
+{
+	FEntry& Entry = Entries.FindOrAdd(PackageName);
+	Entry.PackageKey = PackageKey;
+	Entry.Data = Data;
+
+	Entry.LayoutHashes.Reset(Data.Parents.Num());
+	for (const FBlueprintParentData& ParentData : Data.Parents)
+	{
+		Entry.LayoutHashes.Add(GetClassLayoutHash(ParentData.ClassPath));
+	}
+}
+
+int32 FBlueprintIndexCache::RemoveMissingPackages()
+{
+	int32 NumRemoved = 0;
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (!FPackageName::DoesPackageExist(It.Key()))
+		{
+			It.RemoveCurrent();
+			NumRemoved++;
+		}
+	}
+
+	return NumRemoved;
+}
+
+FString FBlueprintIndexCache::GetPackageKey(const FAssetData& AssetData)
+{
+	const FString PackageName = AssetData.PackageName.ToString();
+	if (const FString* Found = PackageKeys.Find(PackageName))
+	{
+		return *Found;
+	}
+
+	// Guard against cycles in broken blueprint hierarchies, an empty key is never a cache hit.
+	PackageKeys.Add(PackageName, FString());
+
+	FString PackageKey = AssetHelpers::GetPackageFileKey(PackageName);
+
+	FString ParentClassPath = FPackageName::ExportTextPathToObjectPath(AssetData.GetTagValueRef<FString>(FBlueprintTags::ParentClassPath));
+	FString ParentPackageName = FPackageName::ObjectPathToPackageName(ParentClassPath);
+	if (!PackageKey.IsEmpty() && !ParentPackageName.IsEmpty() && !ParentPackageName.StartsWith(TEXT("/Script/")))
+	{
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+		TArray<FAssetData> ParentAssets;
+		AssetRegistry.GetAssetsByPackageName(FName(*ParentPackageName), ParentAssets);
+
+		FString ParentKey = ParentAssets.Num() > 0 ? GetPackageKey(ParentAssets[0]) : FString();
+		PackageKey = ParentKey.IsEmpty() ? FString() : PackageKey + TEXT("/") + ParentKey;
+	}
+
+	PackageKeys[PackageName] = PackageKey;
+	return PackageKey;
+}
+
+uint32 FBlueprintIndexCache::GetClassLayoutHash(const FString& ClassPath)
+{
+	if (const uint32* Found = LayoutHashes.Find(ClassPath))
+	{
+		return *Found;
+	}
+
+	uint32 Hash = 0;
+	if (const UClass* Class = FindObject<UClass>(nullptr, *ClassPath))
+	{
+		Hash = FCrc::StrCrc32(*ClassPath);
+
+		// A different super class changes the list of native parents of the blueprints.
+		if (const UClass* Super = Class->GetSuperClass())
+		{
+			Hash = FCrc::StrCrc32(*Super->GetPathName(), Hash);
+		}
+
+		// Include the inherited properties: a native constructor can change the defaults of its super classes,
+		// and the values of the blueprints are compared against those defaults.
+		const UObject* ClassDefault = Class->GetDefaultObject(false);
+		for (TFieldIterator<FProperty> It(Class, EFieldIteratorFlags::IncludeSuper); It; ++It)
+		{
+			FProperty* Property = *It;
+			Hash = FCrc::StrCrc32(*Property->GetName(), Hash);
+			Hash = FCrc::StrCrc32(*Property->GetCPPType(), Hash);
+
+			for (int32 Idx = 0; ClassDefault != nullptr && Idx < Property->ArrayDim; Idx++)
+			{
+				FString DefaultValue;
+				Property->ExportText_InContainer(Idx, DefaultValue, ClassDefault, nullptr, nullptr, PPF_None);
+				Hash = FCrc::StrCrc32(*DefaultValue, Hash);
+			}
+		}
+
+		for (TFieldIterator<UFunction> It(Class, EFieldIteratorFlags::ExcludeSuper); It; ++It)
+		{
+			Hash = FCrc::StrCrc32(*It->GetName(), Hash);
+		}
+
+		// Zero is reserved for missing classes.
+		Hash = FMath::Max(Hash, 1u);
+	}
+
+	LayoutHashes.Add(ClassPath, Hash);
+	return Hash;
+}
+
+} // namespace VisualStudioTools
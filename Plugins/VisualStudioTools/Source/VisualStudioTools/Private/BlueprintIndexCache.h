@@ -0,0 +1,92 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonValue.h"
+
+namespace VisualStudioTools
+{
+/**
+* Index data contributed by a blueprint to one of its native parent classes.
+* Holds no UObject references, so it can be cached across runs.
+*/
+struct FBlueprintParentData
+{
+	/** Path name of the native parent class. */
+	FString ClassPath;
+
+	/** Properties of the parent class changed by the blueprint, with their serialized value when supported. */
+	TArray<TPair<FString, TSharedPtr<FJsonValue>>> Properties;
+
+	/** Functions of the parent class implemented by the blueprint. */
+	TArray<FString> Functions;
+};
+
+/**
+* Index data for a single blueprint.
+*/
+struct FBlueprintData
+{
+	FString Name;
+	FString Path;
+	TArray<FBlueprintParentData> Parents;
+};
+
+/**
+* Persistent cache of the per-blueprint index data, so unchanged blueprints don't have to be loaded again.
+* Entries are keyed by package name and validated against the package file timestamp and size,
+* and against the layout hash of each native parent class they reference.
+*/
+class FBlueprintIndexCache
+{
+public:
+	/** Loads the cache file. Returns false, leaving the cache empty, if it's missing, malformed or incompatible. */
+	bool Load(const FString& InFilePath);
+
+	/** Writes the cache file. */
+	bool Save(const FString& InFilePath) const;
+
+	/** Returns the cached data for the package, or null if the package or any of its native parents changed. */
+	const FBlueprintData* Find(const FString& PackageName, const FString& PackageKey);
+
+	/** Adds or replaces the cached data for the package. */
+	void Add(const FString& PackageName, const FString& PackageKey, const FBlueprintData& Data);
+
+	/** Removes the entries of packages that no longer exist on disk. Returns the number of removed entries. */
+	int32 RemoveMissingPackages();
+
+	/**
+	* Returns the key identifying the current version of the blueprint package on disk, or an empty string if it can't be found.
+	* Blueprints inherit the defaults of their blueprint parents, so the key covers the packages of the parent blueprints too.
+	*/
+	FString GetPackageKey(const FAssetData& AssetData);
+
+private:
+	struct FEntry
+	{
+		FString PackageKey;
+		FBlueprintData Data;
+
+		/** Layout hashes of the native parents, in the same order as `Data.Parents`. */
+		TArray<uint32> LayoutHashes;
+	};
+
+	/** Reads an entry of the cache file. Returns false if any of its fields is missing or has the wrong type. */
+	static bool ParseEntry(const FJsonValue& EntryValue, FString& OutPackageName, FEntry& OutEntry);
+
+	/**
+	* Returns the layout hash of a native class, or 0 if the class can't be found.
+	* Covers the inherited properties too, since a native constructor can change the defaults of its super classes.
+	*/
+	uint32 GetClassLayoutHash(const FString& ClassPath);
+
+	TMap<FString, FEntry> Entries;
+
+	/** Keys and hashes computed during this run, by package name and class path. */
+	TMap<FString, FString> PackageKeys;
+	TMap<FString, uint32> LayoutHashes;
+};
+
+} // namespace VisualStudioTools
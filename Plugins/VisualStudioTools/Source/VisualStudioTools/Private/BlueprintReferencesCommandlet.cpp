@@ -7,9 +7,11 @@
 #include "Algo/Transform.h"
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "BlueprintAssetHelpers.h"
+#include "BlueprintReferencesIndex.h"
 #include "Engine/BlueprintGeneratedClass.h"
 #include "FindInBlueprintManager.h"
 #include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 #include "Misc/ScopeExit.h"
 #include "Policies/CondensedJsonPrintPolicy.h"
@@ -118,6 +120,83 @@ TMap<FString, FAssetData> GetConfirmedAssets(
 
 	return OutResults;
 }
+
+/**
+* Blueprints referencing a single symbol.
+*/
+struct FSymbolReferences
+{
+	FString Symbol;
+	TMap<FString, FAssetData> Blueprints;
+
+	/** Number of candidate blueprints considered for the symbol. */
+	int32 CandidateCount = 0;
+};
+
+static bool ParseSymbol(const FString& Symbol, FString& OutClassNameWithoutPrefix, FString& OutFunctionName)
+{
+	FString ClassNameNative;
+	if (!Symbol.Split(TEXT("::"), &ClassNameNative, &OutFunctionName))
+	{
+		return false;
+	}
+
+	OutClassNameWithoutPrefix = StripClassPrefix(ClassNameNative);
+	return true;
+}
+
+static void FindReferencesWithSearch(FSymbolReferences& InOutReferences)
+{
+	FString FunctionName;
+	FString ClassNameWithoutPrefix;
+	ParseSymbol(InOutReferences.Symbol, ClassNameWithoutPrefix, FunctionName);
+
+	// Execute the search in two stages:
+	// 1. Use FindInBlueprints to get all candidate blueprints with calls to functions that match the requested symbol
+	// 2. Confirm the blueprints reference the requested function, by matching the target UFunction in their call graph.
+	// The first step acts as a filter to avoid loading too many blueprints to inspect their call graph.
+	// The second step is required because the FiB data does not always allow for searching with the function
+	// qualified with the owned class name, if the function is static.
+
+	// Create a FiB search query for function nodes where the native name matches the requested symbol
+	FString SearchValue = FString::Printf(TEXT("Nodes(\"Native Name\"=+%s & ClassName=K2Node_CallFunction)"), *FunctionName);
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Blueprint search query: %s"), *SearchValue);
+
+	// Step 1: Execute the Fib search
+	TArray<FAssetData> TargetAssets = SearchForCandidateAssets(SearchValue);
+
+	// Step 2: Load the assets to confirm they are a match
+	InOutReferences.Blueprints = GetConfirmedAssets(FunctionName, ClassNameWithoutPrefix, TargetAssets);
+	InOutReferences.CandidateCount = TargetAssets.Num();
+}
+
+static void FindReferencesWithIndex(const FBlueprintReferencesIndex& ReferencesIndex, FSymbolReferences& InOutReferences)
+{
+	FString FunctionName;
+	FString ClassNameWithoutPrefix;
+	ParseSymbol(InOutReferences.Symbol, ClassNameWithoutPrefix, FunctionName);
+
+	const TArray<FString>* Callers = ReferencesIndex.FindCallers(ClassNameWithoutPrefix, FunctionName);
+	if (Callers == nullptr)
+	{
+		return;
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	for (const FString& PackageName : *Callers)
+	{
+		TArray<FAssetData> Assets;
+		AssetRegistry.GetAssetsByPackageName(FName(*PackageName), Assets);
+		if (Assets.Num() > 0)
+		{
+			InOutReferences.Blueprints.Add(ReferencesIndex.GetBlueprintName(PackageName), Assets[0]);
+		}
+	}
+
+	InOutReferences.CandidateCount = Callers->Num();
+}
+
 using JsonWriter = TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>;
 
 static void SerializeBlueprintReference(
@@ -126,7 +205,7 @@ static void SerializeBlueprintReference(
 	FString PackageFileName;
 	FString PackageFile;
 	FString PackageFilePath;
-	if (FPackageName::TryConvertLongPackageNameToFilename(Asset.GetPackage()->GetName(), PackageFileName) &&
+	if (FPackageName::TryConvertLongPackageNameToFilename(Asset.PackageName.ToString(), PackageFileName) &&
 		FPackageName::FindPackageFileWithoutExtension(PackageFileName, PackageFile))
 	{
 		PackageFilePath = FPaths::ConvertRelativePathToFull(MoveTemp(PackageFile));
@@ -179,9 +258,37 @@ static void SerializeResults(
 	Json->WriteObjectEnd();
 	Json->Close();
 }
+
+static void SerializeBatchResults(
+	const TArray<FSymbolReferences>& InResults,
+	FArchive& OutArchive)
+{
+	TSharedRef<JsonWriter> Json = JsonWriter::Create(&OutArchive);
+	Json->WriteObjectStart();
+
+	Json->WriteIdentifierPrefix(TEXT("symbols"));
+	Json->WriteArrayStart();
+
+	for (const FSymbolReferences& Result : InResults)
+	{
+		Json->WriteObjectStart();
+		Json->WriteValue(TEXT("symbol"), Result.Symbol);
+		SerializeBlueprints(Json, Result.Blueprints);
+		SerializeMetadata(Json, Result.CandidateCount);
+		Json->WriteObjectEnd();
+	}
+
+	Json->WriteArrayEnd();
+
+	Json->WriteObjectEnd();
+	Json->Close();
+}
 } // namespace VisualStudioTools
 
 static constexpr auto SymbolParamVal = TEXT("symbol");
+static constexpr auto SymbolsFileParamVal = TEXT("symbols");
+static constexpr auto IndexParamVal = TEXT("index");
+static constexpr auto NoIndexSwitch = TEXT("noindex");
 
 UVsBlueprintReferencesCommandlet::UVsBlueprintReferencesCommandlet()
 	: Super()
@@ -191,7 +298,16 @@ UVsBlueprintReferencesCommandlet::UVsBlueprintReferencesCommandlet()
 	HelpParamNames.Add(SymbolParamVal);
 	HelpParamDescriptions.Add(TEXT("[Optional] Fully qualified symbol to search for in the blueprints."));
 
-	HelpUsage = TEXT("<Editor-Cmd.exe> <path_to_uproject> -run=VsBlueprintReferences -output=<path_to_output_file> -symbol=<ClassName::FunctionName> [-unattended -noshadercompile -nosound -nullrhi -nocpuprofilertrace -nocrashreports -nosplash]");
+	HelpParamNames.Add(SymbolsFileParamVal);
+	HelpParamDescriptions.Add(TEXT("[Optional] Path to a file with one fully qualified symbol per line, to search for all of them in a single run. The output lists the results by symbol. Incompatible with `-symbol`."));
+
+	HelpParamNames.Add(IndexParamVal);
+	HelpParamDescriptions.Add(TEXT("[Optional] The file path of the reverse index mapping native functions to the blueprints calling them. Defaults to `<ProjectIntermediateDir>/VisualStudioTools/BlueprintReferencesIndex.json`."));
+
+	HelpParamNames.Add(NoIndexSwitch);
+	HelpParamDescriptions.Add(TEXT("[Optional] Search with FindInBlueprints and load the candidate blueprints, instead of using the reverse index. Incompatible with `-index`."));
+
+	HelpUsage = TEXT("<Editor-Cmd.exe> <path_to_uproject> -run=VsBlueprintReferences -output=<path_to_output_file> -symbol=<ClassName::FunctionName>|-symbols=<path_to_symbols_file> [-index=<path_to_index_file>|-noindex] [-unattended -noshadercompile -nosound -nullrhi -nocpuprofilertrace -nocrashreports -nosplash]");
 }
 
 int32 UVsBlueprintReferencesCommandlet::Run(
@@ -204,45 +320,103 @@ int32 UVsBlueprintReferencesCommandlet::Run(
 	GIsRunning = true; // Required for the blueprint search to work.
 
 	FString* ReferencesSymbol = ParamVals.Find(SymbolParamVal);
-	if (ReferencesSymbol->IsEmpty())
+	FString* SymbolsFile = ParamVals.Find(SymbolsFileParamVal);
+	if (ReferencesSymbol != nullptr && SymbolsFile != nullptr)
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Incompatible symbol options."));
+		PrintHelp();
+		return -1;
+	}
+
+	TArray<FString> Symbols;
+	if (SymbolsFile != nullptr)
+	{
+		if (!FFileHelper::LoadFileToStringArray(Symbols, **SymbolsFile))
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to read the symbols file: %s"), **SymbolsFile);
+			return -1;
+		}
+
+		for (FString& Symbol : Symbols)
+		{
+			Symbol.TrimStartAndEndInline();
+		}
+		Symbols.RemoveAll([](const FString& Symbol) { return Symbol.IsEmpty(); });
+	}
+	else if (ReferencesSymbol != nullptr && !ReferencesSymbol->IsEmpty())
+	{
+		Symbols.Add(*ReferencesSymbol);
+	}
+	else
 	{
 		UE_LOG(LogVisualStudioTools, Error, TEXT("Missing required symbol parameter."));
 		PrintHelp();
 		return -1;
 	}
 
-	FString FunctionName;
-	FString ClassNameNative;
-	if (!ReferencesSymbol->Split(TEXT("::"), &ClassNameNative, &FunctionName))
+	TArray<FSymbolReferences> Results;
+	for (const FString& Symbol : Symbols)
+	{
+		FString FunctionName;
+		FString ClassNameWithoutPrefix;
+		if (!ParseSymbol(Symbol, ClassNameWithoutPrefix, FunctionName))
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Reference parameter should be in the qualified 'NativeClassName::MethodName' format. Symbol: %s"), *Symbol);
+			PrintHelp();
+			return -1;
+		}
+
+		Results.AddDefaulted_GetRef().Symbol = Symbol;
+	}
+
+	FString* IndexPath = ParamVals.Find(IndexParamVal);
+	const bool bNoIndex = Switches.Contains(NoIndexSwitch);
+	if (IndexPath != nullptr && bNoIndex)
 	{
-		UE_LOG(LogVisualStudioTools, Error, TEXT("Reference parameter should be in the qualified 'NativeClassName::MethodName' format."));
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Incompatible index options."));
 		PrintHelp();
 		return -1;
 	}
 
-	// Execute the search in two stages:
-	// 1. Use FindInBlueprints to get all candidate blueprints with calls to functions that match the requested symbol
-	// 2. Confirm the blueprints reference the requested function, by matching the target UFunction in their call graph.
-	// The first step acts as a filter to avoid loading too many blueprints to inspect their call graph.
-	// The second step is required because the FiB data does not always allow for searching with the function
-	// qualified with the owned class name, if the function is static.
+	if (bNoIndex)
+	{
+		for (FSymbolReferences& Result : Results)
+		{
+			FindReferencesWithSearch(Result);
+		}
+	}
+	else
+	{
+		// Loading every blueprint is only needed to build the index, later runs reload just the changed ones.
+		const FString IndexFilePath = IndexPath != nullptr
+			? *IndexPath
+			: FPaths::Combine(FPaths::ProjectIntermediateDir(), TEXT("VisualStudioTools"), TEXT("BlueprintReferencesIndex.json"));
 
-	FString ClassNameWithoutPrefix = StripClassPrefix(ClassNameNative);
-	
-	// Create a FiB search query for function nodes where the native name matches the requested symbol
-	FString SearchValue = FString::Printf(TEXT("Nodes(\"Native Name\"=+%s & ClassName=K2Node_CallFunction)"), *FunctionName);
-	
-	UE_LOG(LogVisualStudioTools, Display, TEXT("Blueprint search query: %s"), *SearchValue);
+		FBlueprintReferencesIndex ReferencesIndex;
+		ReferencesIndex.Load(IndexFilePath);
+		ReferencesIndex.Update();
+		ReferencesIndex.Save(IndexFilePath);
 
-	// Step 1: Execute the Fib search
-	TArray<FAssetData> TargetAssets = SearchForCandidateAssets(SearchValue);
-	
-	// Step 2: Load the assets to confirm they are a match
-	TMap<FString, FAssetData> MatchAssets = GetConfirmedAssets(FunctionName, ClassNameWithoutPrefix, TargetAssets);
+		for (FSymbolReferences& Result : Results)
+		{
+			FindReferencesWithIndex(ReferencesIndex, Result);
+		}
+	}
 
 	// Finally, write the results back to the output
-	SerializeResults(MatchAssets, OutArchive, TargetAssets.Num());
+	if (SymbolsFile != nullptr)
+	{
+		SerializeBatchResults(Results, OutArchive);
+	}
+	else
+	{
+		SerializeResults(Results[0].Blueprints, OutArchive, Results[0].CandidateCount);
+	}
+
+	for (const FSymbolReferences& Result : Results)
+	{
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Found %d blueprints for %s."), Result.Blueprints.Num(), *Result.Symbol);
+	}
 
-	UE_LOG(LogVisualStudioTools, Display, TEXT("Found %d blueprints."), MatchAssets.Num());
 	return 0;
 }
\ No newline at end of file
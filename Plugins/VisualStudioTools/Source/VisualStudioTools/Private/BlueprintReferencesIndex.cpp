@@ -0,0 +1,229 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+// Licensed under the MIT License.
+
+#include "BlueprintReferencesIndex.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "BlueprintAssetHelpers.h"
+#include "Dom/JsonObject.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "VisualStudioTools.h"
+
+namespace VisualStudioTools
+{
+// Bump when the indexed data or the way it's computed changes.
+static constexpr int32 IndexVersion = 1;
+
+static FString MakeSymbol(const FString& ClassNameWithoutPrefix, const FString& FunctionName)
+{
+	return ClassNameWithoutPrefix + TEXT("::") + FunctionName;
+}
+
+bool FBlueprintReferencesIndex::Load(const FString& InFilePath)
+{
+	Entries.Reset();
+	Symbols.Reset();
+
+	FString Contents;
+	if (!FFileHelper::LoadFileToString(Contents, *InFilePath))
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Contents);
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+	{
+		UE_LOG(LogVisualStudioTools, Warning, TEXT("Failed to parse the blueprint references index, it will be rebuilt. Path: %s"), *InFilePath);
+		return false;
+	}
+
+	if (Root->GetIntegerField(TEXT("version")) != IndexVersion
+		|| Root->GetStringField(TEXT("engine")) != FEngineVersion::Current().ToString())
+	{
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Blueprint references index is out of date, it will be rebuilt."));
+		return false;
+	}
+
+	for (const TSharedPtr<FJsonValue>& EntryValue : Root->GetArrayField(TEXT("entries")))
+	{
+		const TSharedPtr<FJsonObject>& EntryObject = EntryValue->AsObject();
+
+		FEntry Entry;
+		Entry.PackageKey = EntryObject->GetStringField(TEXT("key"));
+		Entry.BlueprintName = EntryObject->GetStringField(TEXT("name"));
+
+		for (const TSharedPtr<FJsonValue>& CallValue : EntryObject->GetArrayField(TEXT("calls")))
+		{
+			Entry.CalledFunctions.Add(CallValue->AsString());
+		}
+
+		Entries.Add(EntryObject->GetStringField(TEXT("package")), MoveTemp(Entry));
+	}
+
+	RebuildSymbols();
+	return true;
+}
+
+bool FBlueprintReferencesIndex::Save(const FString& InFilePath) const
+{
+	TArray<TSharedPtr<FJsonValue>> EntryValues;
+	EntryValues.Reserve(Entries.Num());
+
+	for (const auto& Item : Entries)
+	{
+		const FEntry& Entry = Item.Value;
+
+		TSharedRef<FJsonObject> EntryObject = MakeShared<FJsonObject>();
+		EntryObject->SetStringField(TEXT("package"), Item.Key);
+		EntryObject->SetStringField(TEXT("key"), Entry.PackageKey);
+		EntryObject->SetStringField(TEXT("name"), Entry.BlueprintName);
+
+		TArray<TSharedPtr<FJsonValue>> CallValues;
+		for (const FString& Call : Entry.CalledFunctions)
+		{
+			CallValues.Add(MakeShared<FJsonValueString>(Call));
+		}
+		EntryObject->SetArrayField(TEXT("calls"), CallValues);
+
+		EntryValues.Add(MakeShared<FJsonValueObject>(EntryObject));
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("version"), IndexVersion);
+	Root->SetStringField(TEXT("engine"), FEngineVersion::Current().ToString());
+	Root->SetArrayField(TEXT("entries"), EntryValues);
+
+	FString Contents;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Contents);
+	if (!FJsonSerializer::Serialize(Root, Writer))
+	{
+		return false;
+	}
+
+	if (!FFileHelper::SaveStringToFile(Contents, *InFilePath))
+	{
+		UE_LOG(LogVisualStudioTools, Warning, TEXT("Failed to write the blueprint references index. Path: %s"), *InFilePath);
+		return false;
+	}
+
+	return true;
+}
+
+void FBlueprintReferencesIndex::Update()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	FARFilter Filter;
+	Filter.bRecursiveClasses = true;
+	AssetHelpers::SetBlueprintClassFilter(Filter);
+
+	TArray<FAssetData> BlueprintAssets;
+	AssetRegistry.GetAssets(Filter, BlueprintAssets);
+
+	// Compare the packages in the registry against the indexed ones, and collect the ones that need to be reloaded.
+	TMap<FString, FString> PackageKeys;
+	TArray<FAssetData> DirtyAssets;
+	for (const FAssetData& AssetData : BlueprintAssets)
+	{
+		const FString PackageName = AssetData.PackageName.ToString();
+		const FString PackageKey = AssetHelpers::GetPackageFileKey(PackageName);
+		PackageKeys.Add(PackageName, PackageKey);
+
+		const FEntry* Entry = Entries.Find(PackageName);
+		if (Entry == nullptr || PackageKey.IsEmpty() || Entry->PackageKey != PackageKey)
+		{
+			DirtyAssets.Add(AssetData);
+		}
+	}
+
+	// Drop the blueprints that were deleted or are no longer blueprints.
+	const int32 NumEntries = Entries.Num();
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (!PackageKeys.Contains(It.Key()))
+		{
+			It.RemoveCurrent();
+		}
+	}
+	const int32 NumRemoved = NumEntries - Entries.Num();
+
+	TSet<FName> ReloadedPackages;
+	ReloadedPackages.Reserve(DirtyAssets.Num());
+
+	AssetHelpers::ForEachAsset(DirtyAssets,
+		[&](UBlueprintGeneratedClass* BlueprintGeneratedClass, const FAssetData& AssetData)
+		{
+			ReloadedPackages.Add(AssetData.PackageName);
+
+			const FString PackageName = AssetData.PackageName.ToString();
+
+			FEntry& Entry = Entries.FindOrAdd(PackageName);
+			Entry.PackageKey = PackageKeys[PackageName];
+			Entry.BlueprintName = BlueprintGeneratedClass->GetName();
+			Entry.CalledFunctions.Reset();
+
+			for (const UFunction* Fn : BlueprintGeneratedClass->CalledFunctions)
+			{
+				if (Fn != nullptr && Fn->HasAnyFunctionFlags(EFunctionFlags::FUNC_Native))
+				{
+					Entry.CalledFunctions.AddUnique(MakeSymbol(Fn->GetOwnerClass()->GetName(), Fn->GetName()));
+				}
+			}
+		});
+
+	// The callback only runs for the blueprints that loaded. Drop the entries of the ones that failed,
+	// so their old data doesn't keep answering queries. They are dirty again on the next update.
+	int32 NumFailed = 0;
+	for (const FAssetData& AssetData : DirtyAssets)
+	{
+		if (!ReloadedPackages.Contains(AssetData.PackageName))
+		{
+			Entries.Remove(AssetData.PackageName.ToString());
+			++NumFailed;
+		}
+	}
+
+	RebuildSymbols();
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Updated blueprint references index in %.2fs: %d blueprints, %d reloaded, %d failed to load, %d removed."),
+		FPlatformTime::Seconds() - StartTime,
+		Entries.Num(),
+		DirtyAssets.Num() - NumFailed,
+		NumFailed,
+		NumRemoved);
+}
+
+const TArray<FString>* FBlueprintReferencesIndex::FindCallers(const FString& ClassNameWithoutPrefix, const FString& FunctionName) const
+{
+	return Symbols.Find(MakeSymbol(ClassNameWithoutPrefix, FunctionName));
+}
+
+const FString& FBlueprintReferencesIndex::GetBlueprintName(const FString& PackageName) const
+{
+	return Entries.FindChecked(PackageName).BlueprintName;
+}
+
+void FBlueprintReferencesIndex::RebuildSymbols()
+{
+	Symbols.Reset();
+	for (const auto& Item : Entries)
+	{
+		for (const FString& Call : Item.Value.CalledFunctions)
+		{
+			Symbols.FindOrAdd(Call).Add(Item.Key);
+		}
+	}
+}
+
+} // namespace VisualStudioTools
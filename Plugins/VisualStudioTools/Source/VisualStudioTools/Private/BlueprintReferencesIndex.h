@@ -0,0 +1,54 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace VisualStudioTools
+{
+/**
+* Persistent reverse index from native functions to the blueprints calling them.
+* Built by loading every blueprint once, then updated by reloading only the blueprints
+* whose package changed on disk since the last update.
+*/
+class FBlueprintReferencesIndex
+{
+public:
+	/** Loads the index file. Returns false, leaving the index empty, if it's missing or incompatible. */
+	bool Load(const FString& InFilePath);
+
+	/** Writes the index file. */
+	bool Save(const FString& InFilePath) const;
+
+	/** Brings the index up to date with the asset registry, loading only new and changed blueprints. */
+	void Update();
+
+	/**
+	* Returns the package names of the blueprints calling the native function, or null if there are none.
+	* The class name is expected without its prefix, e.g. `Actor::GetActorLocation`.
+	*/
+	const TArray<FString>* FindCallers(const FString& ClassNameWithoutPrefix, const FString& FunctionName) const;
+
+	/** Returns the name of the blueprint generated class in the package. */
+	const FString& GetBlueprintName(const FString& PackageName) const;
+
+private:
+	struct FEntry
+	{
+		FString PackageKey;
+		FString BlueprintName;
+
+		/** Native functions called by the blueprint, as `ClassName::FunctionName`. */
+		TArray<FString> CalledFunctions;
+	};
+
+	void RebuildSymbols();
+
+	TMap<FString, FEntry> Entries;
+
+	/** Package names of the callers by symbol, rebuilt from the entries. */
+	TMap<FString, TArray<FString>> Symbols;
+};
+
+} // namespace VisualStudioTools
@@ -0,0 +1,193 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+// Licensed under the MIT License.
+
+#include "TestManifest.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "VisualStudioTools.h"
+
+namespace VisualStudioTools
+{
+namespace TestManifest
+{
+// Bump when the manifest layout or the way its keys are computed changes.
+static constexpr int32 ManifestVersion = 2;
+
+FString GetDefaultFilePath()
+{
+	return FPaths::Combine(FPaths::ProjectIntermediateDir(), TEXT("VisualStudioTools"), TEXT("TestManifest.json"));
+}
+
+FString GetModulesKey()
+{
+	TArray<FModuleStatus> Modules;
+	FModuleManager::Get().QueryModules(Modules);
+
+	TArray<FString> Binaries;
+	Binaries.Add(FPlatformProcess::ExecutablePath());
+	for (const FModuleStatus& Module : Modules)
+	{
+		if (Module.bIsLoaded && !Module.FilePath.IsEmpty())
+		{
+			Binaries.Add(Module.FilePath);
+		}
+	}
+
+	// Sort them so the key doesn't depend on the loading order.
+	Binaries.Sort();
+
+	FString KeySource = FString::Printf(TEXT("%s|%llu"), *FEngineVersion::Current().ToString(),
+		static_cast<uint64>(FAutomationTestFramework::GetInstance().GetRequestedTestFilter()));
+	for (const FString& Binary : Binaries)
+	{
+		FFileStatData StatData = IFileManager::Get().GetStatData(*Binary);
+		KeySource += FString::Printf(TEXT("|%s|%lld|%lld"), *Binary, StatData.ModificationTime.GetTicks(), StatData.FileSize);
+	}
+
+	return FString::Printf(TEXT("%u-%d"), FCrc::StrCrc32(*KeySource), Binaries.Num());
+}
+
+FString GetContentKey()
+{
+#if ENGINE_MAJOR_VERSION > 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1)
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	// Combine the packages with XOR, so the key doesn't depend on the enumeration order.
+	// FName hashes aren't stable across runs, so the package names are hashed as strings.
+	uint32 Crc = 0;
+	int32 NumPackages = 0;
+	AssetRegistry.EnumerateAllPackages([&Crc, &NumPackages](FName PackageName, const FAssetPackageData& PackageData)
+		{
+			const FIoHash& SavedHash = PackageData.GetPackageSavedHash();
+			Crc ^= FCrc::MemCrc32(&SavedHash, sizeof(SavedHash), FCrc::StrCrc32(*PackageName.ToString()));
+			++NumPackages;
+		});
+
+	return FString::Printf(TEXT("%u-%d"), Crc, NumPackages);
+#else
+	return FString();
+#endif
+}
+
+bool ConvertTests(const TArray<FAutomationTestInfo>& TestInfos, TArray<FTestEntry>& OutTests)
+{
+	bool bHasComplexTests = false;
+
+	OutTests.Reserve(OutTests.Num() + TestInfos.Num());
+	for (const FAutomationTestInfo& TestInfo : TestInfos)
+	{
+		FTestEntry& Test = OutTests.AddDefaulted_GetRef();
+		Test.TestCommand = TestInfo.GetTestName();
+		Test.DisplayName = TestInfo.GetDisplayName();
+		Test.SourceFile = TestInfo.GetSourceFile();
+		Test.Line = TestInfo.GetSourceFileLine();
+
+		// Complex tests pass the case to run as the test parameter.
+		bHasComplexTests |= !TestInfo.GetTestParameter().IsEmpty();
+	}
+
+	return bHasComplexTests;
+}
+
+bool Load(const FString& InFilePath, const FString& ModulesKey, TArray<FTestEntry>& OutTests)
+{
+	OutTests.Reset();
+
+	FString Contents;
+	if (!FFileHelper::LoadFileToString(Contents, *InFilePath))
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Contents);
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+	{
+		return false;
+	}
+
+	int32 Version = 0;
+	FString ManifestKey;
+	const TArray<TSharedPtr<FJsonValue>>* TestValues = nullptr;
+	if (!Root->TryGetNumberField(TEXT("version"), Version) || Version != ManifestVersion ||
+		!Root->TryGetStringField(TEXT("key"), ManifestKey) || ManifestKey != ModulesKey ||
+		!Root->TryGetArrayField(TEXT("tests"), TestValues))
+	{
+		return false;
+	}
+
+	// Only lists with complex tests are saved with a content key, so simple lists don't pay for the asset registry scan.
+	FString ContentKey;
+	if (Root->TryGetStringField(TEXT("contentKey"), ContentKey) && ContentKey != GetContentKey())
+	{
+		return false;
+	}
+
+	OutTests.Reserve(TestValues->Num());
+	for (const TSharedPtr<FJsonValue>& TestValue : *TestValues)
+	{
+		const TSharedPtr<FJsonObject>& TestObject = TestValue->AsObject();
+		if (!TestObject.IsValid())
+		{
+			OutTests.Reset();
+			return false;
+		}
+
+		FTestEntry& Test = OutTests.AddDefaulted_GetRef();
+		Test.TestCommand = TestObject->GetStringField(TEXT("test"));
+		Test.DisplayName = TestObject->GetStringField(TEXT("displayName"));
+		Test.SourceFile = TestObject->GetStringField(TEXT("sourceFile"));
+		Test.Line = static_cast<int32>(TestObject->GetNumberField(TEXT("line")));
+	}
+
+	return true;
+}
+
+bool Save(const FString& InFilePath, const FString& ModulesKey, const FString& ContentKey, const TArray<FTestEntry>& Tests)
+{
+	TArray<TSharedPtr<FJsonValue>> TestValues;
+	TestValues.Reserve(Tests.Num());
+	for (const FTestEntry& Test : Tests)
+	{
+		TSharedRef<FJsonObject> TestObject = MakeShared<FJsonObject>();
+		TestObject->SetStringField(TEXT("test"), Test.TestCommand);
+		TestObject->SetStringField(TEXT("displayName"), Test.DisplayName);
+		TestObject->SetStringField(TEXT("sourceFile"), Test.SourceFile);
+		TestObject->SetNumberField(TEXT("line"), Test.Line);
+		TestValues.Add(MakeShared<FJsonValueObject>(TestObject));
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("version"), ManifestVersion);
+	Root->SetStringField(TEXT("key"), ModulesKey);
+	if (!ContentKey.IsEmpty())
+	{
+		Root->SetStringField(TEXT("contentKey"), ContentKey);
+	}
+	Root->SetArrayField(TEXT("tests"), TestValues);
+
+	FString Contents;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Contents);
+	if (!FJsonSerializer::Serialize(Root, Writer) || !FFileHelper::SaveStringToFile(Contents, *InFilePath))
+	{
+		UE_LOG(LogVisualStudioTools, Warning, TEXT("Failed to save the test manifest to path: %s"), *InFilePath);
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace TestManifest
+} // namespace VisualStudioTools
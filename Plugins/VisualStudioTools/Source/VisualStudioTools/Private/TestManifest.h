@@ -0,0 +1,56 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+namespace VisualStudioTools
+{
+/**
+* A discovered test, with the data of FAutomationTestInfo used by the test adapter.
+*/
+struct FTestEntry
+{
+	FString TestCommand;
+	FString DisplayName;
+	FString SourceFile;
+	int32 Line = 0;
+};
+
+/**
+* Cache of the discovered tests, so the test adapter doesn't have to ask the automation framework to enumerate them every run.
+*/
+namespace TestManifest
+{
+/** Returns the path of the manifest in the project intermediate directory. */
+FString GetDefaultFilePath();
+
+/**
+* Returns the key of the loaded module binaries, the engine version and the test filter.
+* Tests are registered by the modules when they are loaded, so simple tests only change when that key changes.
+*/
+FString GetModulesKey();
+
+/**
+* Returns the key of the asset registry state, built from the saved hash of every package.
+* Complex tests usually enumerate their cases from the assets, so lists with complex tests are also keyed on it.
+* Returns an empty string if the engine doesn't expose the package hashes.
+*/
+FString GetContentKey();
+
+/** Converts the tests returned by the automation framework. Returns true if any of them is a complex test. */
+bool ConvertTests(const TArray<FAutomationTestInfo>& TestInfos, TArray<FTestEntry>& OutTests);
+
+/**
+* Loads the manifest. Returns false, leaving the list empty, if it's missing, incompatible or the modules key differs,
+* or if it was saved with a content key that differs from the current one.
+*/
+bool Load(const FString& InFilePath, const FString& ModulesKey, TArray<FTestEntry>& OutTests);
+
+/** Writes the manifest. An empty content key saves a list that is only validated against the modules key. */
+bool Save(const FString& InFilePath, const FString& ModulesKey, const FString& ContentKey, const TArray<FTestEntry>& Tests);
+
+} // namespace TestManifest
+} // namespace VisualStudioTools
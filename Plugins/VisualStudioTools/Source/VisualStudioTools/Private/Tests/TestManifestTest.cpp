@@ -0,0 +1,168 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+// Licensed under the MIT License.
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include "TestManifest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace TestManifestTest
+{
+// The test flags became an enum class in UE 5.5.
+#if ENGINE_MAJOR_VERSION > 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 5)
+using FTestFlags = EAutomationTestFlags;
+constexpr FTestFlags BenchmarkFlags = EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter;
+#else
+using FTestFlags = uint32;
+constexpr FTestFlags BenchmarkFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter;
+#endif
+
+/** Number of synthetic tests registered for the benchmark. */
+constexpr int32 NumSyntheticTests = 10000;
+
+/** Prefix of the synthetic test names. */
+const TCHAR* SyntheticTestPrefix = TEXT("VisualStudioTools.TestAdapter.Synthetic.");
+
+/**
+* Empty test registered with the automation framework, so discovery has to enumerate it like a real test.
+* Tests unregister themselves when destroyed.
+*/
+class FSyntheticTest : public FAutomationTestBase
+{
+public:
+	FSyntheticTest(const FString& InName)
+		: FAutomationTestBase(InName, false)
+	{
+	}
+
+	virtual FTestFlags GetTestFlags() const override
+	{
+		// Same flags as the benchmark, so the synthetic tests pass the filter that lets the benchmark run.
+		return BenchmarkFlags;
+	}
+
+	virtual uint32 GetRequiredDeviceNum() const override
+	{
+		return 1;
+	}
+
+	virtual FString GetTestSourceFileName() const override
+	{
+		return __FILE__;
+	}
+
+	virtual int32 GetTestSourceFileLine() const override
+	{
+		return __LINE__;
+	}
+
+protected:
+	virtual void GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const override
+	{
+		OutBeautifiedNames.Add(GetBeautifiedTestName());
+		OutTestCommands.Add(FString());
+	}
+
+	virtual bool RunTest(const FString& Parameters) override
+	{
+		return true;
+	}
+
+	virtual FString GetBeautifiedTestName() const override
+	{
+		return TestName;
+	}
+};
+
+/** Returns true if both lists hold the same tests in the same order. */
+bool AreSameTests(const TArray<VisualStudioTools::FTestEntry>& A, const TArray<VisualStudioTools::FTestEntry>& B)
+{
+	if (A.Num() != B.Num())
+	{
+		return false;
+	}
+
+	for (int32 Idx = 0; Idx < A.Num(); ++Idx)
+	{
+		if (A[Idx].TestCommand != B[Idx].TestCommand || A[Idx].DisplayName != B[Idx].DisplayName ||
+			A[Idx].SourceFile != B[Idx].SourceFile || A[Idx].Line != B[Idx].Line)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+} // namespace TestManifestTest
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestManifestBenchmarkTest, "VisualStudioTools.TestAdapter.ManifestBenchmark", TestManifestTest::BenchmarkFlags)
+
+bool FTestManifestBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace TestManifestTest;
+	using namespace VisualStudioTools;
+
+	TArray<TUniquePtr<FSyntheticTest>> SyntheticTests;
+	SyntheticTests.Reserve(NumSyntheticTests);
+	for (int32 Idx = 0; Idx < NumSyntheticTests; ++Idx)
+	{
+		SyntheticTests.Add(MakeUnique<FSyntheticTest>(FString::Printf(TEXT("%sTest%05d"), SyntheticTestPrefix, Idx)));
+	}
+
+	const FString ManifestFile = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("TestManifestBenchmark.json"));
+
+	// Discovery without a manifest: enumerate the registered tests.
+	double StartTime = FPlatformTime::Seconds();
+
+	TArray<FAutomationTestInfo> TestInfos;
+	FAutomationTestFramework::GetInstance().GetValidTestNames(TestInfos);
+
+	TArray<FTestEntry> DiscoveredTests;
+	TestManifest::ConvertTests(TestInfos, DiscoveredTests);
+
+	const double DiscoveryTime = FPlatformTime::Seconds() - StartTime;
+
+	const int32 NumDiscoveredSynthetic = DiscoveredTests.FilterByPredicate([](const FTestEntry& Test)
+		{
+			return Test.TestCommand.StartsWith(SyntheticTestPrefix);
+		}).Num();
+
+	TestEqual(TEXT("Discovery found every synthetic test"), NumDiscoveredSynthetic, NumSyntheticTests);
+
+	StartTime = FPlatformTime::Seconds();
+
+	const FString ModulesKey = TestManifest::GetModulesKey();
+	TestTrue(TEXT("The manifest was saved"), TestManifest::Save(ManifestFile, ModulesKey, FString(), DiscoveredTests));
+
+	const double SaveTime = FPlatformTime::Seconds() - StartTime;
+
+	// Discovery with a manifest: key the modules and read the list back, like the commandlet does.
+	StartTime = FPlatformTime::Seconds();
+
+	TArray<FTestEntry> CachedTests;
+	const bool bLoaded = TestManifest::Load(ManifestFile, TestManifest::GetModulesKey(), CachedTests);
+
+	const double LoadTime = FPlatformTime::Seconds() - StartTime;
+
+	TestTrue(TEXT("The manifest was loaded"), bLoaded);
+	TestTrue(TEXT("The manifest holds the discovered tests"), AreSameTests(CachedTests, DiscoveredTests));
+
+	AddInfo(FString::Printf(TEXT("%d tests (%d synthetic): discovery took %.2f ms, saving the manifest %.2f ms, loading it %.2f ms."),
+		DiscoveredTests.Num(), NumSyntheticTests, DiscoveryTime * 1000.0, SaveTime * 1000.0, LoadTime * 1000.0));
+
+	// A list saved with a content key that no longer matches the assets must be discovered again.
+	TestManifest::Save(ManifestFile, ModulesKey, TEXT("0-0"), DiscoveredTests);
+	TestFalse(TEXT("A manifest with a stale content key is not loaded"), TestManifest::Load(ManifestFile, ModulesKey, CachedTests));
+
+	TestFalse(TEXT("A manifest with a stale modules key is not loaded"), TestManifest::Load(ManifestFile, ModulesKey + TEXT("-stale"), CachedTests));
+
+	IFileManager::Get().Delete(*ManifestFile);
+
+	return true;
+}
+
+#endif
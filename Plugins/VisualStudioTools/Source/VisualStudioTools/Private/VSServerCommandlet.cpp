@@ -1,45 +1,382 @@
 // Copyright 2022 (c) Microsoft. All rights reserved.
 
 #include "VSServerCommandlet.h"
+#include "BlueprintReferencesCommandlet.h"
+#include "VisualStudioToolsCommandlet.h"
 #include "VSTestAdapterCommandlet.h"
 
+#if PLATFORM_WINDOWS
 #include "Windows/AllowWindowsPlatformTypes.h"
+#endif
 
+#include "Async/Async.h"
+#include "Common/TcpSocketBuilder.h"
 #include "HAL/PlatformNamedPipe.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
 #include "Runtime/Core/Public/Async/TaskGraphInterfaces.h"
 #include "Runtime/Core/Public/Containers/Ticker.h"
 #include "Runtime/Engine/Classes/Engine/World.h"
 #include "Runtime/Engine/Public/TimerManager.h"
 #include "Runtime/Launch/Resources/Version.h"
-#include "Runtime\CoreUObject\Public\UObject\UObjectGlobals.h"
+#include "Runtime/CoreUObject/Public/UObject/UObjectGlobals.h"
+#include "UObject/StrongObjectPtr.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
 #include <chrono>
 #include <codecvt>
 #include <fstream>
 #include <string>
 #include <thread>
+
+#if PLATFORM_WINDOWS
 #include <windows.h>
 
 #include "Windows/HideWindowsPlatformTypes.h"
+#endif
 
 #include "VisualStudioTools.h"
 
 static constexpr auto NamedPipeParam = TEXT("NamedPipe");
 static constexpr auto KillServerParam = TEXT("KillVSServer");
+static constexpr auto PortParam = TEXT("Port");
+static constexpr auto PortFileParam = TEXT("PortFile");
+static constexpr auto LatencyBenchmarkParam = TEXT("LatencyBenchmark");
+
+static constexpr auto PingRequest = TEXT("Ping");
+
+// Number of timed runs of each commandlet request in the latency benchmark, after an untimed warm-up run.
+static constexpr int32 CommandletBenchmarkCount = 5;
+
+// Upper bound for a single message, to reject corrupted length prefixes.
+static constexpr uint32 MaxMessageSize = 16 * 1024 * 1024;
 
 UVSServerCommandlet::UVSServerCommandlet()
 {
 	HelpDescription = TEXT("Commandlet for Unreal Engine server mode.");
-	HelpUsage = TEXT("<Editor-Cmd.exe> <path_to_uproject> -run=VSServer [-stdout -multiprocess -silent -unattended -AllowStdOutLogVerbosity -NoShaderCompile]");
+	HelpUsage = TEXT("<Editor-Cmd.exe> <path_to_uproject> -run=VSServer -NamedPipe=<pipe_name>|-Port=<port> [-PortFile=<path_to_port_file>] [-LatencyBenchmark=<count>] [-stdout -multiprocess -silent -unattended -AllowStdOutLogVerbosity -NoShaderCompile]");
 
 	HelpParamNames.Add(NamedPipeParam);
-	HelpParamDescriptions.Add(TEXT("[Required] The name of the named pipe used to communicate with Visual Studio."));
+	HelpParamDescriptions.Add(TEXT("[Optional] The name of the named pipe used to communicate with Visual Studio. Windows only. Incompatible with `-Port`."));
+
+	HelpParamNames.Add(PortParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Serve requests on this loopback TCP port instead of a named pipe. Use 0 to pick a free port. Each message is a little-endian uint32 byte length followed by UTF-8 text, and a connection can send any number of requests. A request is the commandlet name (`VisualStudioTools`, `VsBlueprintReferences`, `VSTestAdapter`, `Ping` or `KillVSServer`) followed by its parameters, and the response is the commandlet result code."));
+
+	HelpParamNames.Add(PortFileParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] File path to write the bound port to, once the server is listening."));
+
+	HelpParamNames.Add(LatencyBenchmarkParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Send this many `Ping` requests from a local client thread and log their round-trip latency. Then time warm index, blueprint references and test adapter requests the same way, and quit. Requires `-Port`."));
 
 	HelpParamNames.Add(KillServerParam);
 	HelpParamDescriptions.Add(TEXT("[Optional] Quit the server mode commandlet immediately."));
 }
 
+/**
+* Runs the commandlet named by the first token of the request, with the rest of the request as its parameters.
+* Returns the commandlet result, or 1 if the request doesn't name a known commandlet.
+*/
+static int32 RunRequest(const FString& Request)
+{
+	FString Command = Request;
+	FString Params;
+	Request.TrimStart().Split(TEXT(" "), &Command, &Params);
+	Command.TrimStartAndEndInline();
+
+	// Nothing else references the commandlet, and its Main can collect garbage (latent tests, the index memory ceiling),
+	// so keep it alive until it returns.
+	TStrongObjectPtr<UCommandlet> Commandlet;
+	if (Command.Equals(TEXT("VSTestAdapter"), ESearchCase::IgnoreCase))
+	{
+		Commandlet.Reset(NewObject<UVSTestAdapterCommandlet>());
+	}
+	else if (Command.Equals(TEXT("VsBlueprintReferences"), ESearchCase::IgnoreCase))
+	{
+		Commandlet.Reset(NewObject<UVsBlueprintReferencesCommandlet>());
+	}
+	else if (Command.Equals(TEXT("VisualStudioTools"), ESearchCase::IgnoreCase))
+	{
+		Commandlet.Reset(NewObject<UVisualStudioToolsCommandlet>());
+	}
+	else if (Command.Equals(PingRequest, ESearchCase::IgnoreCase))
+	{
+		return 0;
+	}
+	else
+	{
+		return 1;
+	}
+
+	return Commandlet->Main(Params);
+}
+
+static bool SendAll(FSocket& Socket, const uint8* Data, int32 Size)
+{
+	while (Size > 0)
+	{
+		int32 BytesSent = 0;
+		if (!Socket.Send(Data, Size, BytesSent) || BytesSent <= 0)
+		{
+			return false;
+		}
+
+		Data += BytesSent;
+		Size -= BytesSent;
+	}
+
+	return true;
+}
+
+static bool ReceiveAll(FSocket& Socket, uint8* Data, int32 Size)
+{
+	while (Size > 0)
+	{
+		int32 BytesRead = 0;
+		if (!Socket.Recv(Data, Size, BytesRead) || BytesRead <= 0)
+		{
+			return false;
+		}
+
+		Data += BytesRead;
+		Size -= BytesRead;
+	}
+
+	return true;
+}
+
+static bool SendMessage(FSocket& Socket, const FString& Message)
+{
+	FTCHARToUTF8 Utf8Message(*Message);
+	const uint32 Length = static_cast<uint32>(Utf8Message.Length());
+
+	const uint8 Header[4] = {
+		static_cast<uint8>(Length),
+		static_cast<uint8>(Length >> 8),
+		static_cast<uint8>(Length >> 16),
+		static_cast<uint8>(Length >> 24) };
+
+	return SendAll(Socket, Header, sizeof(Header))
+		&& SendAll(Socket, reinterpret_cast<const uint8*>(Utf8Message.Get()), Utf8Message.Length());
+}
+
+static bool ReceiveMessage(FSocket& Socket, FString& OutMessage)
+{
+	uint8 Header[4];
+	if (!ReceiveAll(Socket, Header, sizeof(Header)))
+	{
+		return false;
+	}
+
+	const uint32 Length = Header[0] | (Header[1] << 8) | (Header[2] << 16) | (uint32(Header[3]) << 24);
+	if (Length > MaxMessageSize)
+	{
+		UE_LOG(LogVisualStudioTools, Warning, TEXT("Rejecting a message of %u bytes, the limit is %u bytes."), Length, MaxMessageSize);
+		return false;
+	}
+
+	TArray<uint8> Payload;
+	Payload.SetNumUninitialized(Length);
+	if (!ReceiveAll(Socket, Payload.GetData(), Payload.Num()))
+	{
+		return false;
+	}
+
+	FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Payload.GetData()), Payload.Num());
+	OutMessage = FString(Converter.Length(), Converter.Get());
+	return true;
+}
+
+/**
+* Sends the same request a number of times and logs its round-trip latency.
+* Returns false if the connection to the server was lost.
+*/
+static bool MeasureRequestLatency(FSocket& Socket, const TCHAR* Name, const FString& Request, int32 WarmupCount, int32 RequestCount)
+{
+	TArray<double> Latencies;
+	Latencies.Reserve(RequestCount);
+
+	FString Response;
+	for (int32 Idx = 0; Idx < WarmupCount + RequestCount; Idx++)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		if (!SendMessage(Socket, Request) || !ReceiveMessage(Socket, Response))
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Latency benchmark lost the connection to the server."));
+			return false;
+		}
+
+		if (Response != TEXT("0"))
+		{
+			UE_LOG(LogVisualStudioTools, Warning, TEXT("Latency benchmark %s request returned %s."), Name, *Response);
+		}
+
+		// Warm-up runs fill the caches, so they are not part of the results.
+		if (Idx >= WarmupCount)
+		{
+			Latencies.Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+		}
+	}
+
+	Latencies.Sort();
+
+	double Total = 0.0;
+	for (double Latency : Latencies)
+	{
+		Total += Latency;
+	}
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Latency benchmark %s: %d requests, min %.3f ms, avg %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms."),
+		Name,
+		Latencies.Num(),
+		Latencies[0],
+		Total / Latencies.Num(),
+		Latencies[Latencies.Num() / 2],
+		Latencies[FMath::Min(Latencies.Num() * 99 / 100, Latencies.Num() - 1)],
+		Latencies.Last());
+
+	return true;
+}
+
+/**
+* Connects to the server as a client and measures the round-trip latency of `Ping` requests,
+* then of warm index, blueprint references and test adapter requests, and then stops the server.
+*/
+static void RunLatencyBenchmark(const TSharedRef<FInternetAddr>& ServerAddress, int32 RequestCount)
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	FSocket* Socket = FTcpSocketBuilder(TEXT("VSServerBenchmark")).AsBlocking().Build();
+	if (Socket == nullptr || !Socket->Connect(*ServerAddress))
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Latency benchmark failed to connect to the server."));
+		if (Socket != nullptr)
+		{
+			SocketSubsystem->DestroySocket(Socket);
+		}
+		return;
+	}
+
+	// The commandlet requests write their results next to the other intermediate files of the plugin.
+	const FString OutputDir = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectIntermediateDir(), TEXT("VisualStudioTools"), TEXT("LatencyBenchmark")));
+	const FString IndexRequest = FString::Printf(TEXT("VisualStudioTools -output=\"%s\""), *FPaths::Combine(OutputDir, TEXT("Index.json")));
+	const FString ReferencesRequest = FString::Printf(TEXT("VsBlueprintReferences -output=\"%s\" -symbol=AActor::K2_GetActorLocation"), *FPaths::Combine(OutputDir, TEXT("References.json")));
+	const FString TestAdapterRequest = FString::Printf(TEXT("VSTestAdapter -listtests=\"%s\""), *FPaths::Combine(OutputDir, TEXT("Tests.txt")));
+
+	// Ping measures the transport alone, the other requests what the IDE actually waits for once the caches are warm.
+	// Stop at the first lost connection, the remaining requests would fail too.
+	const bool bConnected = MeasureRequestLatency(*Socket, TEXT("Ping"), PingRequest, 0, RequestCount)
+		&& MeasureRequestLatency(*Socket, TEXT("index"), IndexRequest, 1, CommandletBenchmarkCount)
+		&& MeasureRequestLatency(*Socket, TEXT("references"), ReferencesRequest, 1, CommandletBenchmarkCount)
+		&& MeasureRequestLatency(*Socket, TEXT("test adapter"), TestAdapterRequest, 1, CommandletBenchmarkCount);
+
+	// Without a connection the server stays up, waiting for the next client.
+	if (bConnected)
+	{
+		FString Response;
+		SendMessage(*Socket, KillServerParam);
+		ReceiveMessage(*Socket, Response);
+	}
+
+	Socket->Close();
+	SocketSubsystem->DestroySocket(Socket);
+}
+
+int32 UVSServerCommandlet::RunSocketServer(const TMap<FString, FString>& ParamVals)
+{
+	const int32 Port = FCString::Atoi(*ParamVals.FindRef(PortParam));
+
+	// Only accept local connections, the server runs commandlets on behalf of the IDE.
+	FSocket* Listener = FTcpSocketBuilder(TEXT("VSServer"))
+		.AsBlocking()
+		.AsReusable()
+		.BoundToAddress(FIPv4Address(127, 0, 0, 1))
+		.BoundToPort(Port)
+		.Listening(8)
+		.Build();
+
+	if (Listener == nullptr)
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to listen on port %d."), Port);
+		return 1;
+	}
+
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	ON_SCOPE_EXIT
+	{
+		Listener->Close();
+		SocketSubsystem->DestroySocket(Listener);
+	};
+
+	const int32 BoundPort = Listener->GetPortNo();
+	UE_LOG(LogVisualStudioTools, Display, TEXT("VSServer listening on 127.0.0.1:%d."), BoundPort);
+
+	if (const FString* PortFile = ParamVals.Find(PortFileParam))
+	{
+		FFileHelper::SaveStringToFile(FString::FromInt(BoundPort), **PortFile);
+	}
+
+	TFuture<void> Benchmark;
+	if (const FString* LatencyBenchmark = ParamVals.Find(LatencyBenchmarkParam))
+	{
+		TSharedRef<FInternetAddr> ServerAddress = SocketSubsystem->CreateInternetAddr();
+		ServerAddress->SetIp(FIPv4Address(127, 0, 0, 1).Value);
+		ServerAddress->SetPort(BoundPort);
+
+		const int32 RequestCount = FMath::Max(FCString::Atoi(**LatencyBenchmark), 1);
+		Benchmark = Async(EAsyncExecution::Thread, [ServerAddress, RequestCount]()
+			{
+				RunLatencyBenchmark(ServerAddress, RequestCount);
+			});
+	}
+
+	bool bKillRequested = false;
+	while (!bKillRequested)
+	{
+		// Block until the next client connects, there's nothing else to do in between.
+		FSocket* Connection = Listener->Accept(TEXT("VSServerConnection"));
+		if (Connection == nullptr)
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to accept a connection, stopping the server."));
+			break;
+		}
+
+		// Serve requests until the client closes the connection.
+		FString Request;
+		while (!bKillRequested && ReceiveMessage(*Connection, Request))
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			int32 Result = 0;
+			if (Request.TrimStartAndEnd().Equals(KillServerParam, ESearchCase::IgnoreCase))
+			{
+				bKillRequested = true;
+			}
+			else
+			{
+				Result = RunRequest(Request);
+			}
+
+			SendMessage(*Connection, FString::FromInt(Result));
+
+			UE_LOG(LogVisualStudioTools, Verbose, TEXT("Handled request in %.3f ms: %s"), (FPlatformTime::Seconds() - StartTime) * 1000.0, *Request);
+		}
+
+		Connection->Close();
+		SocketSubsystem->DestroySocket(Connection);
+	}
+
+	if (Benchmark.IsValid())
+	{
+		Benchmark.Wait();
+	}
+
+	return 0;
+}
+
 void UVSServerCommandlet::ExecuteSubCommandlet(FString ueServerNamedPipe)
 {
+#if PLATFORM_WINDOWS
 	char buffer[1024];
 	DWORD dwRead;
 	std::string result = "0";
@@ -89,6 +426,7 @@ void UVSServerCommandlet::ExecuteSubCommandlet(FString ueServerNamedPipe)
 			WriteFile(HPipe, result.c_str(), result.size(), &dwRead, NULL);
 		}
 	}
+#endif
 }
 
 int32 UVSServerCommandlet::Main(const FString &ServerParams)
@@ -98,8 +436,13 @@ int32 UVSServerCommandlet::Main(const FString &ServerParams)
 	TMap<FString, FString> ParamVals;
 
 	ParseCommandLine(*ServerParams, Tokens, Switches, ParamVals);
-	if (ParamVals.Contains(NamedPipeParam))
+	if (ParamVals.Contains(PortParam))
+	{
+		return RunSocketServer(ParamVals);
+	}
+	else if (ParamVals.Contains(NamedPipeParam))
 	{
+#if PLATFORM_WINDOWS
 		FString ueServerNamedPipe = ParamVals[NamedPipeParam];
 
 		// Infinite loop that listens to requests every second.
@@ -108,11 +451,15 @@ int32 UVSServerCommandlet::Main(const FString &ServerParams)
 			std::this_thread::sleep_for(std::chrono::seconds(1));
 			ExecuteSubCommandlet(ueServerNamedPipe);
 		}
+#else
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Named pipes are only supported on Windows, use `-Port` instead."));
+		return 1;
+#endif
 	}
 	else
 	{
-		UE_LOG(LogVisualStudioTools, Display, TEXT("Missing named pipe parameter."));
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Missing named pipe or port parameter."));
 	}
 
 	return 1;
-}
\ No newline at end of file
+}
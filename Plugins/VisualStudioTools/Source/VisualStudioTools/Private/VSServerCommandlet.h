@@ -26,4 +26,7 @@ public:
 
 private:
 	void ExecuteSubCommandlet(FString ueServerNamedPipe);
+
+	/** Serves length-prefixed requests over a loopback TCP socket until a kill request is received. */
+	int32 RunSocketServer(const TMap<FString, FString>& ParamVals);
 };
\ No newline at end of file
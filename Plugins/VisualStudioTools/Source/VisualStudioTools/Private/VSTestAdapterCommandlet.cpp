@@ -2,119 +2,265 @@
 
 #include "VSTestAdapterCommandlet.h"
 
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/MiscTrace.h"
 #include "Runtime/Core/Public/Async/TaskGraphInterfaces.h"
 #include "Runtime/Core/Public/Containers/Ticker.h"
 #include "Runtime/Launch/Resources/Version.h"
-#include <string>
-#include <fstream>
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
 
+#include "TestManifest.h"
 #include "VisualStudioTools.h"
 
+using VisualStudioTools::FTestEntry;
+
+namespace TestManifest = VisualStudioTools::TestManifest;
+
 static constexpr auto FiltersParam = TEXT("filters");
 static constexpr auto ListTestsParam = TEXT("listtests");
 static constexpr auto RunTestsParam = TEXT("runtests");
 static constexpr auto TestResultsFileParam = TEXT("testresultfile");
 static constexpr auto HelpParam = TEXT("help");
+static constexpr auto ShardsParam = TEXT("shards");
+static constexpr auto NoHistoryParam = TEXT("nohistory");
+static constexpr auto JUnitParam = TEXT("junit");
+static constexpr auto MetricsFileParam = TEXT("metricsfile");
+static constexpr auto PerfBaselineParam = TEXT("perfbaseline");
+static constexpr auto PerfToleranceParam = TEXT("perftolerance");
+static constexpr auto UpdatePerfBaselineParam = TEXT("updateperfbaseline");
+static constexpr auto TraceTestsParam = TEXT("tracetests");
+
+// [RUNTEST] is part of the results file protocol.
+static constexpr auto RunTestTag = TEXT("[RUNTEST]");
 
-static void GetAllTests(TArray<FAutomationTestInfo>& OutTestList)
+/**
+* Gets the tests from the manifest of a previous run when the modules, and for complex tests the assets, didn't change,
+* and only asks the automation framework to enumerate them otherwise.
+*/
+static void GetAllTests(TArray<FTestEntry>& OutTestList)
 {
+	const double StartTime = FPlatformTime::Seconds();
+
+	const FString ManifestFile = TestManifest::GetDefaultFilePath();
+	const FString ModulesKey = TestManifest::GetModulesKey();
+	if (TestManifest::Load(ManifestFile, ModulesKey, OutTestList))
+	{
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Loaded %d tests from the test manifest in %.2f ms."), OutTestList.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		return;
+	}
+
+	TArray<FAutomationTestInfo> TestInfos;
 	FAutomationTestFramework& Framework = FAutomationTestFramework::GetInstance();
-	Framework.GetValidTestNames(OutTestList);
+	Framework.GetValidTestNames(TestInfos);
+
+	const bool bHasComplexTests = TestManifest::ConvertTests(TestInfos, OutTestList);
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Discovered %d tests in %.2f ms."), OutTestList.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	// The cases of complex tests can come from the assets, so they're only cached when the asset state can be keyed.
+	const FString ContentKey = bHasComplexTests ? TestManifest::GetContentKey() : FString();
+	if (bHasComplexTests && ContentKey.IsEmpty())
+	{
+		return;
+	}
+
+	TestManifest::Save(ManifestFile, ModulesKey, ContentKey, OutTestList);
 }
 
-static void ReadTestsFromFile(const FString& InFile, TArray<FAutomationTestInfo>& OutTestList)
+/**
+* Writes a line to a text file as UTF-8.
+* The engine file writers are used instead of wide file streams, which only take TCHAR strings on Windows.
+*/
+static void WriteLine(FArchive& File, const FString& Line)
 {
-	TSet<FString> TestCommands;
+	FTCHARToUTF8 Utf8Line(*(Line + TEXT("\n")));
+	File.Serialize(const_cast<ANSICHAR*>(Utf8Line.Get()), Utf8Line.Length());
+}
 
-	// Wrapping in an inner scope to ensure automatic destruction of InStream object without explicitly calling .close().
+static void ReadTestsFromFile(const FString& InFile, TArray<FTestEntry>& OutTestList)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *InFile))
 	{
-		std::wifstream InStream(*InFile);
-		if (!InStream.good())
-		{
-			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *InFile);
-			return;
-		}
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *InFile);
+		return;
+	}
 
-		std::wstring Line;
-		while (std::getline(InStream, Line))
+	TSet<FString> TestCommands;
+	for (const FString& Line : Lines)
+	{
+		if (Line.Len() > 0)
 		{
-			if (Line.length() > 0)
-			{
-				TestCommands.Add(FString(Line.c_str()));
-			}
+			TestCommands.Add(Line);
 		}
 	}
 
 	GetAllTests(OutTestList);
-	for (int32 Idx = OutTestList.Num() - 1; Idx >= 0; Idx--)
-	{
-		if (!TestCommands.Contains(OutTestList[Idx].GetTestName()))
+
+	// Compact the list in a single pass, keeping the tests in the order of discovery.
+	OutTestList.RemoveAll([&TestCommands](const FTestEntry& Test)
 		{
-			OutTestList.RemoveAt(Idx);
-		}
-	}
+			return !TestCommands.Contains(Test.TestCommand);
+		});
 }
 
 static int32 ListTests(const FString& TargetFile)
 {
-	std::wofstream OutFile(*TargetFile);
-	if (!OutFile.good())
+	TUniquePtr<FArchive> OutFile(IFileManager::Get().CreateFileWriter(*TargetFile));
+	if (!OutFile)
 	{
 		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *TargetFile);
 		return 1;
 	}
 
-	FAutomationTestFramework& Framework = FAutomationTestFramework::GetInstance();
-
-	TArray<FAutomationTestInfo> TestInfos;
-	GetAllTests(TestInfos);
+	TArray<FTestEntry> Tests;
+	GetAllTests(Tests);
 
-	for (const auto& TestInfo : TestInfos)
+	for (const FTestEntry& Test : Tests)
 	{
-		const FString TestCommand = TestInfo.GetTestName();
-		const FString DisplayName = TestInfo.GetDisplayName();
-		const FString SourceFile = TestInfo.GetSourceFile();
-		const int32 Line = TestInfo.GetSourceFileLine();
-
-		OutFile << *TestCommand << TEXT("|") << *DisplayName << TEXT("|") << Line << TEXT("|") << *SourceFile << std::endl;
+		WriteLine(*OutFile, FString::Printf(TEXT("%s|%s|%d|%s"), *Test.TestCommand, *Test.DisplayName, Test.Line, *Test.SourceFile));
 	}
 
-	UE_LOG(LogVisualStudioTools, Display, TEXT("Found %d tests"), TestInfos.Num());
-	OutFile.close();
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Found %d tests"), Tests.Num());
 
 	return 0;
 }
 
-static int32 RunTests(const FString& TestListFile, const FString& ResultsFile)
+static void GetTestsToRun(const FString& TestListFile, TArray<FTestEntry>& OutTestList)
 {
-	std::wofstream OutFile(*ResultsFile);
-	if (!OutFile.good())
+	if (TestListFile.Equals(TEXT("All"), ESearchCase::IgnoreCase))
 	{
-		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *ResultsFile);
-		return 1;
+		GetAllTests(OutTestList);
+	}
+	else
+	{
+		ReadTestsFromFile(TestListFile, OutTestList);
 	}
+}
 
-	TArray<FAutomationTestInfo> TestInfos;
-	if (TestListFile.Equals(TEXT("All"), ESearchCase::IgnoreCase))
+/**
+* Performance and resource metrics of a single test run.
+*/
+struct FTestMetrics
+{
+	FString TestCommand;
+	FString DisplayName;
+	bool bSuccessful = false;
+	double Duration = 0.0;
+
+	/**
+	* Peak physical memory used while the test ran, relative to the start of the test.
+	* Taken from the process high-water mark when the test raised it, otherwise from the memory sampled every frame of the test.
+	*/
+	int64 PeakMemoryDelta = 0;
+
+	/** Number of garbage collections during the test. */
+	int32 GCCount = 0;
+
+	/** Distribution of the game thread frame times, for tests running latent commands. */
+	int32 NumFrames = 0;
+	double FrameTimeP50 = 0.0;
+	double FrameTimeP95 = 0.0;
+	double FrameTimeMax = 0.0;
+
+	TArray<FString> Errors;
+};
+
+/**
+* Performance budget of a test, from the perf baseline file.
+*/
+struct FTestBudget
+{
+	double Duration = 0.0;
+	int64 PeakMemoryDelta = 0;
+};
+
+struct FTestRunOptions
+{
+	/** Budgets by test name. Tests exceeding their budget by more than the tolerance fail. */
+	TMap<FString, FTestBudget> Budgets;
+	double BudgetTolerance = 0.2;
+
+	/** Adds Insights bookmarks around each test, so they can be selected as a slice of the trace. */
+	bool bTraceTests = false;
+};
+
+static double GetPercentile(const TArray<double>& SortedValues, int32 Percentile)
+{
+	return SortedValues.Num() > 0 ? SortedValues[FMath::Min(SortedValues.Num() * Percentile / 100, SortedValues.Num() - 1)] : 0.0;
+}
+
+static void CheckTestBudget(const FTestRunOptions& Options, FTestMetrics& InOutMetrics)
+{
+	const FTestBudget* Budget = Options.Budgets.Find(InOutMetrics.TestCommand);
+	if (Budget == nullptr)
 	{
-		GetAllTests(TestInfos);
+		return;
 	}
-	else
+
+	const double Scale = 1.0 + Options.BudgetTolerance;
+	if (Budget->Duration > 0.0 && InOutMetrics.Duration > Budget->Duration * Scale)
+	{
+		InOutMetrics.bSuccessful = false;
+		InOutMetrics.Errors.Add(FString::Printf(TEXT("Exceeded the duration budget: %.3fs, budget %.3fs."), InOutMetrics.Duration, Budget->Duration));
+	}
+
+	if (Budget->PeakMemoryDelta > 0 && InOutMetrics.PeakMemoryDelta > Budget->PeakMemoryDelta * Scale)
+	{
+		InOutMetrics.bSuccessful = false;
+		InOutMetrics.Errors.Add(FString::Printf(TEXT("Exceeded the memory budget: %lld bytes, budget %lld bytes."), InOutMetrics.PeakMemoryDelta, Budget->PeakMemoryDelta));
+	}
+}
+
+static int32 RunTests(const FString& TestListFile, const FString& ResultsFile, const FTestRunOptions& Options, TArray<FTestMetrics>& OutMetrics)
+{
+	TUniquePtr<FArchive> OutFile(IFileManager::Get().CreateFileWriter(*ResultsFile));
+	if (!OutFile)
 	{
-		ReadTestsFromFile(TestListFile, TestInfos);
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *ResultsFile);
+		return 1;
 	}
 
+	TArray<FTestEntry> Tests;
+	GetTestsToRun(TestListFile, Tests);
+
 	bool AllSuccessful = true;
 
 	FAutomationTestFramework& Framework = FAutomationTestFramework::GetInstance();
 
-	for (const FAutomationTestInfo& TestInfo : TestInfos)
+	int32 GCCount = 0;
+	FDelegateHandle PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddLambda([&GCCount]()
+		{
+			GCCount++;
+		});
+
+	for (const FTestEntry& Test : Tests)
 	{
-		const FString TestCommand = TestInfo.GetTestName();
-		const FString DisplayName = TestInfo.GetDisplayName();
+		const FString& TestCommand = Test.TestCommand;
+		const FString& DisplayName = Test.DisplayName;
 
 		UE_LOG(LogVisualStudioTools, Log, TEXT("Running %s"), *DisplayName);
 
+		if (Options.bTraceTests)
+		{
+			TRACE_BOOKMARK(TEXT("Test started: %s"), *TestCommand);
+		}
+
+		const FPlatformMemoryStats StartMemoryStats = FPlatformMemory::GetStats();
+		const int64 StartMemory = static_cast<int64>(StartMemoryStats.UsedPhysical);
+		int64 PeakMemory = StartMemory;
+		const int32 StartGCCount = GCCount;
+		TArray<double> FrameTimes;
+
 		const int32 RoleIndex = 0; // always default to "local" role index.  Only used for multi-participant tests
 		Framework.StartTestByName(TestCommand, RoleIndex);
 
@@ -136,34 +282,577 @@ static int32 RunTests(const FString& TestListFile, const FString& ResultsFile)
 #endif
 
 			Last = Now;
+
+			// Each pass of the latent commands is a frame of the test.
+			FrameTimes.Add(Delta);
+			PeakMemory = FMath::Max(PeakMemory, static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical));
 		}
 
 		FAutomationTestExecutionInfo ExecutionInfo;
 		const bool CurrentTestSuccessful = Framework.StopTest(ExecutionInfo) && ExecutionInfo.GetErrorTotal() == 0;
-		AllSuccessful = AllSuccessful && CurrentTestSuccessful;
 
-		const FString Result = CurrentTestSuccessful ? TEXT("OK") : TEXT("FAIL");
+		if (Options.bTraceTests)
+		{
+			TRACE_BOOKMARK(TEXT("Test finished: %s"), *TestCommand);
+		}
+
+		FTestMetrics& Metrics = OutMetrics.AddDefaulted_GetRef();
+		Metrics.TestCommand = TestCommand;
+		Metrics.DisplayName = DisplayName;
+		Metrics.bSuccessful = CurrentTestSuccessful;
+		Metrics.Duration = ExecutionInfo.Duration;
+		// The process high-water mark can't be reset, so it only measures the test if the test raised it.
+		// Otherwise only the per-frame samples are available, and they miss memory allocated and freed within a frame.
+		const FPlatformMemoryStats EndMemoryStats = FPlatformMemory::GetStats();
+		PeakMemory = FMath::Max(PeakMemory, static_cast<int64>(EndMemoryStats.UsedPhysical));
+		if (EndMemoryStats.PeakUsedPhysical > StartMemoryStats.PeakUsedPhysical)
+		{
+			PeakMemory = FMath::Max(PeakMemory, static_cast<int64>(EndMemoryStats.PeakUsedPhysical));
+		}
+
+		Metrics.PeakMemoryDelta = PeakMemory - StartMemory;
+		Metrics.GCCount = GCCount - StartGCCount;
+
+		FrameTimes.Sort();
+		Metrics.NumFrames = FrameTimes.Num();
+		Metrics.FrameTimeP50 = GetPercentile(FrameTimes, 50);
+		Metrics.FrameTimeP95 = GetPercentile(FrameTimes, 95);
+		Metrics.FrameTimeMax = FrameTimes.Num() > 0 ? FrameTimes.Last() : 0.0;
+
+		for (const auto& Entry : ExecutionInfo.GetEntries())
+		{
+			if (Entry.Event.Type == EAutomationEventType::Error)
+			{
+				Metrics.Errors.Add(Entry.Event.Message);
+			}
+		}
+
+		CheckTestBudget(Options, Metrics);
+		AllSuccessful = AllSuccessful && Metrics.bSuccessful;
+
+		const FString Result = Metrics.bSuccessful ? TEXT("OK") : TEXT("FAIL");
 
 		// [RUNTEST] is part of the protocol, so do not remove.
-		OutFile << TEXT("[RUNTEST]") << *TestCommand << TEXT("|") << *DisplayName << TEXT("|") << *Result << TEXT("|") << ExecutionInfo.Duration << std::endl;
+		WriteLine(*OutFile, FString::Printf(TEXT("%s%s|%s|%s|%g"), RunTestTag, *TestCommand, *DisplayName, *Result, ExecutionInfo.Duration));
+
+		UE_LOG(LogVisualStudioTools, Log, TEXT("Finished %s in %.3fs: peak memory delta %lld bytes, %d GCs, %d frames (p50 %.2f ms, p95 %.2f ms, max %.2f ms)"),
+			*DisplayName, Metrics.Duration, Metrics.PeakMemoryDelta, Metrics.GCCount, Metrics.NumFrames,
+			Metrics.FrameTimeP50 * 1000.0, Metrics.FrameTimeP95 * 1000.0, Metrics.FrameTimeMax * 1000.0);
 
-		if (!CurrentTestSuccessful)
+		if (!Metrics.bSuccessful)
 		{
-			for (const auto& Entry : ExecutionInfo.GetEntries())
+			for (const FString& Error : Metrics.Errors)
 			{
-				if (Entry.Event.Type == EAutomationEventType::Error)
-				{
-					OutFile << *Entry.Event.Message << std::endl;
-					UE_LOG(LogVisualStudioTools, Error, TEXT("%s"), *Entry.Event.Message);
-				}
+				WriteLine(*OutFile, Error);
+				UE_LOG(LogVisualStudioTools, Error, TEXT("%s"), *Error);
 			}
 
 			UE_LOG(LogVisualStudioTools, Log, TEXT("Failed  %s"), *DisplayName);
 		}
 
-		OutFile.flush();
+		OutFile->Flush();
+	}
+
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+
+	return AllSuccessful ? 0 : 1;
+}
+
+static TSharedRef<FJsonObject> TestMetricsToJson(const FTestMetrics& Metrics)
+{
+	TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+	Object->SetStringField(TEXT("test"), Metrics.TestCommand);
+	Object->SetStringField(TEXT("displayName"), Metrics.DisplayName);
+	Object->SetBoolField(TEXT("successful"), Metrics.bSuccessful);
+	Object->SetNumberField(TEXT("duration"), Metrics.Duration);
+	Object->SetNumberField(TEXT("peakMemoryDelta"), static_cast<double>(Metrics.PeakMemoryDelta));
+	Object->SetNumberField(TEXT("gcCount"), Metrics.GCCount);
+	Object->SetNumberField(TEXT("frames"), Metrics.NumFrames);
+	Object->SetNumberField(TEXT("frameTimeP50"), Metrics.FrameTimeP50);
+	Object->SetNumberField(TEXT("frameTimeP95"), Metrics.FrameTimeP95);
+	Object->SetNumberField(TEXT("frameTimeMax"), Metrics.FrameTimeMax);
+
+	TArray<TSharedPtr<FJsonValue>> ErrorValues;
+	for (const FString& Error : Metrics.Errors)
+	{
+		ErrorValues.Add(MakeShared<FJsonValueString>(Error));
+	}
+	Object->SetArrayField(TEXT("errors"), ErrorValues);
+
+	return Object;
+}
+
+static FTestMetrics TestMetricsFromJson(const FJsonObject& Object)
+{
+	FTestMetrics Metrics;
+	Metrics.TestCommand = Object.GetStringField(TEXT("test"));
+	Metrics.DisplayName = Object.GetStringField(TEXT("displayName"));
+	Metrics.bSuccessful = Object.GetBoolField(TEXT("successful"));
+	Metrics.Duration = Object.GetNumberField(TEXT("duration"));
+	Metrics.PeakMemoryDelta = static_cast<int64>(Object.GetNumberField(TEXT("peakMemoryDelta")));
+	Metrics.GCCount = static_cast<int32>(Object.GetNumberField(TEXT("gcCount")));
+	Metrics.NumFrames = static_cast<int32>(Object.GetNumberField(TEXT("frames")));
+	Metrics.FrameTimeP50 = Object.GetNumberField(TEXT("frameTimeP50"));
+	Metrics.FrameTimeP95 = Object.GetNumberField(TEXT("frameTimeP95"));
+	Metrics.FrameTimeMax = Object.GetNumberField(TEXT("frameTimeMax"));
+
+	for (const TSharedPtr<FJsonValue>& ErrorValue : Object.GetArrayField(TEXT("errors")))
+	{
+		Metrics.Errors.Add(ErrorValue->AsString());
+	}
+
+	return Metrics;
+}
+
+static bool SaveTestMetrics(const TArray<FTestMetrics>& Metrics, const FString& MetricsFile)
+{
+	TArray<TSharedPtr<FJsonValue>> Values;
+	for (const FTestMetrics& TestMetrics : Metrics)
+	{
+		Values.Add(MakeShared<FJsonValueObject>(TestMetricsToJson(TestMetrics)));
+	}
+
+	FString Contents;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Contents);
+	return FJsonSerializer::Serialize(Values, Writer) && FFileHelper::SaveStringToFile(Contents, *MetricsFile);
+}
+
+static void LoadTestMetrics(const FString& MetricsFile, TArray<FTestMetrics>& OutMetrics)
+{
+	FString Contents;
+	if (!FFileHelper::LoadFileToString(Contents, *MetricsFile))
+	{
+		return;
+	}
+
+	TArray<TSharedPtr<FJsonValue>> Values;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Contents);
+	if (!FJsonSerializer::Deserialize(Reader, Values))
+	{
+		return;
+	}
+
+	for (const TSharedPtr<FJsonValue>& Value : Values)
+	{
+		const TSharedPtr<FJsonObject>* Object = nullptr;
+		if (!Value.IsValid() || !Value->TryGetObject(Object) || !Object->IsValid())
+		{
+			UE_LOG(LogVisualStudioTools, Warning, TEXT("Skipping an entry that is not a test in the metrics file at path: %s"), *MetricsFile);
+			continue;
+		}
+
+		OutMetrics.Add(TestMetricsFromJson(**Object));
+	}
+}
+
+static void LoadPerfBaseline(const FString& BaselineFile, TMap<FString, FTestBudget>& OutBudgets)
+{
+	FString Contents;
+	if (!FFileHelper::LoadFileToString(Contents, *BaselineFile))
+	{
+		UE_LOG(LogVisualStudioTools, Warning, TEXT("No performance baseline found at path: %s"), *BaselineFile);
+		return;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Contents);
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to parse the performance baseline at path: %s"), *BaselineFile);
+		return;
+	}
+
+	for (const auto& Item : Root->Values)
+	{
+		const TSharedPtr<FJsonObject>& BudgetObject = Item.Value->AsObject();
+		if (BudgetObject.IsValid())
+		{
+			FTestBudget& Budget = OutBudgets.Add(Item.Key);
+			Budget.Duration = BudgetObject->GetNumberField(TEXT("duration"));
+			Budget.PeakMemoryDelta = static_cast<int64>(BudgetObject->GetNumberField(TEXT("peakMemoryDelta")));
+		}
+	}
+}
+
+/**
+* Stores the metrics of the passing tests as their budget, keeping the budgets of the tests that didn't run.
+*/
+static void UpdatePerfBaseline(const FString& BaselineFile, const TArray<FTestMetrics>& Metrics)
+{
+	TMap<FString, FTestBudget> Budgets;
+	if (IFileManager::Get().FileExists(*BaselineFile))
+	{
+		LoadPerfBaseline(BaselineFile, Budgets);
+	}
+
+	for (const FTestMetrics& TestMetrics : Metrics)
+	{
+		if (TestMetrics.bSuccessful)
+		{
+			FTestBudget& Budget = Budgets.Add(TestMetrics.TestCommand);
+			Budget.Duration = TestMetrics.Duration;
+			Budget.PeakMemoryDelta = TestMetrics.PeakMemoryDelta;
+		}
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	for (const auto& Item : Budgets)
+	{
+		TSharedRef<FJsonObject> BudgetObject = MakeShared<FJsonObject>();
+		BudgetObject->SetNumberField(TEXT("duration"), Item.Value.Duration);
+		BudgetObject->SetNumberField(TEXT("peakMemoryDelta"), static_cast<double>(Item.Value.PeakMemoryDelta));
+		Root->SetObjectField(Item.Key, BudgetObject);
+	}
+
+	FString Contents;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Contents);
+	if (FJsonSerializer::Serialize(Root, Writer))
+	{
+		FFileHelper::SaveStringToFile(Contents, *BaselineFile);
+	}
+}
+
+static FString EscapeXml(const FString& InText)
+{
+	FString Result = InText;
+	Result.ReplaceInline(TEXT("&"), TEXT("&amp;"));
+	Result.ReplaceInline(TEXT("<"), TEXT("&lt;"));
+	Result.ReplaceInline(TEXT(">"), TEXT("&gt;"));
+	Result.ReplaceInline(TEXT("\""), TEXT("&quot;"));
+	Result.ReplaceInline(TEXT("'"), TEXT("&apos;"));
+	return Result;
+}
+
+/**
+* Writes the results in the JUnit XML format, with the test metrics as properties of each test case.
+*/
+static bool WriteJUnitResults(const TArray<FTestMetrics>& Metrics, const FString& JUnitFile)
+{
+	int32 Failures = 0;
+	double TotalTime = 0.0;
+	for (const FTestMetrics& TestMetrics : Metrics)
+	{
+		Failures += TestMetrics.bSuccessful ? 0 : 1;
+		TotalTime += TestMetrics.Duration;
+	}
+
+	FString Xml = TEXT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	Xml += FString::Printf(TEXT("<testsuites tests=\"%d\" failures=\"%d\" time=\"%.3f\">\n"), Metrics.Num(), Failures, TotalTime);
+	Xml += FString::Printf(TEXT("  <testsuite name=\"UnrealAutomation\" tests=\"%d\" failures=\"%d\" time=\"%.3f\">\n"), Metrics.Num(), Failures, TotalTime);
+
+	for (const FTestMetrics& TestMetrics : Metrics)
+	{
+		// Automation test names are dot separated paths, use the last part as the test case name.
+		FString ClassName;
+		FString Name = TestMetrics.TestCommand;
+		TestMetrics.TestCommand.Split(TEXT("."), &ClassName, &Name, ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+
+		Xml += FString::Printf(TEXT("    <testcase classname=\"%s\" name=\"%s\" time=\"%.3f\">\n"), *EscapeXml(ClassName), *EscapeXml(Name), TestMetrics.Duration);
+		Xml += TEXT("      <properties>\n");
+		Xml += FString::Printf(TEXT("        <property name=\"peakMemoryDelta\" value=\"%lld\"/>\n"), TestMetrics.PeakMemoryDelta);
+		Xml += FString::Printf(TEXT("        <property name=\"gcCount\" value=\"%d\"/>\n"), TestMetrics.GCCount);
+		Xml += FString::Printf(TEXT("        <property name=\"frames\" value=\"%d\"/>\n"), TestMetrics.NumFrames);
+		Xml += FString::Printf(TEXT("        <property name=\"frameTimeP50\" value=\"%.6f\"/>\n"), TestMetrics.FrameTimeP50);
+		Xml += FString::Printf(TEXT("        <property name=\"frameTimeP95\" value=\"%.6f\"/>\n"), TestMetrics.FrameTimeP95);
+		Xml += FString::Printf(TEXT("        <property name=\"frameTimeMax\" value=\"%.6f\"/>\n"), TestMetrics.FrameTimeMax);
+		Xml += TEXT("      </properties>\n");
+
+		if (!TestMetrics.bSuccessful)
+		{
+			const FString Message = TestMetrics.Errors.Num() > 0 ? TestMetrics.Errors[0] : FString(TEXT("Test failed."));
+			Xml += FString::Printf(TEXT("      <failure message=\"%s\">%s</failure>\n"), *EscapeXml(Message), *EscapeXml(FString::Join(TestMetrics.Errors, TEXT("\n"))));
+		}
+
+		Xml += TEXT("    </testcase>\n");
+	}
+
+	Xml += TEXT("  </testsuite>\n");
+	Xml += TEXT("</testsuites>\n");
+
+	return FFileHelper::SaveStringToFile(Xml, *JUnitFile, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
+
+/**
+* Result of a single test, as written to the results file.
+*/
+struct FTestResultLine
+{
+	FString TestCommand;
+	FString DisplayName;
+	bool bSuccessful = false;
+	double Duration = 0.0;
+};
+
+static bool ParseTestResultLine(const FString& Line, FTestResultLine& OutResult)
+{
+	if (!Line.StartsWith(RunTestTag))
+	{
+		return false;
+	}
+
+	// [RUNTEST]TestCommand|DisplayName|Result|Duration
+	TArray<FString> Fields;
+	Line.RightChop(FCString::Strlen(RunTestTag)).ParseIntoArray(Fields, TEXT("|"), false);
+	if (Fields.Num() < 4)
+	{
+		return false;
+	}
+
+	OutResult.TestCommand = Fields[0];
+	OutResult.DisplayName = Fields[1];
+	OutResult.bSuccessful = Fields[2] == TEXT("OK");
+	OutResult.Duration = FCString::Atod(*Fields[3]);
+	return true;
+}
+
+static FString GetTestDurationsFile()
+{
+	return FPaths::Combine(FPaths::ProjectIntermediateDir(), TEXT("VisualStudioTools"), TEXT("TestDurations.json"));
+}
+
+static TMap<FString, double> LoadTestDurations()
+{
+	TMap<FString, double> Durations;
+
+	FString Contents;
+	if (!FFileHelper::LoadFileToString(Contents, *GetTestDurationsFile()))
+	{
+		return Durations;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Contents);
+	if (FJsonSerializer::Deserialize(Reader, Root) && Root.IsValid())
+	{
+		for (const auto& Item : Root->Values)
+		{
+			Durations.Add(Item.Key, Item.Value->AsNumber());
+		}
+	}
+
+	return Durations;
+}
+
+/**
+* Stores the duration of the tests in the results file, to schedule the shards of later runs.
+*/
+static void RecordTestDurations(const FString& ResultsFile)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *ResultsFile))
+	{
+		return;
+	}
+
+	TMap<FString, double> Durations = LoadTestDurations();
+	for (const FString& Line : Lines)
+	{
+		FTestResultLine Result;
+		if (ParseTestResultLine(Line, Result))
+		{
+			Durations.Add(Result.TestCommand, Result.Duration);
+		}
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	for (const auto& Item : Durations)
+	{
+		Root->SetNumberField(Item.Key, Item.Value);
+	}
+
+	FString Contents;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Contents);
+	if (FJsonSerializer::Serialize(Root, Writer))
+	{
+		FFileHelper::SaveStringToFile(Contents, *GetTestDurationsFile());
+	}
+}
+
+/**
+* Splits the tests in shards with a similar expected duration, using longest-processing-time-first scheduling:
+* the longest tests are assigned first, each one to the shard with the lowest expected duration so far.
+*/
+static TArray<TArray<FString>> ScheduleShards(const TArray<FTestEntry>& TestsToRun, int32 NumShards, const TMap<FString, double>& Durations)
+{
+	// Tests without history are assumed to take the average duration of the known ones.
+	double KnownTotal = 0.0;
+	int32 KnownCount = 0;
+	for (const FTestEntry& Test : TestsToRun)
+	{
+		if (const double* Duration = Durations.Find(Test.TestCommand))
+		{
+			KnownTotal += *Duration;
+			KnownCount++;
+		}
+	}
+
+	const double DefaultDuration = KnownCount > 0 ? KnownTotal / KnownCount : 1.0;
+
+	TArray<TPair<double, FString>> Tests;
+	Tests.Reserve(TestsToRun.Num());
+	for (const FTestEntry& Test : TestsToRun)
+	{
+		const double* Duration = Durations.Find(Test.TestCommand);
+		Tests.Emplace(Duration != nullptr ? *Duration : DefaultDuration, Test.TestCommand);
+	}
+
+	Tests.StableSort([](const TPair<double, FString>& A, const TPair<double, FString>& B)
+		{
+			return A.Key > B.Key;
+		});
+
+	TArray<TArray<FString>> Shards;
+	Shards.SetNum(NumShards);
+
+	TArray<double> ShardDurations;
+	ShardDurations.SetNumZeroed(NumShards);
+
+	for (const TPair<double, FString>& Test : Tests)
+	{
+		int32 ShortestShard = 0;
+		for (int32 Idx = 1; Idx < NumShards; Idx++)
+		{
+			if (ShardDurations[Idx] < ShardDurations[ShortestShard])
+			{
+				ShortestShard = Idx;
+			}
+		}
+
+		Shards[ShortestShard].Add(Test.Value);
+		ShardDurations[ShortestShard] += Test.Key;
+	}
+
+	for (int32 Idx = 0; Idx < NumShards; Idx++)
+	{
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Shard %d: %d tests, expected %.2fs"), Idx, Shards[Idx].Num(), ShardDurations[Idx]);
+	}
+
+	return Shards;
+}
+
+/**
+* Runs the tests across worker editor processes, each running a shard of the tests,
+* and merges their results into the results file and their metrics into OutMetrics.
+* WorkerArgs are forwarded to every worker, so they run the tests with the same filters and budgets.
+*/
+static int32 RunTestsSharded(const FString& TestListFile, const FString& ResultsFile, int32 NumShards, const FString& WorkerArgs, TArray<FTestMetrics>& OutMetrics)
+{
+	TArray<FTestEntry> Tests;
+	GetTestsToRun(TestListFile, Tests);
+
+	TArray<TArray<FString>> Shards = ScheduleShards(Tests, NumShards, LoadTestDurations());
+
+	const FString ShardsDir = FPaths::Combine(FPaths::ProjectIntermediateDir(), TEXT("VisualStudioTools"), TEXT("TestShards"));
+	const FString ExecutablePath = FPlatformProcess::ExecutablePath();
+	const FString ProjectPath = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FProcHandle> Workers;
+	TArray<FString> ShardResultsFiles;
+	TArray<FString> ShardMetricsFiles;
+	for (int32 Idx = 0; Idx < Shards.Num(); Idx++)
+	{
+		if (Shards[Idx].Num() == 0)
+		{
+			continue;
+		}
+
+		const FString ShardListFile = FPaths::ConvertRelativePathToFull(FPaths::Combine(ShardsDir, FString::Printf(TEXT("Shard%d.txt"), Idx)));
+		const FString ShardResultsFile = FPaths::ConvertRelativePathToFull(FPaths::Combine(ShardsDir, FString::Printf(TEXT("Shard%d.results.txt"), Idx)));
+
+		const FString ShardMetricsFile = FPaths::ConvertRelativePathToFull(FPaths::Combine(ShardsDir, FString::Printf(TEXT("Shard%d.metrics.json"), Idx)));
+
+		FFileHelper::SaveStringArrayToFile(Shards[Idx], *ShardListFile, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+		IFileManager::Get().Delete(*ShardResultsFile);
+		IFileManager::Get().Delete(*ShardMetricsFile);
+
+		// The coordinator records the durations once the results are merged.
+		FString Args = FString::Printf(TEXT("\"%s\" -run=VSTestAdapter -%s=\"%s\" -%s=\"%s\" -%s=\"%s\" -%s"),
+			*ProjectPath, RunTestsParam, *ShardListFile, TestResultsFileParam, *ShardResultsFile, MetricsFileParam, *ShardMetricsFile, NoHistoryParam);
+
+		Args += WorkerArgs;
+		Args += TEXT(" -unattended -nullrhi -nosound -nosplash -nocrashreports -multiprocess -NoShaderCompile");
+
+		UE_LOG(LogVisualStudioTools, Log, TEXT("Starting test worker %d: %s %s"), Idx, *ExecutablePath, *Args);
+		FProcHandle Worker = FPlatformProcess::CreateProc(*ExecutablePath, *Args, false, true, true, nullptr, 0, nullptr, nullptr);
+		if (!Worker.IsValid())
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to start test worker %d."), Idx);
+		}
+
+		Workers.Add(Worker);
+		ShardResultsFiles.Add(ShardResultsFile);
+		ShardMetricsFiles.Add(ShardMetricsFile);
+	}
+
+	for (int32 Idx = 0; Idx < Workers.Num(); Idx++)
+	{
+		if (Workers[Idx].IsValid())
+		{
+			FPlatformProcess::WaitForProc(Workers[Idx]);
+			FPlatformProcess::CloseProc(Workers[Idx]);
+		}
 	}
 
+	const double WallTime = FPlatformTime::Seconds() - StartTime;
+
+	// Merge the results, and report the tests of any crashed worker as failed.
+	FString MergedResults;
+	TSet<FString> ReportedTests;
+	bool AllSuccessful = true;
+	double TotalTestTime = 0.0;
+
+	for (const FString& ShardResultsFile : ShardResultsFiles)
+	{
+		TArray<FString> Lines;
+		FFileHelper::LoadFileToStringArray(Lines, *ShardResultsFile);
+
+		for (const FString& Line : Lines)
+		{
+			FTestResultLine Result;
+			if (ParseTestResultLine(Line, Result))
+			{
+				ReportedTests.Add(Result.TestCommand);
+				AllSuccessful = AllSuccessful && Result.bSuccessful;
+				TotalTestTime += Result.Duration;
+			}
+
+			MergedResults += Line;
+			MergedResults += TEXT("\n");
+		}
+	}
+
+	for (const FString& ShardMetricsFile : ShardMetricsFiles)
+	{
+		LoadTestMetrics(ShardMetricsFile, OutMetrics);
+	}
+
+	for (const FTestEntry& Test : Tests)
+	{
+		if (!ReportedTests.Contains(Test.TestCommand))
+		{
+			const FString Error = TEXT("The test worker exited before reporting a result for this test.");
+			MergedResults += FString::Printf(TEXT("%s%s|%s|FAIL|0\n"), RunTestTag, *Test.TestCommand, *Test.DisplayName);
+			MergedResults += Error + TEXT("\n");
+			AllSuccessful = false;
+
+			FTestMetrics& Metrics = OutMetrics.AddDefaulted_GetRef();
+			Metrics.TestCommand = Test.TestCommand;
+			Metrics.DisplayName = Test.DisplayName;
+			Metrics.Errors.Add(Error);
+		}
+	}
+
+	if (!FFileHelper::SaveStringToFile(MergedResults, *ResultsFile, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *ResultsFile);
+		return 1;
+	}
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Ran %d tests in %d shards in %.2fs, for %.2fs of test time (%.2fx speedup)."),
+		Tests.Num(), Workers.Num(), WallTime, TotalTestTime, WallTime > 0.0 ? TotalTestTime / WallTime : 0.0);
+
 	return AllSuccessful ? 0 : 1;
 }
 
@@ -184,6 +873,30 @@ UVSTestAdapterCommandlet::UVSTestAdapterCommandlet()
 	HelpParamNames.Add(FiltersParam);
 	HelpParamDescriptions.Add(TEXT("[Optional] List of test filters to enable separated by '+'. Default is 'application+smoke+product+perf+stress+negative'"));
 
+	HelpParamNames.Add(ShardsParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Split the tests across this many worker editor processes, scheduled by the durations of previous runs, and merge their results."));
+
+	HelpParamNames.Add(NoHistoryParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Don't record the test durations used to schedule the shards."));
+
+	HelpParamNames.Add(JUnitParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Also write the results, with the metrics of each test, to this file in the JUnit XML format."));
+
+	HelpParamNames.Add(MetricsFileParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Write the duration, peak memory delta, GC count and frame time distribution of each test to this JSON file."));
+
+	HelpParamNames.Add(PerfBaselineParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] JSON file with the duration and memory budget of the tests. Tests exceeding their budget fail."));
+
+	HelpParamNames.Add(PerfToleranceParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Percentage a test can exceed its budget by before failing. Default is 20."));
+
+	HelpParamNames.Add(UpdatePerfBaselineParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Store the metrics of the passing tests as their budget in the perf baseline file, instead of checking them."));
+
+	HelpParamNames.Add(TraceTestsParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Add trace bookmarks at the start and end of each test, to select them as a slice in Unreal Insights. Use with -trace."));
+
 	HelpParamNames.Add(HelpParam);
 	HelpParamDescriptions.Add(TEXT("[Optional] Print this help message and quit the commandlet immediately."));
 }
@@ -280,7 +993,74 @@ int32 UVSTestAdapterCommandlet::Main(const FString& Params)
 	}
 	else if (ParamVals.Contains(RunTestsParam) && ParamVals.Contains(TestResultsFileParam))
 	{
-		return RunTests(ParamVals[RunTestsParam], ParamVals[TestResultsFileParam]);
+		const FString& TestListFile = ParamVals[RunTestsParam];
+		const FString& ResultsFile = ParamVals[TestResultsFileParam];
+
+		const FString PerfBaselineFile = ParamVals.FindRef(PerfBaselineParam);
+		const bool bUpdatePerfBaseline = !PerfBaselineFile.IsEmpty() && Switches.Contains(UpdatePerfBaselineParam);
+
+		FTestRunOptions Options;
+		Options.bTraceTests = Switches.Contains(TraceTestsParam);
+		if (ParamVals.Contains(PerfToleranceParam))
+		{
+			Options.BudgetTolerance = FCString::Atod(*ParamVals[PerfToleranceParam]) / 100.0;
+		}
+
+		// The baseline is not checked while it's being updated.
+		if (!PerfBaselineFile.IsEmpty() && !bUpdatePerfBaseline)
+		{
+			LoadPerfBaseline(PerfBaselineFile, Options.Budgets);
+		}
+
+		TArray<FTestMetrics> Metrics;
+		const int32 NumShards = ParamVals.Contains(ShardsParam) ? FCString::Atoi(*ParamVals[ShardsParam]) : 1;
+		int32 Result = 0;
+		if (NumShards > 1)
+		{
+			FString WorkerArgs;
+			if (ParamVals.Contains(FiltersParam))
+			{
+				WorkerArgs += FString::Printf(TEXT(" -%s=%s"), FiltersParam, *ParamVals[FiltersParam]);
+			}
+
+			if (!PerfBaselineFile.IsEmpty() && !bUpdatePerfBaseline)
+			{
+				WorkerArgs += FString::Printf(TEXT(" -%s=\"%s\" -%s=%f"), PerfBaselineParam, *FPaths::ConvertRelativePathToFull(PerfBaselineFile), PerfToleranceParam, Options.BudgetTolerance * 100.0);
+			}
+
+			if (Options.bTraceTests)
+			{
+				WorkerArgs += FString::Printf(TEXT(" -%s"), TraceTestsParam);
+			}
+
+			Result = RunTestsSharded(TestListFile, ResultsFile, NumShards, WorkerArgs, Metrics);
+		}
+		else
+		{
+			Result = RunTests(TestListFile, ResultsFile, Options, Metrics);
+		}
+
+		if (!Switches.Contains(NoHistoryParam))
+		{
+			RecordTestDurations(ResultsFile);
+		}
+
+		if (ParamVals.Contains(MetricsFileParam) && !SaveTestMetrics(Metrics, ParamVals[MetricsFileParam]))
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to write the test metrics to path: %s"), *ParamVals[MetricsFileParam]);
+		}
+
+		if (ParamVals.Contains(JUnitParam) && !WriteJUnitResults(Metrics, ParamVals[JUnitParam]))
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to write the JUnit results to path: %s"), *ParamVals[JUnitParam]);
+		}
+
+		if (bUpdatePerfBaseline)
+		{
+			UpdatePerfBaseline(PerfBaselineFile, Metrics);
+		}
+
+		return Result;
 	}
 
 	PrintHelp();
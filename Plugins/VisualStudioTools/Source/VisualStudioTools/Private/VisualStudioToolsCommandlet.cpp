@@ -3,16 +3,21 @@
 #include "VisualStudioToolsCommandlet.h"
 
 #include "Algo/Transform.h"
+#include "Async/ParallelFor.h"
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "Blueprint/BlueprintSupport.h"
 #include "BlueprintAssetHelpers.h"
+#include "BlueprintIndexCache.h"
+#include "BlueprintIndexFormat.h"
 #include "Engine/BlueprintGeneratedClass.h"
+#include "HAL/PlatformTime.h"
 #include "JsonObjectConverter.h"
 #include "Misc/Paths.h"
 #include "Misc/ScopeExit.h"
 #include "Policies/CondensedJsonPrintPolicy.h"
 #include "SourceCodeNavigation.h"
 #include "UObject/CoreRedirects.h"
+#include "UObject/StrongObjectPtr.h"
 #include "UObject/UObjectIterator.h"
 #include "VisualStudioTools.h"
 
@@ -69,11 +74,13 @@ struct FPropertyEntry
 {
 	FProperty* Property;
 	TArray<int32> Blueprints;
+
+	/** Serialized values, in the same order as `Blueprints`. Null for properties that don't serialize their value. */
+	TArray<TSharedPtr<FJsonValue>> Values;
 };
 
 struct FFunctionEntry
 {
-	UFunction* Function;
 	TArray<int32> Blueprints;
 };
 
@@ -85,34 +92,83 @@ struct FClassEntry
 	TMap<FString, FFunctionEntry> Functions;
 };
 
+struct FBlueprintEntry
+{
+	FString Name;
+	FString Path;
+};
+
 using ClassMap = TMap<FString, FClassEntry>;
 
-struct FAssetIndex
+static bool ShouldSerializePropertyValue(FProperty* Property)
 {
-	TSet<FString> AssetPathCache;
-	ClassMap Classes;
-	TArray<const UClass*> Blueprints;
+	if (Property->ArrayDim > 1) // Skip properties that are not scalars
+	{
+		return false;
+	}
 
-	void ProcessBlueprint(const UBlueprintGeneratedClass* BlueprintGeneratedClass)
+	if (FEnumProperty* EnumProperty = CastField<FEnumProperty>(Property))
 	{
-		if (BlueprintGeneratedClass == nullptr)
+		return true;
+	}
+
+	if (FNumericProperty* NumericProperty = CastField<FNumericProperty>(Property))
+	{
+		UEnum* EnumDef = NumericProperty->GetIntPropertyEnum();
+		if (EnumDef != NULL)
 		{
-			return;
+			return true;
 		}
 
-		int32 BlueprintIndex = Blueprints.Num();
+		if (NumericProperty->IsFloatingPoint())
+		{
+			return true;
+		}
 
-		bool bHasAnyParent = FindBlueprintNativeParents(BlueprintGeneratedClass, [&](UClass* Parent)
+		if (NumericProperty->IsInteger())
 		{
-			FString ParentName = Parent->GetFName().ToString();
-			if (!Classes.Contains(ParentName))
-			{
-				Classes.Add(ParentName).Class = Parent;
-			}
+			return true;
+		}
+	}
 
-			FClassEntry& ClassEntry = Classes[ParentName];
+	if (FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+	{
+		return true;
+	}
 
-			ClassEntry.Blueprints.Add(BlueprintIndex);
+	if (FStrProperty* StringProperty = CastField<FStrProperty>(Property))
+	{
+		return true;
+	}
+
+	return false;
+}
+
+struct FAssetIndex
+{
+	ClassMap Classes;
+	TArray<FBlueprintEntry> Blueprints;
+
+	/**
+	* Collects the index data of a blueprint: the properties it changed and the functions it implemented
+	* for each of its native parents.
+	* Only reads the loaded classes and their CDOs, so it can run on worker threads for different blueprints.
+	*/
+	static FBlueprintData ProcessBlueprint(const UBlueprintGeneratedClass* BlueprintGeneratedClass)
+	{
+		FBlueprintData Data;
+		if (BlueprintGeneratedClass == nullptr)
+		{
+			return Data;
+		}
+
+		Data.Name = BlueprintGeneratedClass->GetName();
+		Data.Path = BlueprintGeneratedClass->GetPathName();
+
+		FindBlueprintNativeParents(BlueprintGeneratedClass, [&](UClass* Parent)
+		{
+			FBlueprintParentData& ParentData = Data.Parents.AddDefaulted_GetRef();
+			ParentData.ClassPath = Parent->GetPathName();
 
 			// Retrieve the properties from the parent class that changed in the Blueprint class, by comparing their CDOs.
 			UObject* GeneratedClassDefault = BlueprintGeneratedClass->ClassDefaultObject;
@@ -121,14 +177,14 @@ struct FAssetIndex
 
 			for (FProperty* Property : ChangedProperties)
 			{
-				FString PropertyName = Property->GetFName().ToString();
-				if (!ClassEntry.Properties.Contains(PropertyName))
+				TSharedPtr<FJsonValue> JsonValue;
+				if (ShouldSerializePropertyValue(Property))
 				{
-					ClassEntry.Properties.Add(PropertyName).Property = Property;
+					const uint8* PropData = Property->ContainerPtrToValuePtr<uint8>(GeneratedClassDefault);
+					JsonValue = FJsonObjectConverter::UPropertyToJsonValue(Property, PropData);
 				}
 
-				FPropertyEntry& PropEntry = ClassEntry.Properties[PropertyName];
-				PropEntry.Blueprints.Add(BlueprintIndex);
+				ParentData.Properties.Emplace(Property->GetFName().ToString(), JsonValue);
 			}
 
 			// Iterate over the functions originally from the parent class
@@ -142,87 +198,93 @@ struct FAssetIndex
 					continue;
 				}
 
-				FString FnName = Fn->GetFName().ToString();
-				if (!ClassEntry.Functions.Contains(FnName))
-				{
-					ClassEntry.Functions.Add(FnName).Function = Fn;
-				}
-
-				FFunctionEntry& FuncEntry = ClassEntry.Functions[FnName];
-				FuncEntry.Blueprints.Add(BlueprintIndex);
+				ParentData.Functions.Add(Fn->GetFName().ToString());
 			}
 		});
 
-		if (bHasAnyParent)
+		return Data;
+	}
+
+	/**
+	* Merges the data of a blueprint into the index.
+	* Blueprints without any native parent are skipped.
+	*/
+	void AddBlueprint(const FBlueprintData& Data)
+	{
+		int32 BlueprintIndex = Blueprints.Num();
+		bool bHasAnyParent = false;
+
+		for (const FBlueprintParentData& ParentData : Data.Parents)
 		{
-			check(Blueprints.Add(BlueprintGeneratedClass) == BlueprintIndex);
-		}
+			// Cached data might refer to a class that no longer exists.
+			UClass* Parent = FindObject<UClass>(nullptr, *ParentData.ClassPath);
+			if (Parent == nullptr)
+			{
+				continue;
+			}
 
-		return;
-	}
-};
+			bHasAnyParent = true;
 
-using JsonWriter = TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>;
+			FString ParentName = Parent->GetFName().ToString();
+			if (!Classes.Contains(ParentName))
+			{
+				Classes.Add(ParentName).Class = Parent;
+			}
 
-static bool ShouldSerializePropertyValue(FProperty* Property)
-{
-	if (Property->ArrayDim > 1) // Skip properties that are not scalars
-	{
-		return false;
-	}
+			FClassEntry& ClassEntry = Classes[ParentName];
 
-	if (FEnumProperty* EnumProperty = CastField<FEnumProperty>(Property))
-	{
-		return true;
-	}
+			ClassEntry.Blueprints.Add(BlueprintIndex);
 
-	if (FNumericProperty* NumericProperty = CastField<FNumericProperty>(Property))
-	{
-		UEnum* EnumDef = NumericProperty->GetIntPropertyEnum();
-		if (EnumDef != NULL)
-		{
-			return true;
-		}
+			for (const TPair<FString, TSharedPtr<FJsonValue>>& Item : ParentData.Properties)
+			{
+				const FString& PropertyName = Item.Key;
+				if (!ClassEntry.Properties.Contains(PropertyName))
+				{
+					FProperty* Property = Parent->FindPropertyByName(FName(*PropertyName));
+					if (Property == nullptr)
+					{
+						continue;
+					}
 
-		if (NumericProperty->IsFloatingPoint())
-		{
-			return true;
+					ClassEntry.Properties.Add(PropertyName).Property = Property;
+				}
+
+				FPropertyEntry& PropEntry = ClassEntry.Properties[PropertyName];
+				PropEntry.Blueprints.Add(BlueprintIndex);
+				PropEntry.Values.Add(Item.Value);
+			}
+
+			for (const FString& FnName : ParentData.Functions)
+			{
+				FFunctionEntry& FuncEntry = ClassEntry.Functions.FindOrAdd(FnName);
+				FuncEntry.Blueprints.Add(BlueprintIndex);
+			}
 		}
 
-		if (NumericProperty->IsInteger())
+		if (bHasAnyParent)
 		{
-			return true;
+			Blueprints.Add({ Data.Name, Data.Path });
 		}
 	}
+};
 
-	if (FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
-	{
-		return true;
-	}
-
-	if (FStrProperty* StringProperty = CastField<FStrProperty>(Property))
-	{
-		return true;
-	}
-
-	return false;
-}
+using JsonWriter = TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>;
 
-static void SerializeBlueprints(TSharedRef<JsonWriter>& Json, TArray<const UClass*> Items)
+static void SerializeBlueprints(TSharedRef<JsonWriter>& Json, const TArray<FBlueprintEntry>& Items)
 {
 	Json->WriteArrayStart();
-	for (const UClass* Blueprint : Items)
+	for (const FBlueprintEntry& Blueprint : Items)
 	{
 		Json->WriteObjectStart();
 
-		Json->WriteValue(TEXT("name"), Blueprint->GetName());
-		Json->WriteValue(TEXT("path"), Blueprint->GetPathName());
+		Json->WriteValue(TEXT("name"), Blueprint.Name);
+		Json->WriteValue(TEXT("path"), Blueprint.Path);
 		Json->WriteObjectEnd();
 	}
 	Json->WriteArrayEnd();
 }
 
-static void SerializeProperties(TSharedRef<JsonWriter>& Json, FClassEntry& Entry, TArray<const UClass*>& Blueprints)
+static void SerializeProperties(TSharedRef<JsonWriter>& Json, FClassEntry& Entry)
 {
 	Json->WriteArrayStart();
 	for (auto& Item : Entry.Properties)
@@ -248,18 +310,15 @@ static void SerializeProperties(TSharedRef<JsonWriter>& Json, FClassEntry& Entry
 		Json->WriteIdentifierPrefix(TEXT("values"));
 		{
 			Json->WriteArrayStart();
-			for (auto& BlueprintEntry : PropEntry.Blueprints)
+			for (int32 Idx = 0; Idx < PropEntry.Blueprints.Num(); Idx++)
 			{
 				Json->WriteObjectStart();
 
-				Json->WriteValue(TEXT("blueprint"), BlueprintEntry);
+				Json->WriteValue(TEXT("blueprint"), PropEntry.Blueprints[Idx]);
 
-				UObject* GeneratedClassDefault = Blueprints[BlueprintEntry]->ClassDefaultObject;
-				const uint8* PropData = PropEntry.Property->ContainerPtrToValuePtr<uint8>(GeneratedClassDefault);
-
-				if (ShouldSerializePropertyValue(PropEntry.Property))
+				const TSharedPtr<FJsonValue>& JsonValue = PropEntry.Values[Idx];
+				if (JsonValue.IsValid())
 				{
-					TSharedPtr<FJsonValue> JsonValue = FJsonObjectConverter::UPropertyToJsonValue(Property, PropData);
 					FJsonSerializer::Serialize(JsonValue.ToSharedRef(), TEXT("value"), Json);
 				}
 
@@ -288,7 +347,7 @@ static void SerializeFunctions(TSharedRef<JsonWriter>& Json, FClassEntry& Entry)
 	Json->WriteArrayEnd();
 }
 
-static void SerializeClasses(TSharedRef<JsonWriter>& Json, ClassMap& Items, TArray<const UClass*> Blueprints)
+static void SerializeClasses(TSharedRef<JsonWriter>& Json, ClassMap& Items)
 {
 	Json->WriteArrayStart();
 	for (auto& Item : Items)
@@ -301,7 +360,7 @@ static void SerializeClasses(TSharedRef<JsonWriter>& Json, ClassMap& Items, TArr
 		Json->WriteValue(TEXT("blueprints"), Entry.Blueprints);
 
 		Json->WriteIdentifierPrefix(TEXT("properties"));
-		SerializeProperties(Json, Entry, Blueprints);
+		SerializeProperties(Json, Entry);
 
 		Json->WriteIdentifierPrefix(TEXT("functions"));
 		SerializeFunctions(Json, Entry);
@@ -311,7 +370,7 @@ static void SerializeClasses(TSharedRef<JsonWriter>& Json, ClassMap& Items, TArr
 	Json->WriteArrayEnd();
 }
 
-static void SerializeToIndex(FAssetIndex Index, FArchive& IndexFile)
+static void SerializeToIndex(FAssetIndex& Index, FArchive& IndexFile)
 {
 	TSharedRef<JsonWriter> Json = JsonWriter::Create(&IndexFile);
 
@@ -321,12 +380,237 @@ static void SerializeToIndex(FAssetIndex Index, FArchive& IndexFile)
 	SerializeBlueprints(Json, Index.Blueprints);
 
 	Json->WriteIdentifierPrefix(TEXT("classes"));
-	SerializeClasses(Json, Index.Classes, Index.Blueprints);
+	SerializeClasses(Json, Index.Classes);
 
 	Json->WriteObjectEnd();
 	Json->Close();
 }
 
+/**
+* String table of the binary index. Repeated strings share the same offset.
+*/
+struct FBinaryStringTable
+{
+	TArray<uint8> Data;
+	TMap<FString, uint32> Offsets;
+
+	uint32 Add(const FString& String)
+	{
+		if (const uint32* Found = Offsets.Find(String))
+		{
+			return *Found;
+		}
+
+		const uint32 Offset = static_cast<uint32>(Data.Num());
+		FTCHARToUTF8 Utf8String(*String);
+		const uint32 Length = static_cast<uint32>(Utf8String.Length());
+
+		Data.Append(reinterpret_cast<const uint8*>(&Length), sizeof(Length));
+		Data.Append(reinterpret_cast<const uint8*>(Utf8String.Get()), Length);
+		Data.Add(0);
+
+		Offsets.Add(String, Offset);
+		return Offset;
+	}
+};
+
+template <typename RecordType>
+static void WriteRecord(FArchive& Archive, RecordType Record)
+{
+	Archive.Serialize(&Record, sizeof(RecordType));
+}
+
+static BlueprintIndexFormat::FValueRecord MakeValueRecord(
+	int32 BlueprintIndex, const TSharedPtr<FJsonValue>& JsonValue, FBinaryStringTable& Strings)
+{
+	using namespace BlueprintIndexFormat;
+
+	FValueRecord Record = {};
+	Record.Blueprint = static_cast<uint32>(BlueprintIndex);
+	Record.Type = EValueType::None;
+
+	if (!JsonValue.IsValid())
+	{
+		return Record;
+	}
+
+	switch (JsonValue->Type)
+	{
+	case EJson::Boolean:
+		Record.Type = EValueType::Bool;
+		Record.Payload = JsonValue->AsBool() ? 1 : 0;
+		break;
+	case EJson::Number:
+	{
+		double Number = JsonValue->AsNumber();
+		Record.Type = EValueType::Number;
+		FMemory::Memcpy(&Record.Payload, &Number, sizeof(Number));
+		break;
+	}
+	case EJson::String:
+		Record.Type = EValueType::String;
+		Record.Payload = Strings.Add(JsonValue->AsString());
+		break;
+	default:
+		break;
+	}
+
+	return Record;
+}
+
+/**
+* Writes the index in the compact binary format described in `BlueprintIndexFormat.h`.
+* The record tables are written straight to the archive, and only the string table is kept in memory until the end.
+*/
+static void SerializeToBinaryIndex(FAssetIndex& Index, FArchive& IndexFile)
+{
+	using namespace BlueprintIndexFormat;
+
+	// Sort the classes by name, so readers can look them up with a binary search.
+	TArray<TPair<FString, FClassEntry*>> Classes;
+	for (auto& Item : Index.Classes)
+	{
+		const UClass* Class = Item.Value.Class;
+		Classes.Emplace(FString::Printf(TEXT("%s%s"), Class->GetPrefixCPP(), *Class->GetName()), &Item.Value);
+	}
+
+	Classes.Sort([](const TPair<FString, FClassEntry*>& A, const TPair<FString, FClassEntry*>& B)
+		{
+			return A.Key.Compare(B.Key, ESearchCase::CaseSensitive) < 0;
+		});
+
+	FHeader Header = {};
+	Header.Magic = Magic;
+	Header.Version = Version;
+	Header.NumBlueprints = static_cast<uint32>(Index.Blueprints.Num());
+	Header.NumClasses = static_cast<uint32>(Classes.Num());
+
+	for (const TPair<FString, FClassEntry*>& Item : Classes)
+	{
+		const FClassEntry& Entry = *Item.Value;
+		Header.NumProperties += static_cast<uint32>(Entry.Properties.Num());
+		Header.NumFunctions += static_cast<uint32>(Entry.Functions.Num());
+		Header.NumIndices += static_cast<uint32>(Entry.Blueprints.Num());
+
+		for (const auto& PropItem : Entry.Properties)
+		{
+			Header.NumValues += static_cast<uint32>(PropItem.Value.Blueprints.Num());
+		}
+
+		for (const auto& FnItem : Entry.Functions)
+		{
+			Header.NumIndices += static_cast<uint32>(FnItem.Value.Blueprints.Num());
+		}
+	}
+
+	Header.StringsOffset = static_cast<uint32>(sizeof(FHeader)
+		+ Header.NumBlueprints * sizeof(FBlueprintRecord)
+		+ Header.NumClasses * sizeof(FClassRecord)
+		+ Header.NumProperties * sizeof(FPropertyRecord)
+		+ Header.NumValues * sizeof(FValueRecord)
+		+ Header.NumFunctions * sizeof(FFunctionRecord)
+		+ Header.NumIndices * sizeof(uint32));
+
+	WriteRecord(IndexFile, Header);
+
+	FBinaryStringTable Strings;
+
+	for (const FBlueprintEntry& Blueprint : Index.Blueprints)
+	{
+		WriteRecord(IndexFile, FBlueprintRecord{ Strings.Add(Blueprint.Name), Strings.Add(Blueprint.Path) });
+	}
+
+	// The index table holds the blueprints of every class, followed by the blueprints of every function.
+	uint32 NextIndex = 0;
+	uint32 NextProperty = 0;
+	uint32 NextFunction = 0;
+	for (const TPair<FString, FClassEntry*>& Item : Classes)
+	{
+		const FClassEntry& Entry = *Item.Value;
+
+		FClassRecord Record = {};
+		Record.Name = Strings.Add(Item.Key);
+		Record.FirstBlueprint = NextIndex;
+		Record.NumBlueprints = static_cast<uint32>(Entry.Blueprints.Num());
+		Record.FirstProperty = NextProperty;
+		Record.NumProperties = static_cast<uint32>(Entry.Properties.Num());
+		Record.FirstFunction = NextFunction;
+		Record.NumFunctions = static_cast<uint32>(Entry.Functions.Num());
+		WriteRecord(IndexFile, Record);
+
+		NextIndex += Record.NumBlueprints;
+		NextProperty += Record.NumProperties;
+		NextFunction += Record.NumFunctions;
+	}
+
+	uint32 NextValue = 0;
+	for (const TPair<FString, FClassEntry*>& Item : Classes)
+	{
+		for (const auto& PropItem : Item.Value->Properties)
+		{
+			const FPropertyEntry& PropEntry = PropItem.Value;
+
+			FPropertyRecord Record = {};
+			Record.Name = Strings.Add(PropItem.Key);
+			Record.Categories = PropEntry.Property->HasMetaData(CategoryFName)
+				? Strings.Add(PropEntry.Property->GetMetaData(CategoryFName))
+				: NoString;
+			Record.FirstValue = NextValue;
+			Record.NumValues = static_cast<uint32>(PropEntry.Blueprints.Num());
+			WriteRecord(IndexFile, Record);
+
+			NextValue += Record.NumValues;
+		}
+	}
+
+	for (const TPair<FString, FClassEntry*>& Item : Classes)
+	{
+		for (const auto& PropItem : Item.Value->Properties)
+		{
+			const FPropertyEntry& PropEntry = PropItem.Value;
+			for (int32 Idx = 0; Idx < PropEntry.Blueprints.Num(); Idx++)
+			{
+				WriteRecord(IndexFile, MakeValueRecord(PropEntry.Blueprints[Idx], PropEntry.Values[Idx], Strings));
+			}
+		}
+	}
+
+	for (const TPair<FString, FClassEntry*>& Item : Classes)
+	{
+		for (const auto& FnItem : Item.Value->Functions)
+		{
+			FFunctionRecord Record = {};
+			Record.Name = Strings.Add(FnItem.Key);
+			Record.FirstBlueprint = NextIndex;
+			Record.NumBlueprints = static_cast<uint32>(FnItem.Value.Blueprints.Num());
+			WriteRecord(IndexFile, Record);
+
+			NextIndex += Record.NumBlueprints;
+		}
+	}
+
+	for (const TPair<FString, FClassEntry*>& Item : Classes)
+	{
+		for (int32 BlueprintIndex : Item.Value->Blueprints)
+		{
+			WriteRecord(IndexFile, static_cast<uint32>(BlueprintIndex));
+		}
+	}
+
+	for (const TPair<FString, FClassEntry*>& Item : Classes)
+	{
+		for (const auto& FnItem : Item.Value->Functions)
+		{
+			for (int32 BlueprintIndex : FnItem.Value.Blueprints)
+			{
+				WriteRecord(IndexFile, static_cast<uint32>(BlueprintIndex));
+			}
+		}
+	}
+
+	IndexFile.Serialize(Strings.Data.GetData(), Strings.Data.Num());
+}
+
 static TArray<FString> GetModulesByPath(const FString& InDir)
 {
 	TArray<FString> OutResult;
@@ -373,9 +657,15 @@ static void GetNativeClassesByPath(const FString& InDir, TArray<TWeakObjectPtr<U
 	}
 }
 
+/** Number of loaded blueprints processed together on worker threads. */
+static constexpr int32 ProcessBatchSize = 256;
+
 static void RunAssetScan(
 	FAssetIndex& Index,
-	const TArray<TWeakObjectPtr<UClass>>& FilterBaseClasses)
+	const TArray<TWeakObjectPtr<UClass>>& FilterBaseClasses,
+	const AssetHelpers::FForEachAssetOptions& LoadOptions,
+	FBlueprintIndexCache* Cache,
+	bool bParallel)
 {
 	FARFilter Filter;
 	Filter.bRecursivePaths = true;
@@ -412,17 +702,115 @@ static void RunAssetScan(
 	TArray<FAssetData> TargetAssets;
 	AssetRegistry.GetAssets(Filter, TargetAssets);
 
-	AssetHelpers::ForEachAsset(TargetAssets,
-		[&](UBlueprintGeneratedClass* BlueprintGeneratedClass, const FAssetData& /*AssetData*/)
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Serve the unchanged blueprints from the cache, and only load the remaining ones.
+	TArray<FBlueprintData> Results;
+	Results.SetNum(TargetAssets.Num());
+
+	TArray<FString> PackageKeys;
+	PackageKeys.SetNum(TargetAssets.Num());
+
+	TArray<FAssetData> DirtyAssets;
+	TMap<FName, int32> DirtyAssetIndices;
+
+	for (int32 Idx = 0; Idx < TargetAssets.Num(); Idx++)
+	{
+		const FAssetData& AssetData = TargetAssets[Idx];
+		if (Cache != nullptr)
 		{
-			Index.ProcessBlueprint(BlueprintGeneratedClass);
-		});
+			PackageKeys[Idx] = Cache->GetPackageKey(AssetData);
+			if (const FBlueprintData* CachedData = Cache->Find(AssetData.PackageName.ToString(), PackageKeys[Idx]))
+			{
+				Results[Idx] = *CachedData;
+				continue;
+			}
+		}
+
+		DirtyAssets.Add(AssetData);
+		DirtyAssetIndices.Add(AssetData.PackageName, Idx);
+	}
+
+	// The loaded blueprints are processed in batches on worker threads, while the game thread keeps loading.
+	// Each blueprint writes only its own result, and the results are merged into the index afterwards.
+	// The pending classes are kept alive until their batch is processed. The batch is also processed
+	// before ForEachAsset collects garbage, so the collection isn't held back by up to a full batch of classes.
+	TArray<TPair<int32, TStrongObjectPtr<UBlueprintGeneratedClass>>> PendingBlueprints;
+	double ProcessTime = 0.0;
+
+	auto ProcessPendingBlueprints = [&]()
+	{
+		const double ProcessStartTime = FPlatformTime::Seconds();
+
+		ParallelFor(PendingBlueprints.Num(), [&](int32 PendingIdx)
+			{
+				const TPair<int32, TStrongObjectPtr<UBlueprintGeneratedClass>>& Pending = PendingBlueprints[PendingIdx];
+				Results[Pending.Key] = FAssetIndex::ProcessBlueprint(Pending.Value.Get());
+			},
+			!bParallel);
+
+		// The cache is not thread safe, so it's updated on the game thread.
+		if (Cache != nullptr)
+		{
+			for (const TPair<int32, TStrongObjectPtr<UBlueprintGeneratedClass>>& Pending : PendingBlueprints)
+			{
+				if (!PackageKeys[Pending.Key].IsEmpty())
+				{
+					Cache->Add(TargetAssets[Pending.Key].PackageName.ToString(), PackageKeys[Pending.Key], Results[Pending.Key]);
+				}
+			}
+		}
+
+		PendingBlueprints.Reset();
+		ProcessTime += FPlatformTime::Seconds() - ProcessStartTime;
+	};
+
+	AssetHelpers::FForEachAssetOptions ScanLoadOptions = LoadOptions;
+	ScanLoadOptions.OnBeforeGarbageCollection = [&ProcessPendingBlueprints]()
+	{
+		ProcessPendingBlueprints();
+	};
+
+	AssetHelpers::ForEachAsset(DirtyAssets,
+		[&](UBlueprintGeneratedClass* BlueprintGeneratedClass, const FAssetData& AssetData)
+		{
+			const int32 Idx = DirtyAssetIndices.FindChecked(AssetData.PackageName);
+			PendingBlueprints.Emplace(Idx, TStrongObjectPtr<UBlueprintGeneratedClass>(BlueprintGeneratedClass));
+
+			if (PendingBlueprints.Num() >= ProcessBatchSize)
+			{
+				ProcessPendingBlueprints();
+			}
+		},
+		ScanLoadOptions);
+
+	ProcessPendingBlueprints();
+
+	// Merge in the original order, so the output doesn't depend on which blueprints were cached.
+	for (const FBlueprintData& Data : Results)
+	{
+		Index.AddBlueprint(Data);
+	}
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Indexed %d blueprints in %.2fs, %d served from cache."),
+		TargetAssets.Num(),
+		FPlatformTime::Seconds() - StartTime,
+		TargetAssets.Num() - DirtyAssets.Num());
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Processed %d loaded blueprints in %.2fs (%s)."),
+		DirtyAssets.Num(), ProcessTime, bParallel ? TEXT("parallel") : TEXT("single threaded"));
 }
 
 } // namespace VS
 
 static constexpr auto FilterSwitch = TEXT("filter");
 static constexpr auto FullSwitch = TEXT("full");
+static constexpr auto LoadWindowSwitch = TEXT("loadwindow");
+static constexpr auto MemoryCeilingSwitch = TEXT("memoryceiling");
+static constexpr auto CacheSwitch = TEXT("cache");
+static constexpr auto NoCacheSwitch = TEXT("nocache");
+static constexpr auto FormatSwitch = TEXT("format");
+static constexpr auto SingleThreadSwitch = TEXT("singlethread");
 
 UVisualStudioToolsCommandlet::UVisualStudioToolsCommandlet()
 	: Super()
@@ -435,7 +823,25 @@ UVisualStudioToolsCommandlet::UVisualStudioToolsCommandlet()
 	HelpParamNames.Add(FullSwitch);
 	HelpParamDescriptions.Add(TEXT("[Optional] Scan blueprints derived from native classes from ALL modules, include the Engine. This can be _very slow_ for large projects. Incompatible with `-filter`."));
 
-	HelpUsage = TEXT("<Editor-Cmd.exe> <path_to_uproject> -run=VisualStudioTools -output=<path_to_output_file> [-filter=<subdir_native_classes>|-full] [-unattended -noshadercompile -nosound -nullrhi -nocpuprofilertrace -nocrashreports -nosplash]");
+	HelpParamNames.Add(LoadWindowSwitch);
+	HelpParamDescriptions.Add(TEXT("[Optional] Number of blueprints to load asynchronously ahead of the one being indexed. Defaults to 32."));
+
+	HelpParamNames.Add(MemoryCeilingSwitch);
+	HelpParamDescriptions.Add(TEXT("[Optional] Memory ceiling in MiB. When the editor uses more physical memory than this while loading blueprints, the loaded blueprints are garbage collected, and again each time it grows by another 256 MiB. Disabled by default."));
+
+	HelpParamNames.Add(CacheSwitch);
+	HelpParamDescriptions.Add(TEXT("[Optional] The file path of the cache used to skip loading unchanged blueprints. Defaults to `<ProjectIntermediateDir>/VisualStudioTools/BlueprintIndexCache.json`."));
+
+	HelpParamNames.Add(FormatSwitch);
+	HelpParamDescriptions.Add(TEXT("[Optional] The output format, `json` or `binary`. The binary format is described in `BlueprintIndexFormat.h`. Defaults to `json`."));
+
+	HelpParamNames.Add(NoCacheSwitch);
+	HelpParamDescriptions.Add(TEXT("[Optional] Load every blueprint, without reading or writing the cache. Incompatible with `-cache`."));
+
+	HelpParamNames.Add(SingleThreadSwitch);
+	HelpParamDescriptions.Add(TEXT("[Optional] Process the loaded blueprints on the game thread only, instead of on worker threads."));
+
+	HelpUsage = TEXT("<Editor-Cmd.exe> <path_to_uproject> -run=VisualStudioTools -output=<path_to_output_file> [-filter=<subdir_native_classes>|-full] [-loadwindow=<count>] [-memoryceiling=<MiB>] [-cache=<path_to_cache_file>|-nocache] [-format=<json|binary>] [-singlethread] [-unattended -noshadercompile -nosound -nullrhi -nocpuprofilertrace -nocrashreports -nosplash]");
 }
 
 int32 UVisualStudioToolsCommandlet::Run(
@@ -483,9 +889,74 @@ int32 UVisualStudioToolsCommandlet::Run(
 		}
 	}
 
+	const FString Format = ParamVals.Contains(FormatSwitch) ? ParamVals[FormatSwitch] : TEXT("json");
+	const bool bBinaryFormat = Format == TEXT("binary");
+
+	if (!bBinaryFormat && Format != TEXT("json"))
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Unknown output format: %s."), *Format);
+		PrintHelp();
+		return -1;
+	}
+
+	AssetHelpers::FForEachAssetOptions LoadOptions;
+	if (const FString* LoadWindow = ParamVals.Find(LoadWindowSwitch))
+	{
+		LoadOptions.LoadWindow = FCString::Atoi(**LoadWindow);
+	}
+
+	if (const FString* MemoryCeiling = ParamVals.Find(MemoryCeilingSwitch))
+	{
+		LoadOptions.MemoryCeiling = FMath::Max<int64>(FCString::Atoi64(**MemoryCeiling), 0) * 1024 * 1024;
+	}
+
+	FString* CachePath = ParamVals.Find(CacheSwitch);
+	const bool bNoCache = Switches.Contains(NoCacheSwitch);
+
+	if (CachePath != nullptr && bNoCache)
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Incompatible cache options."));
+		PrintHelp();
+		return -1;
+	}
+
+	const FString CacheFilePath = CachePath != nullptr
+		? *CachePath
+		: FPaths::Combine(FPaths::ProjectIntermediateDir(), TEXT("VisualStudioTools"), TEXT("BlueprintIndexCache.json"));
+
+	FBlueprintIndexCache Cache;
+	if (!bNoCache)
+	{
+		Cache.Load(CacheFilePath);
+	}
+
 	FAssetIndex Index;
-	RunAssetScan(Index, FilterBaseClasses);
-	SerializeToIndex(Index, OutArchive);
+	RunAssetScan(Index, FilterBaseClasses, LoadOptions, bNoCache ? nullptr : &Cache, !Switches.Contains(SingleThreadSwitch));
+
+	const double SerializeStartTime = FPlatformTime::Seconds();
+	if (bBinaryFormat)
+	{
+		SerializeToBinaryIndex(Index, OutArchive);
+	}
+	else
+	{
+		SerializeToIndex(Index, OutArchive);
+	}
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Wrote %s index: %lld bytes in %.3fs."), *Format, OutArchive.Tell(), FPlatformTime::Seconds() - SerializeStartTime);
+
+	if (!bNoCache)
+	{
+		// Don't keep the entries of deleted or renamed blueprints around forever.
+		const int32 NumRemoved = Cache.RemoveMissingPackages();
+		if (NumRemoved > 0)
+		{
+			UE_LOG(LogVisualStudioTools, Display, TEXT("Removed %d blueprints that no longer exist from the cache."), NumRemoved);
+		}
+
+		Cache.Save(CacheFilePath);
+	}
+
 	UE_LOG(LogVisualStudioTools, Display, TEXT("Found %d blueprints."), Index.Blueprints.Num());
 
 	return 0;
@@ -3,13 +3,17 @@
 
 #include "VisualStudioToolsCommandletBase.h"
 
+#if PLATFORM_WINDOWS
 #include "Windows/AllowWindowsPlatformTypes.h"
+#endif
 
 #include "HAL/FileManager.h"
 #include "Misc/Paths.h"
 #include "VisualStudioTools.h"
 
+#if PLATFORM_WINDOWS
 #include "Windows/HideWindowsPlatformTypes.h"
+#endif
 
 static constexpr auto HelpSwitch = TEXT("help");
 static constexpr auto OutputSwitch = TEXT("output");
@@ -0,0 +1,308 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+// This header doesn't depend on the engine, so the IDE can use it to read the index files directly.
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+* Compact binary layout of the blueprint index, written by the VisualStudioTools commandlet with `-format=binary`.
+* It holds the same data as the JSON index, but can be memory-mapped and queried without parsing the whole file.
+*
+* The file is little-endian and made of fixed-size record tables followed by a string table:
+*   FHeader | FBlueprintRecord[] | FClassRecord[] | FPropertyRecord[] | FValueRecord[] | FFunctionRecord[] | uint32_t[] | strings
+* Records reference strings by their offset in the string table, where each string is stored
+* as a uint32_t length followed by the UTF-8 characters and a null terminator.
+* Classes are sorted by name, so a single class can be looked up with a binary search.
+*/
+namespace VisualStudioTools
+{
+namespace BlueprintIndexFormat
+{
+static constexpr uint32_t Magic = 0x49425356; // "VSBI"
+static constexpr uint32_t Version = 1;
+
+/** String offset used for missing strings. */
+static constexpr uint32_t NoString = 0xFFFFFFFF;
+
+struct FHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t NumBlueprints;
+	uint32_t NumClasses;
+	uint32_t NumProperties;
+	uint32_t NumValues;
+	uint32_t NumFunctions;
+	uint32_t NumIndices;
+	uint32_t StringsOffset;
+	uint32_t Padding;
+};
+
+struct FBlueprintRecord
+{
+	uint32_t Name;
+	uint32_t Path;
+};
+
+struct FClassRecord
+{
+	uint32_t Name;
+
+	/** Range in the index table with the blueprints deriving from this class. */
+	uint32_t FirstBlueprint;
+	uint32_t NumBlueprints;
+
+	/** Ranges in the property and function tables. */
+	uint32_t FirstProperty;
+	uint32_t NumProperties;
+	uint32_t FirstFunction;
+	uint32_t NumFunctions;
+
+	uint32_t Padding;
+};
+
+struct FPropertyRecord
+{
+	uint32_t Name;
+	uint32_t Categories;
+
+	/** Range in the value table, one per blueprint that changed the property. */
+	uint32_t FirstValue;
+	uint32_t NumValues;
+};
+
+enum class EValueType : uint32_t
+{
+	/** The blueprint changed the property, but its value is not serialized. */
+	None,
+	Bool,
+	Number,
+	String,
+};
+
+struct FValueRecord
+{
+	uint32_t Blueprint;
+	EValueType Type;
+
+	/** The bool as 0 or 1, the bits of the double, or the string offset, depending on `Type`. */
+	uint64_t Payload;
+};
+
+struct FFunctionRecord
+{
+	uint32_t Name;
+
+	/** Range in the index table with the blueprints implementing this function. */
+	uint32_t FirstBlueprint;
+	uint32_t NumBlueprints;
+
+	uint32_t Padding;
+};
+
+static_assert(sizeof(FHeader) == 40, "Record layout is part of the file format.");
+static_assert(sizeof(FBlueprintRecord) == 8, "Record layout is part of the file format.");
+static_assert(sizeof(FClassRecord) == 32, "Record layout is part of the file format.");
+static_assert(sizeof(FPropertyRecord) == 16, "Record layout is part of the file format.");
+static_assert(sizeof(FValueRecord) == 16, "Record layout is part of the file format.");
+static_assert(sizeof(FFunctionRecord) == 16, "Record layout is part of the file format.");
+
+/**
+* Read-only view over an index file loaded or mapped in memory.
+* The memory must outlive the reader and every string view returned by it.
+*/
+class FReader
+{
+public:
+	/**
+	* Validates the header and the table bounds. Returns false, leaving the reader empty, if the data is not a compatible index.
+	* Opening doesn't depend on the size of the index: the ranges and indices stored in the records are checked when they are read.
+	*/
+	bool Open(const void* InData, size_t InSize)
+	{
+		// Leave the reader empty on failure, so the accessors can't read through a bad header or a dangling pointer.
+		if (!Validate(InData, InSize))
+		{
+			*this = FReader();
+			return false;
+		}
+
+		return true;
+	}
+
+	uint32_t GetNumBlueprints() const { return Header.NumBlueprints; }
+	uint32_t GetNumClasses() const { return Header.NumClasses; }
+
+	/**
+	* Record accessors. Out of range indices return a zeroed record, or a blueprint with missing strings.
+	* Ranges that don't fit in their table are returned empty, so walking them can't read past the tables.
+	*/
+	FBlueprintRecord GetBlueprint(uint32_t Index) const
+	{
+		if (Index >= Header.NumBlueprints)
+		{
+			return { NoString, NoString };
+		}
+
+		return ReadRecord<FBlueprintRecord>(BlueprintsOffset, Header.NumBlueprints, Index);
+	}
+
+	FClassRecord GetClass(uint32_t Index) const
+	{
+		FClassRecord Class = ReadRecord<FClassRecord>(ClassesOffset, Header.NumClasses, Index);
+		ClampRange(Class.FirstBlueprint, Class.NumBlueprints, Header.NumIndices);
+		ClampRange(Class.FirstProperty, Class.NumProperties, Header.NumProperties);
+		ClampRange(Class.FirstFunction, Class.NumFunctions, Header.NumFunctions);
+		return Class;
+	}
+
+	FPropertyRecord GetProperty(uint32_t Index) const
+	{
+		FPropertyRecord Property = ReadRecord<FPropertyRecord>(PropertiesOffset, Header.NumProperties, Index);
+		ClampRange(Property.FirstValue, Property.NumValues, Header.NumValues);
+		return Property;
+	}
+
+	FFunctionRecord GetFunction(uint32_t Index) const
+	{
+		FFunctionRecord Function = ReadRecord<FFunctionRecord>(FunctionsOffset, Header.NumFunctions, Index);
+		ClampRange(Function.FirstBlueprint, Function.NumBlueprints, Header.NumIndices);
+		return Function;
+	}
+
+	/** Blueprint indices stored in values and in the index table aren't checked here: GetBlueprint handles out of range ones. */
+	FValueRecord GetValue(uint32_t Index) const { return ReadRecord<FValueRecord>(ValuesOffset, Header.NumValues, Index); }
+	uint32_t GetIndex(uint32_t Index) const { return ReadRecord<uint32_t>(IndicesOffset, Header.NumIndices, Index); }
+
+	/** Returns the string at an offset of the string table, or an empty view if it's missing or out of bounds. */
+	std::string_view GetString(uint32_t StringOffset) const
+	{
+		uint64_t Offset = uint64_t(Header.StringsOffset) + StringOffset;
+		if (StringOffset == NoString || Offset + sizeof(uint32_t) > Size)
+		{
+			return std::string_view();
+		}
+
+		uint32_t Length;
+		std::memcpy(&Length, Data + Offset, sizeof(uint32_t));
+		Offset += sizeof(uint32_t);
+
+		if (Offset + Length > Size)
+		{
+			return std::string_view();
+		}
+
+		return std::string_view(reinterpret_cast<const char*>(Data + Offset), Length);
+	}
+
+	/** Finds a class by its prefixed name (e.g. `AActor`). Returns false if it's not in the index. */
+	bool FindClass(std::string_view ClassName, FClassRecord& OutClass) const
+	{
+		uint32_t First = 0;
+		uint32_t Last = Header.NumClasses;
+		while (First < Last)
+		{
+			uint32_t Middle = First + (Last - First) / 2;
+			FClassRecord Class = GetClass(Middle);
+
+			int Compare = GetString(Class.Name).compare(ClassName);
+			if (Compare == 0)
+			{
+				OutClass = Class;
+				return true;
+			}
+
+			if (Compare < 0)
+			{
+				First = Middle + 1;
+			}
+			else
+			{
+				Last = Middle;
+			}
+		}
+
+		return false;
+	}
+
+private:
+	bool Validate(const void* InData, size_t InSize)
+	{
+		Data = static_cast<const uint8_t*>(InData);
+		Size = InSize;
+
+		if (Data == nullptr || Size < sizeof(FHeader))
+		{
+			return false;
+		}
+
+		std::memcpy(&Header, Data, sizeof(FHeader));
+		if (Header.Magic != Magic || Header.Version != Version)
+		{
+			return false;
+		}
+
+		uint64_t Offset = sizeof(FHeader);
+		BlueprintsOffset = Offset;
+		Offset += uint64_t(Header.NumBlueprints) * sizeof(FBlueprintRecord);
+		ClassesOffset = Offset;
+		Offset += uint64_t(Header.NumClasses) * sizeof(FClassRecord);
+		PropertiesOffset = Offset;
+		Offset += uint64_t(Header.NumProperties) * sizeof(FPropertyRecord);
+		ValuesOffset = Offset;
+		Offset += uint64_t(Header.NumValues) * sizeof(FValueRecord);
+		FunctionsOffset = Offset;
+		Offset += uint64_t(Header.NumFunctions) * sizeof(FFunctionRecord);
+		IndicesOffset = Offset;
+		Offset += uint64_t(Header.NumIndices) * sizeof(uint32_t);
+
+		if (Offset != Header.StringsOffset || Offset > Size)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	/** Empties a range that doesn't fit in its table. */
+	static void ClampRange(uint32_t& First, uint32_t& Num, uint32_t TableSize)
+	{
+		if (uint64_t(First) + Num > TableSize)
+		{
+			First = 0;
+			Num = 0;
+		}
+	}
+
+	template <typename RecordType>
+	RecordType ReadRecord(uint64_t TableOffset, uint32_t NumRecords, uint32_t Index) const
+	{
+		RecordType Record = {};
+		if (Index >= NumRecords)
+		{
+			return Record;
+		}
+
+		std::memcpy(&Record, Data + TableOffset + uint64_t(Index) * sizeof(RecordType), sizeof(RecordType));
+		return Record;
+	}
+
+	const uint8_t* Data = nullptr;
+	size_t Size = 0;
+	FHeader Header = {};
+
+	uint64_t BlueprintsOffset = 0;
+	uint64_t ClassesOffset = 0;
+	uint64_t PropertiesOffset = 0;
+	uint64_t ValuesOffset = 0;
+	uint64_t FunctionsOffset = 0;
+	uint64_t IndicesOffset = 0;
+};
+
+} // namespace BlueprintIndexFormat
+} // namespace VisualStudioTools
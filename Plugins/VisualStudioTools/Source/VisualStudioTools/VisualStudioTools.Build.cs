@@ -68,10 +68,18 @@ public class VisualStudioTools : ModuleRules
                 "EditorSubsystem",
                 "MainFrame",
                 "BlueprintGraph",
-                "VisualStudioDTE",
                 "EditorStyle",
-                "Projects"
+                "Projects",
+                "Sockets",
+                "Networking"
             }
         );
+
+        // The blueprint breakpoint extension drives Visual Studio through DTE, which only exists on Windows.
+        // Its sources live under the Windows folder, so other platforms don't build them.
+        if (Target.Platform == UnrealTargetPlatform.Win64)
+        {
+            PrivateDependencyModuleNames.Add("VisualStudioDTE");
+        }
     }
 }
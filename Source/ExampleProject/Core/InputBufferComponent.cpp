@@ -0,0 +1,96 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "InputBufferComponent.h"
+#include "EnhancedInputComponent.h"
+#include "InputAction.h"
+#include "Engine/World.h"
+
+UInputBufferComponent::UInputBufferComponent()
+{
+	// the buffer is only updated from input events
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UInputBufferComponent::BindAction(UEnhancedInputComponent* EnhancedInputComponent, const UInputAction* Action)
+{
+	if (EnhancedInputComponent && Action)
+	{
+		EnhancedInputComponent->BindAction(Action, ETriggerEvent::Started, this, &UInputBufferComponent::HandleActionStarted);
+	}
+}
+
+void UInputBufferComponent::RecordInput(const UInputAction* Action)
+{
+	RecordInputAt(Action, GetWorld()->GetTimeSeconds());
+}
+
+void UInputBufferComponent::RecordInputAt(const UInputAction* Action, double Time)
+{
+	// overwrite the oldest press
+	FBufferedInput& Input = Buffer[NextIndex];
+	Input.Action = Action;
+	Input.Time = Time;
+	Input.bConsumed = false;
+
+	NextIndex = (NextIndex + 1) % BufferSize;
+}
+
+bool UInputBufferComponent::WasPressed(const UInputAction* Action, float TimeWindow) const
+{
+	return FindInput(Action, TimeWindow) != INDEX_NONE;
+}
+
+bool UInputBufferComponent::ConsumeInput(const UInputAction* Action, float TimeWindow)
+{
+	const int32 Index = FindInput(Action, TimeWindow);
+
+	if (Index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// consume this press and any earlier presses of the same action, so they can't trigger again
+	for (FBufferedInput& Input : Buffer)
+	{
+		if (Input.Action == Action && Input.Time <= Buffer[Index].Time)
+		{
+			Input.bConsumed = true;
+		}
+	}
+
+	return true;
+}
+
+void UInputBufferComponent::Clear()
+{
+	for (FBufferedInput& Input : Buffer)
+	{
+		Input.bConsumed = true;
+	}
+}
+
+void UInputBufferComponent::HandleActionStarted(const FInputActionInstance& Instance)
+{
+	RecordInput(Instance.GetSourceAction());
+}
+
+int32 UInputBufferComponent::FindInput(const UInputAction* Action, float TimeWindow) const
+{
+	const double MinTime = GetWorld()->GetTimeSeconds() - TimeWindow;
+
+	// presses recorded at past times may be out of order, so check the whole buffer for the latest match
+	int32 FoundIndex = INDEX_NONE;
+
+	for (int32 Index = 0; Index < BufferSize; ++Index)
+	{
+		const FBufferedInput& Input = Buffer[Index];
+
+		if (!Input.bConsumed && Input.Action == Action && Input.Time >= MinTime && (FoundIndex == INDEX_NONE || Input.Time > Buffer[FoundIndex].Time))
+		{
+			FoundIndex = Index;
+		}
+	}
+
+	return FoundIndex;
+}
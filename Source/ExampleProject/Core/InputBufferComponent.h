@@ -0,0 +1,80 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Containers/StaticArray.h"
+#include "InputBufferComponent.generated.h"
+
+class UInputAction;
+class UEnhancedInputComponent;
+struct FInputActionInstance;
+
+/**
+ *  Buffers timestamped input action presses, so gameplay can act on inputs that arrived a little early.
+ *  Presses are kept in a fixed size ring buffer, so recording and querying inputs never allocates.
+ *  Typical uses are combo and attack input caching, jump buffering and coyote time checks.
+ */
+UCLASS(ClassGroup=(Input), meta=(BlueprintSpawnableComponent))
+class UInputBufferComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Max number of presses kept in the buffer. Older presses are overwritten */
+	static constexpr int32 BufferSize = 16;
+
+protected:
+
+	/** Buffered input press */
+	struct FBufferedInput
+	{
+		/** Action that was pressed */
+		const UInputAction* Action = nullptr;
+
+		/** World time of the press */
+		double Time = 0.0;
+
+		/** If true, the press was already used by gameplay */
+		bool bConsumed = true;
+	};
+
+	/** Ring buffer of presses */
+	TStaticArray<FBufferedInput, BufferSize> Buffer;
+
+	/** Index the next press will be written to */
+	int32 NextIndex = 0;
+
+public:
+
+	/** Constructor */
+	UInputBufferComponent();
+
+	/** Records a press for every Started event of the action */
+	void BindAction(UEnhancedInputComponent* EnhancedInputComponent, const UInputAction* Action);
+
+	/** Records a press of the action at the current time. Use this when inputs are routed from UI or other sources */
+	void RecordInput(const UInputAction* Action);
+
+	/** Records a press of the action at a past world time, such as a remote client's press adjusted for latency */
+	void RecordInputAt(const UInputAction* Action, double Time);
+
+	/** Returns true if the action was pressed within the time window and the press hasn't been consumed */
+	bool WasPressed(const UInputAction* Action, float TimeWindow) const;
+
+	/** Consumes the latest press of the action within the time window. Returns true if one was found */
+	bool ConsumeInput(const UInputAction* Action, float TimeWindow);
+
+	/** Consumes all buffered presses */
+	void Clear();
+
+protected:
+
+	/** Handles Started events from bound actions */
+	void HandleActionStarted(const FInputActionInstance& Instance);
+
+	/** Returns the buffer index of the latest unconsumed press of the action within the time window, or INDEX_NONE */
+	int32 FindInput(const UInputAction* Action, float TimeWindow) const;
+};
@@ -11,6 +11,7 @@
 #include "TimerManager.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
 
 ACombatEnemy::ACombatEnemy()
 {
@@ -60,17 +61,7 @@ void ACombatEnemy::DoAIComboAttack()
 	CurrentComboAttack = 0;
 
 	// play the attack montage
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-	{
-		const float MontageLength = AnimInstance->Montage_Play(ComboAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
-
-		// subscribe to montage completed and interrupted events
-		if (MontageLength > 0.0f)
-		{
-			// set the end delegate for the montage
-			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ComboAttackMontage);
-		}
-	}
+	PlayAttackMontage(ComboAttackMontage);
 }
 
 void ACombatEnemy::DoAIChargedAttack()
@@ -91,35 +82,115 @@ void ACombatEnemy::DoAIChargedAttack()
 	CurrentChargeLoop = 0;
 
 	// play the attack montage
+	PlayAttackMontage(ChargedAttackMontage);
+}
+
+void ACombatEnemy::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted)
+{
+	// reset the attacking flag
+	bIsAttacking = false;
+
+	// call the attack completed delegate so the StateTree can continue execution
+	OnAttackCompleted.ExecuteIfBound();
+}
+
+void ACombatEnemy::PlayAttackMontage(UAnimMontage* Montage)
+{
+	// without a ticking anim instance, play back the baked montage events instead
+	if (bUseBakedMontageEvents)
+	{
+		MontageEvents.Play(Montage);
+
+		// the baked events don't move the pawn, so keep playing root motion montages for their root motion.
+		// Only the montage ticks, the notifies skip themselves and the baked player ends the attack
+		if (Montage && Montage->HasRootMotion())
+		{
+			if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+			{
+				AnimInstance->Montage_Play(Montage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+			}
+		}
+
+		return;
+	}
+
 	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 	{
-		const float MontageLength = AnimInstance->Montage_Play(ChargedAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+		const float MontageLength = AnimInstance->Montage_Play(Montage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
 
 		// subscribe to montage completed and interrupted events
 		if (MontageLength > 0.0f)
 		{
 			// set the end delegate for the montage
-			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ChargedAttackMontage);
+			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, Montage);
 		}
 	}
 }
 
-void ACombatEnemy::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted)
+void ACombatEnemy::JumpToAttackSection(FName SectionName, UAnimMontage* Montage)
 {
-	// reset the attacking flag
-	bIsAttacking = false;
+	if (bUseBakedMontageEvents)
+	{
+		MontageEvents.JumpToSection(SectionName);
 
-	// call the attack completed delegate so the StateTree can continue execution
-	OnAttackCompleted.ExecuteIfBound();
+		// keep any root motion montage in step with the baked events
+		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+		{
+			if (AnimInstance->Montage_IsPlaying(Montage))
+			{
+				AnimInstance->Montage_JumpToSection(SectionName, Montage);
+			}
+		}
+
+		return;
+	}
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->Montage_JumpToSection(SectionName, Montage);
+	}
+}
+
+void ACombatEnemy::StopAttackMontages()
+{
+	// stopping the baked events counts as an interruption, same as stopping the montage
+	if (bUseBakedMontageEvents)
+	{
+		if (UAnimMontage* Montage = MontageEvents.GetMontage())
+		{
+			MontageEvents.Stop();
+			AttackMontageEnded(Montage, true);
+		}
+
+		// stop any montage playing for its root motion. It has no end delegate, so this doesn't end the attack twice
+		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+		{
+			AnimInstance->Montage_Stop(0.1f, ComboAttackMontage);
+			AnimInstance->Montage_Stop(0.1f, ChargedAttackMontage);
+		}
+
+		return;
+	}
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->Montage_Stop(0.1f, ComboAttackMontage);
+		AnimInstance->Montage_Stop(0.1f, ChargedAttackMontage);
+	}
 }
 
 void ACombatEnemy::DoAttackTrace(FName DamageSourceBone)
+{
+	// start at the provided socket location
+	DoAttackTraceFrom(GetMesh()->GetSocketLocation(DamageSourceBone));
+}
+
+void ACombatEnemy::DoAttackTraceFrom(const FVector& TraceStart)
 {
 	// sweep for objects in front of the character to be hit by the attack
 	TArray<FHitResult> OutHits;
 
-	// start at the provided socket location, sweep forward
-	const FVector TraceStart = GetMesh()->GetSocketLocation(DamageSourceBone);
+	// sweep forward from the trace start
 	const FVector TraceEnd = TraceStart + (GetActorForwardVector() * MeleeTraceDistance);
 
 	// enemies only affect Pawn collision objects; they don't knock back boxes
@@ -168,10 +239,7 @@ void ACombatEnemy::CheckCombo()
 	if (CurrentComboAttack < TargetComboCount)
 	{
 		// jump to the next attack section
-		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-		{
-			AnimInstance->Montage_JumpToSection(ComboSectionNames[CurrentComboAttack], ComboAttackMontage);
-		}
+		JumpToAttackSection(ComboSectionNames[CurrentComboAttack], ComboAttackMontage);
 	}
 }
 
@@ -181,10 +249,7 @@ void ACombatEnemy::CheckChargedAttack()
 	++CurrentChargeLoop;
 
 	// jump to either the loop or attack section of the montage depending on whether we hit the loop target
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-	{
-		AnimInstance->Montage_JumpToSection(CurrentChargeLoop >= TargetChargeLoops ? ChargeAttackSection : ChargeLoopSection, ChargedAttackMontage);
-	}
+	JumpToAttackSection(CurrentChargeLoop >= TargetChargeLoops ? ChargeAttackSection : ChargeLoopSection, ChargedAttackMontage);
 }
 
 void ACombatEnemy::ApplyDamage(float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
@@ -208,11 +273,7 @@ void ACombatEnemy::ApplyDamage(float Damage, AActor* DamageCauser, const FVector
 		}
 
 		// stop the attack montages to interrupt the attack
-		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-		{
-			AnimInstance->Montage_Stop(0.1f, ComboAttackMontage);
-			AnimInstance->Montage_Stop(0.1f, ChargedAttackMontage);
-		}
+		StopAttackMontages();
 
 		// pass control to BP to play effects, etc.
 		ReceivedDamage(ActualDamage, DamageLocation, DamageImpulse.GetSafeNormal());
@@ -245,6 +306,17 @@ void ACombatEnemy::ApplyHealing(float Healing, AActor* Healer)
 	// stub
 }
 
+void ACombatEnemy::SetCurrentHP(float NewHP)
+{
+	CurrentHP = FMath::Clamp(NewHP, 0.0f, MaxHP);
+
+	// update the life bar
+	if (LifeBarWidget)
+	{
+		LifeBarWidget->SetLifePercentage(CurrentHP / MaxHP);
+	}
+}
+
 void ACombatEnemy::RemoveFromLevel()
 {
 	// destroy this actor
@@ -297,11 +369,36 @@ void ACombatEnemy::Landed(const FHitResult& Hit)
 	OnEnemyLanded.ExecuteIfBound();
 }
 
+void ACombatEnemy::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// advance the baked attack events, and end the attack when the montage would have finished
+	if (MontageEvents.IsPlaying())
+	{
+		UAnimMontage* Montage = MontageEvents.GetMontage();
+
+		if (MontageEvents.Advance(DeltaSeconds, *this, *GetMesh()))
+		{
+			AttackMontageEnded(Montage, false);
+		}
+	}
+}
+
 void ACombatEnemy::BeginPlay()
 {
 	// reset HP to maximum
 	CurrentHP = MaxHP;
 
+	// dedicated servers don't need the pose, so fire the attack events from the baked montage tables instead of AnimNotifies
+	bUseBakedMontageEvents = bSkipServerAnimation && GetNetMode() == NM_DedicatedServer;
+
+	if (bUseBakedMontageEvents)
+	{
+		// still tick the montages, so root motion attacks move the pawn like they do on the owning client
+		GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+	}
+
 	// we top the HP before BeginPlay so StateTree picks it up at the right value
 	Super::BeginPlay();
 
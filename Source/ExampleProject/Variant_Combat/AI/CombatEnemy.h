@@ -8,6 +8,7 @@
 #include "CombatDamageable.h"
 #include "Animation/AnimMontage.h"
 #include "Engine/TimerHandle.h"
+#include "CombatMontageEvents.h"
 #include "CombatEnemy.generated.h"
 
 class UWidgetComponent;
@@ -136,6 +137,16 @@ protected:
 	/** Attack montage ended delegate */
 	FOnMontageEnded OnAttackMontageEnded;
 
+	/** If true, dedicated servers skip pose ticks and fire the attack events from tables baked from the attack montages */
+	UPROPERTY(EditAnywhere, Category="Melee Attack")
+	bool bSkipServerAnimation = true;
+
+	/** If true, the attack montage events are played back from baked tables instead of AnimNotifies */
+	bool bUseBakedMontageEvents = false;
+
+	/** Plays back the attack montage events while the anim instance isn't ticking */
+	FCombatMontageEventPlayer MontageEvents;
+
 public:
 	/** Attack completed internal delegate to notify StateTree tasks */
 	FOnEnemyAttackCompleted OnAttackCompleted;
@@ -158,6 +169,25 @@ public:
 	/** Called from a delegate when the attack montage ends */
 	void AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted);
 
+protected:
+
+	/** Plays an attack montage, or its baked events if we're skipping animation */
+	void PlayAttackMontage(UAnimMontage* Montage);
+
+	/** Jumps to a section of the playing attack montage */
+	void JumpToAttackSection(FName SectionName, UAnimMontage* Montage);
+
+	/** Interrupts any playing attack montage */
+	void StopAttackMontages();
+
+public:
+
+	/** Returns the max amount of HP the character spawns with */
+	float GetMaxHP() const { return MaxHP; }
+
+	/** Overrides the current HP and updates the life bar. Used to carry HP over when an enemy is spawned from a horde agent */
+	void SetCurrentHP(float NewHP);
+
 public:
 
 	// ~begin ICombatAttacker interface
@@ -173,6 +203,12 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Attacker")
 	virtual void CheckChargedAttack() override;
 
+	/** Performs an attack's collision check from a world location */
+	virtual void DoAttackTraceFrom(const FVector& TraceStart) override;
+
+	/** Returns true if the attack events are fired from baked montage tables */
+	virtual bool UsesBakedMontageEvents() const override { return bUseBakedMontageEvents; }
+
 	// ~end ICombatAttacker interface
 
 	// ~begin ICombatDamageable interface
@@ -201,6 +237,9 @@ public:
 	/** Overrides landing to reset damage ragdoll physics */
 	virtual void Landed(const FHitResult& Hit) override;
 
+	/** Advances the baked attack montage events */
+	virtual void Tick(float DeltaSeconds) override;
+
 protected:
 
 	/** Blueprint handler to play damage received effects */
@@ -0,0 +1,590 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatEnemyHorde.h"
+#include "CombatEnemy.h"
+#include "CombatDamageable.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+#include "ExampleProject.h"
+
+ACombatEnemyHorde::ACombatEnemyHorde()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// create the instanced mesh. Horde agents are purely visual, so they have no collision
+	RootComponent = HordeMesh = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Horde Mesh"));
+
+	HordeMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	HordeMesh->SetCanEverAffectNavigation(false);
+	HordeMesh->SetMobility(EComponentMobility::Movable);
+
+	// animation state and animation start time for the vertex animation material
+	HordeMesh->NumCustomDataFloats = 2;
+
+	// the server runs the decisions and replicates the agent states. The horde covers a large area, so it's always relevant
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	SetReplicatingMovement(false);
+}
+
+void ACombatEnemyHorde::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// initialize the agents
+	FRandomStream Random(RandomSeed);
+
+	const FVector2f Center(GetActorLocation().X, GetActorLocation().Y);
+	const float StartHP = EnemyClass ? EnemyClass->GetDefaultObject<ACombatEnemy>()->GetMaxHP() : 1.0f;
+
+	AgentLocation.SetNumUninitialized(NumAgents);
+	AgentHP.Init(StartHP, NumAgents);
+	AgentAttackCooldown.Init(0.0f, NumAgents);
+	AgentSpeed.SetNumUninitialized(NumAgents);
+	AgentYaw.SetNumUninitialized(NumAgents);
+	AgentTargetId.Init(INDEX_NONE, NumAgents);
+	AgentAnimation.Init(EAgentAnimation::Idle, NumAgents);
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		// spread the agents uniformly over the spawn disc
+		const float Angle = Random.FRandRange(0.0f, UE_TWO_PI);
+		const float Distance = SpawnRadius * FMath::Sqrt(Random.FRand());
+
+		AgentLocation[i] = Center + FVector2f(FMath::Cos(Angle), FMath::Sin(Angle)) * Distance;
+		AgentSpeed[i] = MoveSpeed * Random.FRandRange(0.8f, 1.2f);
+		AgentYaw[i] = Random.FRandRange(-180.0f, 180.0f);
+	}
+
+	PromotedAgents.Init(false, NumAgents);
+	RemovedAgents.Init(false, NumAgents);
+	PromotedEnemies.SetNumZeroed(NumAgents);
+
+	// apply any agent states that replicated before we were initialized
+	if (!HasAuthority())
+	{
+		OnRep_AgentStates();
+		OnRep_Snapshot();
+	}
+
+	// create the instances
+	InstanceTransforms.SetNumUninitialized(NumAgents);
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		InstanceTransforms[i] = GetAgentTransform(i);
+	}
+
+	HordeMesh->ClearInstances();
+	HordeMesh->AddInstances(InstanceTransforms, false, true);
+
+	// offset the animation start times so the horde doesn't animate in lockstep
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		HordeMesh->SetCustomDataValue(i, 1, -Random.FRandRange(0.0f, 10.0f), false);
+	}
+
+	HordeMesh->MarkRenderStateDirty();
+
+	if (bLogHordeStats)
+	{
+		const SIZE_T AgentMemory = AgentLocation.GetAllocatedSize() + AgentHP.GetAllocatedSize() + AgentAttackCooldown.GetAllocatedSize()
+			+ AgentSpeed.GetAllocatedSize() + AgentYaw.GetAllocatedSize() + AgentTargetId.GetAllocatedSize() + AgentAnimation.GetAllocatedSize()
+			+ PromotedAgents.GetAllocatedSize() + RemovedAgents.GetAllocatedSize() + PromotedEnemies.GetAllocatedSize();
+
+		UE_LOG(LogExampleProject, Log, TEXT("Enemy horde %s spawned %d agents using %.1f KB of simulation state."), *GetName(), NumAgents, AgentMemory / 1024.0);
+	}
+}
+
+void ACombatEnemyHorde::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	// destroy any promoted actors we still own
+	for (ACombatEnemy* Enemy : PromotedEnemies)
+	{
+		if (IsValid(Enemy))
+		{
+			Enemy->Destroy();
+		}
+	}
+
+	PromotedEnemies.Reset();
+}
+
+void ACombatEnemyHorde::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ACombatEnemyHorde, ReplicatedPromotedAgents);
+	DOREPLIFETIME(ACombatEnemyHorde, ReplicatedRemovedAgents);
+	DOREPLIFETIME(ACombatEnemyHorde, Snapshot);
+}
+
+void ACombatEnemyHorde::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	GatherPlayers();
+
+	// clients only move the agents towards the targets chosen by the server
+	if (HasAuthority())
+	{
+		UpdateDecisions(DeltaTime);
+	}
+
+	UpdateMovement(DeltaTime);
+
+	if (HasAuthority())
+	{
+		// promotion doesn't need to run every frame
+		PromotionCheckTimer -= DeltaTime;
+
+		if (PromotionCheckTimer <= 0.0f)
+		{
+			PromotionCheckTimer = PromotionCheckInterval;
+
+			UpdatePromotion();
+		}
+
+		// send the next slice of the horde to the clients
+		SnapshotTimer -= DeltaTime;
+
+		if (SnapshotTimer <= 0.0f)
+		{
+			SnapshotTimer = SnapshotInterval;
+
+			UpdateSnapshot();
+		}
+	}
+
+	UpdateRepresentation();
+
+	if (bLogHordeStats)
+	{
+		UpdateStats(FPlatformTime::Seconds() - StartTime, DeltaTime);
+	}
+}
+
+void ACombatEnemyHorde::GatherPlayers()
+{
+	Players.Reset();
+	PlayerIds.Reset();
+	PlayerLocations.Reset();
+
+	if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+	{
+		for (const APlayerState* PlayerState : GameState->PlayerArray)
+		{
+			if (APawn* PlayerPawn = PlayerState ? PlayerState->GetPawn() : nullptr)
+			{
+				const FVector Location = PlayerPawn->GetActorLocation();
+
+				Players.Add(PlayerPawn);
+				PlayerIds.Add(PlayerState->GetPlayerId());
+				PlayerLocations.Emplace(static_cast<float>(Location.X), static_cast<float>(Location.Y));
+			}
+		}
+	}
+}
+
+void ACombatEnemyHorde::UpdateDecisions(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_CombatEnemyHorde_Decisions);
+
+	if (NumAgents == 0)
+	{
+		return;
+	}
+
+	// every agent decides once per interval, so only run a slice of them each frame
+	const int32 NumDecisions = FMath::Min(FMath::CeilToInt32(NumAgents * DeltaTime / DecisionInterval), NumAgents);
+
+	const float AggroRadiusSquared = FMath::Square(AggroRadius);
+	const float AttackRangeSquared = FMath::Square(AttackRange);
+
+	for (int32 Decision = 0; Decision < NumDecisions; ++Decision)
+	{
+		const int32 i = DecisionCursor;
+		DecisionCursor = (DecisionCursor + 1) % NumAgents;
+
+		// promoted agents are driven by their own StateTree
+		if (PromotedAgents[i] || RemovedAgents[i])
+		{
+			continue;
+		}
+
+		// target the closest player within aggro range
+		int32 Target = INDEX_NONE;
+		float TargetDistanceSquared = AggroRadiusSquared;
+
+		for (int32 PlayerIndex = 0; PlayerIndex < PlayerLocations.Num(); ++PlayerIndex)
+		{
+			const float DistanceSquared = FVector2f::DistSquared(PlayerLocations[PlayerIndex], AgentLocation[i]);
+
+			if (DistanceSquared < TargetDistanceSquared)
+			{
+				Target = PlayerIndex;
+				TargetDistanceSquared = DistanceSquared;
+			}
+		}
+
+		AgentTargetId[i] = Target != INDEX_NONE ? PlayerIds[Target] : INDEX_NONE;
+
+		if (Target == INDEX_NONE)
+		{
+			AgentAnimation[i] = EAgentAnimation::Idle;
+			continue;
+		}
+
+		// keep chasing until the target is in attack range
+		if (TargetDistanceSquared >= AttackRangeSquared)
+		{
+			AgentAnimation[i] = EAgentAnimation::Move;
+
+		} else if (AgentAttackCooldown[i] <= 0.0f) {
+
+			// attack the target. The attack animation plays until the next decision
+			AgentAttackCooldown[i] = AttackCooldown;
+			AgentAnimation[i] = EAgentAnimation::Attack;
+
+			if (ICombatDamageable* Damageable = Cast<ICombatDamageable>(Players[Target]))
+			{
+				Damageable->ApplyDamage(AttackDamage, this, Players[Target]->GetActorLocation(), FVector::ZeroVector);
+			}
+
+		} else {
+
+			// wait in range for the cooldown
+			AgentAnimation[i] = EAgentAnimation::Idle;
+
+		}
+	}
+}
+
+void ACombatEnemyHorde::UpdateMovement(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_CombatEnemyHorde_Movement);
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		AgentAttackCooldown[i] = FMath::Max(AgentAttackCooldown[i] - DeltaTime, 0.0f);
+
+		// only chasing agents move. Targets can go stale if a player leaves between decisions
+		if (AgentTargetId[i] == INDEX_NONE || PromotedAgents[i] || RemovedAgents[i])
+		{
+			continue;
+		}
+
+		const int32 Target = PlayerIds.Find(AgentTargetId[i]);
+
+		if (Target == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const FVector2f ToTarget = PlayerLocations[Target] - AgentLocation[i];
+		const float Distance = ToTarget.Size();
+
+		// stop at attack range
+		const float MoveDistance = FMath::Min(AgentSpeed[i] * DeltaTime, Distance - AttackRange);
+
+		if (MoveDistance > 0.0f)
+		{
+			AgentLocation[i] += ToTarget * (MoveDistance / Distance);
+		}
+
+		AgentYaw[i] = FMath::RadiansToDegrees(FMath::Atan2(ToTarget.Y, ToTarget.X));
+	}
+}
+
+void ACombatEnemyHorde::UpdatePromotion()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_CombatEnemyHorde_Promotion);
+
+	const float PromotionRadiusSquared = FMath::Square(PromotionRadius);
+	const float DemotionRadiusSquared = FMath::Square(DemotionRadius);
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		if (RemovedAgents[i])
+		{
+			continue;
+		}
+
+		if (PromotedAgents[i])
+		{
+			ACombatEnemy* Enemy = PromotedEnemies[i];
+
+			// was the promoted actor killed or destroyed by gameplay?
+			if (!IsValid(Enemy) || Enemy->CurrentHP <= 0.0f)
+			{
+				RemoveAgent(i);
+				continue;
+			}
+
+			// promoted enemies move on their own, so measure from the actor
+			FVector2f Location = AgentLocation[i];
+
+			if (IsValid(Enemy))
+			{
+				const FVector EnemyLocation = Enemy->GetActorLocation();
+				Location = FVector2f(static_cast<float>(EnemyLocation.X), static_cast<float>(EnemyLocation.Y));
+			}
+
+			float ClosestDistanceSquared = UE_BIG_NUMBER;
+
+			for (const FVector2f& PlayerLocation : PlayerLocations)
+			{
+				ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector2f::DistSquared(PlayerLocation, Location));
+			}
+
+			// return to the horde once every player is far enough
+			if (ClosestDistanceSquared > DemotionRadiusSquared)
+			{
+				DemoteAgent(i);
+			}
+
+		} else if (NumPromotedAgents < MaxPromotedAgents) {
+
+			for (const FVector2f& PlayerLocation : PlayerLocations)
+			{
+				if (FVector2f::DistSquared(PlayerLocation, AgentLocation[i]) < PromotionRadiusSquared)
+				{
+					PromoteAgent(i);
+					break;
+				}
+			}
+
+		}
+	}
+}
+
+void ACombatEnemyHorde::UpdateSnapshot()
+{
+	if (NumAgents == 0)
+	{
+		return;
+	}
+
+	const int32 NumSnapshotAgents = FMath::Min(SnapshotSize, NumAgents - SnapshotCursor);
+
+	Snapshot.FirstAgent = SnapshotCursor;
+	Snapshot.Locations.SetNum(NumSnapshotAgents);
+	Snapshot.TargetIds.SetNum(NumSnapshotAgents);
+	Snapshot.Animations.SetNum(NumSnapshotAgents);
+
+	for (int32 SnapshotIndex = 0; SnapshotIndex < NumSnapshotAgents; ++SnapshotIndex)
+	{
+		const int32 i = SnapshotCursor + SnapshotIndex;
+
+		Snapshot.Locations[SnapshotIndex] = AgentLocation[i];
+		Snapshot.TargetIds[SnapshotIndex] = AgentTargetId[i];
+		Snapshot.Animations[SnapshotIndex] = static_cast<uint8>(AgentAnimation[i]);
+	}
+
+	// wrap around once we've sent the whole horde
+	SnapshotCursor = (SnapshotCursor + NumSnapshotAgents) % NumAgents;
+}
+
+void ACombatEnemyHorde::OnRep_Snapshot()
+{
+	// wait until BeginPlay has sized the agent state
+	if (AgentLocation.Num() != NumAgents)
+	{
+		return;
+	}
+
+	const int32 NumSnapshotAgents = FMath::Min3(Snapshot.Locations.Num(), Snapshot.TargetIds.Num(), Snapshot.Animations.Num());
+
+	for (int32 SnapshotIndex = 0; SnapshotIndex < NumSnapshotAgents; ++SnapshotIndex)
+	{
+		const int32 i = Snapshot.FirstAgent + SnapshotIndex;
+
+		if (!AgentLocation.IsValidIndex(i))
+		{
+			break;
+		}
+
+		AgentLocation[i] = Snapshot.Locations[SnapshotIndex];
+		AgentTargetId[i] = Snapshot.TargetIds[SnapshotIndex];
+		AgentAnimation[i] = static_cast<EAgentAnimation>(FMath::Min<uint8>(Snapshot.Animations[SnapshotIndex], static_cast<uint8>(EAgentAnimation::Attack)));
+	}
+}
+
+void ACombatEnemyHorde::OnRep_AgentStates()
+{
+	// wait until BeginPlay has sized the agent state
+	if (PromotedAgents.Num() != NumAgents)
+	{
+		return;
+	}
+
+	PromotedAgents.Init(false, NumAgents);
+	RemovedAgents.Init(false, NumAgents);
+	NumPromotedAgents = 0;
+
+	for (const int32 AgentIndex : ReplicatedPromotedAgents)
+	{
+		if (PromotedAgents.IsValidIndex(AgentIndex))
+		{
+			PromotedAgents[AgentIndex] = true;
+			++NumPromotedAgents;
+		}
+	}
+
+	for (const int32 AgentIndex : ReplicatedRemovedAgents)
+	{
+		if (RemovedAgents.IsValidIndex(AgentIndex))
+		{
+			RemovedAgents[AgentIndex] = true;
+		}
+	}
+}
+
+void ACombatEnemyHorde::UpdateRepresentation()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_CombatEnemyHorde_Representation);
+
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		InstanceTransforms[i] = GetAgentTransform(i);
+
+		// restart the vertex animation only when the agent changes state
+		const float AnimationState = static_cast<float>(AgentAnimation[i]);
+
+		if (HordeMesh->PerInstanceSMCustomData[i * HordeMesh->NumCustomDataFloats] != AnimationState)
+		{
+			HordeMesh->SetCustomDataValue(i, 0, AnimationState, false);
+			HordeMesh->SetCustomDataValue(i, 1, CurrentTime, false);
+		}
+	}
+
+	// push all instances in one batch. This also uploads any custom data we changed
+	HordeMesh->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, false);
+}
+
+FTransform ACombatEnemyHorde::GetAgentTransform(int32 AgentIndex) const
+{
+	// hide promoted and removed agents by collapsing their instance
+	const bool bHidden = PromotedAgents[AgentIndex] || RemovedAgents[AgentIndex];
+
+	const FVector Location(AgentLocation[AgentIndex].X, AgentLocation[AgentIndex].Y, GetActorLocation().Z);
+	const FRotator Rotation(0.0f, AgentYaw[AgentIndex], 0.0f);
+
+	return FTransform(Rotation, Location, bHidden ? FVector::ZeroVector : FVector::OneVector);
+}
+
+void ACombatEnemyHorde::PromoteAgent(int32 AgentIndex)
+{
+	PromotedAgents[AgentIndex] = true;
+	++NumPromotedAgents;
+
+	// clients hide the agent once this replicates, and receive the replicated enemy
+	ReplicatedPromotedAgents.Add(AgentIndex);
+
+	if (!EnemyClass)
+	{
+		return;
+	}
+
+	// spawn the enemy standing on the horde's ground height
+	const ACombatEnemy* EnemyDefaults = EnemyClass->GetDefaultObject<ACombatEnemy>();
+	const float HalfHeight = EnemyDefaults->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	FTransform SpawnTransform = GetAgentTransform(AgentIndex);
+	SpawnTransform.SetScale3D(FVector::OneVector);
+	SpawnTransform.AddToTranslation(FVector(0.0f, 0.0f, HalfHeight));
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	ACombatEnemy* Enemy = GetWorld()->SpawnActor<ACombatEnemy>(EnemyClass, SpawnTransform, SpawnParams);
+
+	if (Enemy)
+	{
+		// make sure the enemy gets its AI controller
+		if (!Enemy->GetController())
+		{
+			Enemy->SpawnDefaultController();
+		}
+
+		// carry over any damage the agent has taken
+		Enemy->SetCurrentHP(AgentHP[AgentIndex]);
+
+		PromotedEnemies[AgentIndex] = Enemy;
+	}
+}
+
+void ACombatEnemyHorde::DemoteAgent(int32 AgentIndex)
+{
+	ACombatEnemy* Enemy = PromotedEnemies[AgentIndex];
+
+	if (IsValid(Enemy))
+	{
+		// continue from where the actor left off
+		const FVector EnemyLocation = Enemy->GetActorLocation();
+
+		AgentLocation[AgentIndex] = FVector2f(static_cast<float>(EnemyLocation.X), static_cast<float>(EnemyLocation.Y));
+		AgentYaw[AgentIndex] = Enemy->GetActorRotation().Yaw;
+		AgentHP[AgentIndex] = Enemy->CurrentHP;
+
+		Enemy->Destroy();
+	}
+
+	AgentTargetId[AgentIndex] = INDEX_NONE;
+	AgentAnimation[AgentIndex] = EAgentAnimation::Idle;
+
+	PromotedEnemies[AgentIndex] = nullptr;
+	PromotedAgents[AgentIndex] = false;
+	--NumPromotedAgents;
+
+	ReplicatedPromotedAgents.RemoveSwap(AgentIndex);
+}
+
+void ACombatEnemyHorde::RemoveAgent(int32 AgentIndex)
+{
+	// dead enemies remove themselves from the level, so we just let go of them
+	PromotedEnemies[AgentIndex] = nullptr;
+	PromotedAgents[AgentIndex] = false;
+	RemovedAgents[AgentIndex] = true;
+	AgentTargetId[AgentIndex] = INDEX_NONE;
+	--NumPromotedAgents;
+
+	ReplicatedPromotedAgents.RemoveSwap(AgentIndex);
+	ReplicatedRemovedAgents.Add(AgentIndex);
+}
+
+void ACombatEnemyHorde::UpdateStats(double UpdateTime, float DeltaTime)
+{
+	StatsUpdateTime += UpdateTime;
+	StatsPeakUpdateTime = FMath::Max(StatsPeakUpdateTime, UpdateTime);
+	++StatsFrames;
+
+	StatsLogTimer -= DeltaTime;
+
+	if (StatsLogTimer > 0.0f)
+	{
+		return;
+	}
+
+	StatsLogTimer = StatsLogInterval;
+
+	const int32 NumActiveAgents = NumAgents - RemovedAgents.CountSetBits();
+
+	UE_LOG(LogExampleProject, Log, TEXT("Enemy horde stats: %d active agents, %d promoted, average update %.3f ms, peak update %.3f ms"),
+		NumActiveAgents, NumPromotedAgents, StatsUpdateTime * 1000.0 / FMath::Max(StatsFrames, 1), StatsPeakUpdateTime * 1000.0);
+
+	StatsUpdateTime = 0.0;
+	StatsPeakUpdateTime = 0.0;
+	StatsFrames = 0;
+}
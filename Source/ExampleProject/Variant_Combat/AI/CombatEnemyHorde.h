@@ -0,0 +1,278 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CombatEnemyHorde.generated.h"
+
+class UInstancedStaticMeshComponent;
+class ACombatEnemy;
+class APawn;
+
+/**
+ *  Slice of the horde simulation state, sent by the server to correct the client simulations.
+ *  The server sends a different slice of agents every update, cycling through the whole horde.
+ */
+USTRUCT()
+struct FCombatEnemyHordeSnapshot
+{
+	GENERATED_BODY()
+
+	/** Index of the first agent in the slice */
+	UPROPERTY()
+	int32 FirstAgent = 0;
+
+	/** Location of each agent in the slice */
+	UPROPERTY()
+	TArray<FVector2f> Locations;
+
+	/** Player id each agent in the slice is chasing, or INDEX_NONE */
+	UPROPERTY()
+	TArray<int32> TargetIds;
+
+	/** Animation state of each agent in the slice */
+	UPROPERTY()
+	TArray<uint8> Animations;
+};
+
+/**
+ *  A large horde of lightweight combat enemies.
+ *  Enemies far from the players are simulated as compact parallel arrays of HP, target, position and attack cooldown,
+ *  make their chase and attack decisions at a low frequency, and are drawn through a single instanced mesh.
+ *  The instances expose their animation state and start time as per-instance custom data,
+ *  so the mesh material can play vertex-baked animations.
+ *  Enemies within the promotion radius of a player are replaced by full ACombatEnemy actors,
+ *  which carry over their HP and run the regular StateTree AI.
+ *  The server makes all decisions. Clients only move the agents towards their targets,
+ *  and are corrected by rolling snapshots of the agent state and the replicated promoted and removed agents.
+ */
+UCLASS(abstract)
+class ACombatEnemyHorde : public AActor
+{
+	GENERATED_BODY()
+
+	/** Instanced mesh used to draw the enemies that haven't been promoted */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
+	UInstancedStaticMeshComponent* HordeMesh;
+
+protected:
+
+	/** Animation states written to the instance custom data */
+	enum class EAgentAnimation : uint8
+	{
+		Idle,
+		Move,
+		Attack
+	};
+
+	/** Enemy class to spawn when an agent is promoted */
+	UPROPERTY(EditAnywhere, Category="Horde")
+	TSubclassOf<ACombatEnemy> EnemyClass;
+
+	/** Number of enemies in the horde */
+	UPROPERTY(EditAnywhere, Category="Horde", meta = (ClampMin = 0, ClampMax = 100000))
+	int32 NumAgents = 1000;
+
+	/** Seed for the agent spawn randomization */
+	UPROPERTY(EditAnywhere, Category="Horde")
+	int32 RandomSeed = 0;
+
+	/** Radius of the spawn area around the actor location */
+	UPROPERTY(EditAnywhere, Category="Horde", meta = (ClampMin = 0, ClampMax = 1000000, Units = "cm"))
+	float SpawnRadius = 10000.0f;
+
+	/** Agent move speed. Each agent varies it slightly */
+	UPROPERTY(EditAnywhere, Category="Horde", meta = (ClampMin = 0, ClampMax = 10000, Units = "cm/s"))
+	float MoveSpeed = 300.0f;
+
+	/** Time between decisions for each agent. Decisions are spread evenly across frames */
+	UPROPERTY(EditAnywhere, Category="Horde|Decisions", meta = (ClampMin = 0.01, ClampMax = 5, Units = "s"))
+	float DecisionInterval = 0.5f;
+
+	/** Distance under which agents start chasing a player */
+	UPROPERTY(EditAnywhere, Category="Horde|Decisions", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
+	float AggroRadius = 5000.0f;
+
+	/** Distance under which agents stop moving and attack their target */
+	UPROPERTY(EditAnywhere, Category="Horde|Decisions", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm"))
+	float AttackRange = 150.0f;
+
+	/** Time between attacks for each agent */
+	UPROPERTY(EditAnywhere, Category="Horde|Decisions", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
+	float AttackCooldown = 2.0f;
+
+	/** Damage dealt by agents that attack without being promoted */
+	UPROPERTY(EditAnywhere, Category="Horde|Decisions", meta = (ClampMin = 0, ClampMax = 100))
+	float AttackDamage = 1.0f;
+
+	/** Distance to a player under which agents are promoted to actors */
+	UPROPERTY(EditAnywhere, Category="Horde|Promotion", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
+	float PromotionRadius = 2000.0f;
+
+	/** Distance to all players past which promoted agents return to the horde. Should be larger than the promotion radius */
+	UPROPERTY(EditAnywhere, Category="Horde|Promotion", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
+	float DemotionRadius = 3000.0f;
+
+	/** Max number of agents that can be promoted at the same time */
+	UPROPERTY(EditAnywhere, Category="Horde|Promotion", meta = (ClampMin = 0, ClampMax = 1000))
+	int32 MaxPromotedAgents = 24;
+
+	/** Time between promotion checks */
+	UPROPERTY(EditAnywhere, Category="Horde|Promotion", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float PromotionCheckInterval = 0.2f;
+
+	/** Number of agents sent in each snapshot to the clients */
+	UPROPERTY(EditAnywhere, Category="Horde|Replication", meta = (ClampMin = 1, ClampMax = 1024))
+	int32 SnapshotSize = 128;
+
+	/** Time between snapshots sent to the clients */
+	UPROPERTY(EditAnywhere, Category="Horde|Replication", meta = (ClampMin = 0.01, ClampMax = 5, Units = "s"))
+	float SnapshotInterval = 0.1f;
+
+	/** If true, periodically logs the horde simulation cost and memory footprint */
+	UPROPERTY(EditAnywhere, Category="Horde|Debug")
+	bool bLogHordeStats = false;
+
+	/** Time between stats logs */
+	UPROPERTY(EditAnywhere, Category="Horde|Debug", meta = (ClampMin = 1, ClampMax = 60, Units = "s", EditCondition = "bLogHordeStats"))
+	float StatsLogInterval = 5.0f;
+
+	/** Agent state, stored as parallel arrays */
+	TArray<FVector2f> AgentLocation;
+	TArray<float> AgentHP;
+	TArray<float> AgentAttackCooldown;
+	TArray<float> AgentSpeed;
+	TArray<float> AgentYaw;
+
+	/** Player id of the player each agent is chasing, or INDEX_NONE. Ids stay valid when players join, leave or reorder */
+	TArray<int32> AgentTargetId;
+
+	/** Current animation state of each agent */
+	TArray<EAgentAnimation> AgentAnimation;
+
+	/** Agents currently replaced by an actor. Rebuilt from the replicated list on clients */
+	TBitArray<> PromotedAgents;
+
+	/** Actor each agent is promoted to */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ACombatEnemy>> PromotedEnemies;
+
+	/** Agents that died, and will no longer be simulated. Rebuilt from the replicated list on clients */
+	TBitArray<> RemovedAgents;
+
+	/** Indices of the promoted agents. Bounded by the max number of promoted agents */
+	UPROPERTY(ReplicatedUsing=OnRep_AgentStates)
+	TArray<int32> ReplicatedPromotedAgents;
+
+	/** Indices of the removed agents */
+	UPROPERTY(ReplicatedUsing=OnRep_AgentStates)
+	TArray<int32> ReplicatedRemovedAgents;
+
+	/** Latest slice of the agent state sent to the clients */
+	UPROPERTY(ReplicatedUsing=OnRep_Snapshot)
+	FCombatEnemyHordeSnapshot Snapshot;
+
+	/** Player pawns gathered at the start of each tick */
+	TArray<APawn*, TInlineAllocator<8>> Players;
+
+	/** Player ids gathered at the start of each tick, in the same order as the pawns */
+	TArray<int32, TInlineAllocator<8>> PlayerIds;
+
+	/** Player locations gathered at the start of each tick */
+	TArray<FVector2f, TInlineAllocator<8>> PlayerLocations;
+
+	/** Scratch instance transforms, reused every frame */
+	TArray<FTransform> InstanceTransforms;
+
+	/** Next agent to make a decision */
+	int32 DecisionCursor = 0;
+
+	/** Number of currently promoted agents */
+	int32 NumPromotedAgents = 0;
+
+	/** Time left until the next promotion check */
+	float PromotionCheckTimer = 0.0f;
+
+	/** First agent of the next snapshot */
+	int32 SnapshotCursor = 0;
+
+	/** Time left until the next snapshot */
+	float SnapshotTimer = 0.0f;
+
+	/** Time spent updating the horde since the last stats log */
+	double StatsUpdateTime = 0.0;
+
+	/** Slowest horde update since the last stats log */
+	double StatsPeakUpdateTime = 0.0;
+
+	/** Number of frames since the last stats log */
+	int32 StatsFrames = 0;
+
+	/** Time left until the next stats log */
+	float StatsLogTimer = 0.0f;
+
+public:
+
+	/** Constructor */
+	ACombatEnemyHorde();
+
+protected:
+
+	/** Spawns the horde */
+	virtual void BeginPlay() override;
+
+	/** Destroys any promoted actors */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+public:
+
+	/** Sets up replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Updates the horde */
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+
+	/** Caches the player pawns and their locations for this frame */
+	void GatherPlayers();
+
+	/** Runs the decisions for the next slice of agents. Server only */
+	void UpdateDecisions(float DeltaTime);
+
+	/** Moves every chasing agent towards its target */
+	void UpdateMovement(float DeltaTime);
+
+	/** Promotes or demotes agents based on the player locations. Server only */
+	void UpdatePromotion();
+
+	/** Copies the next slice of agents into the replicated snapshot. Server only */
+	void UpdateSnapshot();
+
+	/** Applies a snapshot slice from the server to the client simulation */
+	UFUNCTION()
+	void OnRep_Snapshot();
+
+	/** Rebuilds the promoted and removed agent flags from the replicated lists */
+	UFUNCTION()
+	void OnRep_AgentStates();
+
+	/** Pushes the agent locations and animation states to the instanced mesh */
+	void UpdateRepresentation();
+
+	/** Returns the transform for an agent instance */
+	FTransform GetAgentTransform(int32 AgentIndex) const;
+
+	/** Replaces an agent with a full enemy actor */
+	void PromoteAgent(int32 AgentIndex);
+
+	/** Returns a promoted agent to the horde */
+	void DemoteAgent(int32 AgentIndex);
+
+	/** Stops simulating an agent */
+	void RemoveAgent(int32 AgentIndex);
+
+	/** Accumulates and periodically logs the horde update cost */
+	void UpdateStats(double UpdateTime, float DeltaTime);
+};
@@ -10,6 +10,12 @@ void UAnimNotify_CheckChargedAttack::Notify(USkeletalMeshComponent* MeshComp, UA
 	// cast the owner to the attacker interface
 	if (ICombatAttacker* AttackerInterface = Cast<ICombatAttacker>(MeshComp->GetOwner()))
 	{
+		// skip if the attacker fires this event from its baked montage events
+		if (AttackerInterface->UsesBakedMontageEvents())
+		{
+			return;
+		}
+
 		// tell the actor to check for a charged attack loop
 		AttackerInterface->CheckChargedAttack();
 	}
@@ -10,6 +10,12 @@ void UAnimNotify_DoAttackTrace::Notify(USkeletalMeshComponent* MeshComp, UAnimSe
 	// cast the owner to the attacker interface
 	if (ICombatAttacker* AttackerInterface = Cast<ICombatAttacker>(MeshComp->GetOwner()))
 	{
+		// skip if the attacker fires this event from its baked montage events
+		if (AttackerInterface->UsesBakedMontageEvents())
+		{
+			return;
+		}
+
 		AttackerInterface->DoAttackTrace(AttackBoneName);
 	}
 }
@@ -0,0 +1,380 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatMontageEvents.h"
+#include "CombatAttacker.h"
+#include "AnimNotify_DoAttackTrace.h"
+#include "AnimNotify_CheckCombo.h"
+#include "AnimNotify_CheckChargedAttack.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/UObjectGlobals.h"
+#include "ExampleProject.h"
+
+namespace CombatMontageEvents
+{
+	/** Baked tables, keyed so unloaded montages can't alias new ones */
+	TMap<FObjectKey, TSharedRef<const FCombatMontageEventTable>> BakedTables;
+}
+
+TSharedRef<const FCombatMontageEventTable> FCombatMontageEventTable::FindOrBake(const UAnimMontage* Montage)
+{
+	check(IsInGameThread());
+
+	using CombatMontageEvents::BakedTables;
+
+	// release the tables of unloaded montages after every garbage collection. Players keep their own reference while playing
+	static const FDelegateHandle ReleaseHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddStatic(&FCombatMontageEventTable::ReleaseUnloadedTables);
+
+	if (const TSharedRef<const FCombatMontageEventTable>* Found = BakedTables.Find(FObjectKey(Montage)))
+	{
+		return *Found;
+	}
+
+	TSharedRef<FCombatMontageEventTable> Table = MakeShared<FCombatMontageEventTable>();
+	Table->Bake(Montage);
+
+	BakedTables.Add(FObjectKey(Montage), Table);
+
+	return Table;
+}
+
+void FCombatMontageEventTable::Bake(const UAnimMontage* Montage)
+{
+	Events.Reset();
+
+	if (!Montage)
+	{
+		return;
+	}
+
+	// the notifies on the montage itself
+	for (const FAnimNotifyEvent& NotifyEvent : Montage->Notifies)
+	{
+		AddNotifyEvent(Montage, NotifyEvent.Notify, NotifyEvent.GetTriggerTime());
+	}
+
+	// the notifies on the sequences the montage plays also fire at runtime, so bake them at every montage time their segments play them
+	for (const FSlotAnimationTrack& SlotTrack : Montage->SlotAnimTracks)
+	{
+		for (const FAnimSegment& Segment : SlotTrack.AnimTrack.AnimSegments)
+		{
+			const UAnimSequenceBase* Sequence = Segment.GetAnimReference();
+			const float SegmentLength = Segment.AnimEndTime - Segment.AnimStartTime;
+			const float PlayRate = FMath::Abs(Segment.AnimPlayRate);
+
+			if (!Sequence || SegmentLength <= 0.0f || PlayRate <= UE_SMALL_NUMBER)
+			{
+				continue;
+			}
+
+			for (const FAnimNotifyEvent& NotifyEvent : Sequence->Notifies)
+			{
+				const float AnimTime = NotifyEvent.GetTriggerTime();
+
+				if (AnimTime < Segment.AnimStartTime || AnimTime > Segment.AnimEndTime)
+				{
+					continue;
+				}
+
+				// segments can play their sequence backwards, and loop it several times
+				const float SegmentTime = Segment.AnimPlayRate >= 0.0f ? AnimTime - Segment.AnimStartTime : Segment.AnimEndTime - AnimTime;
+
+				for (int32 Loop = 0; Loop < FMath::Max(Segment.LoopingCount, 1); ++Loop)
+				{
+					AddNotifyEvent(Montage, NotifyEvent.Notify, Segment.StartPos + (Loop * SegmentLength + SegmentTime) / PlayRate);
+				}
+			}
+		}
+	}
+
+	Events.Sort([](const FCombatMontageEvent& A, const FCombatMontageEvent& B) { return A.Time < B.Time; });
+	Events.Shrink();
+
+	// an attack montage without events would never trace or open its combo windows on servers, so make it obvious
+	if (Events.IsEmpty())
+	{
+		UE_LOG(LogExampleProject, Error, TEXT("Attack montage %s has no DoAttackTrace, CheckCombo or CheckChargedAttack notifies to bake. Its attacks won't trigger any gameplay events on servers that skip animation."), *Montage->GetPathName());
+	}
+}
+
+void FCombatMontageEventTable::AddNotifyEvent(const UAnimMontage* Montage, const UAnimNotify* Notify, float Time)
+{
+	FCombatMontageEvent Event;
+	Event.Time = Time;
+
+	// only keep the notifies that drive gameplay
+	if (const UAnimNotify_DoAttackTrace* AttackTraceNotify = Cast<UAnimNotify_DoAttackTrace>(Notify))
+	{
+		Event.Type = ECombatMontageEventType::AttackTrace;
+		Event.BoneName = AttackTraceNotify->GetAttackBoneName();
+
+	} else if (Cast<UAnimNotify_CheckCombo>(Notify)) {
+
+		Event.Type = ECombatMontageEventType::CheckCombo;
+
+	} else if (Cast<UAnimNotify_CheckChargedAttack>(Notify)) {
+
+		Event.Type = ECombatMontageEventType::CheckChargedAttack;
+
+	} else {
+
+		return;
+
+	}
+
+	// the same sequence can play in several slots at once, but its notifies only fire once
+	const bool bDuplicate = Events.ContainsByPredicate([&Event](const FCombatMontageEvent& Other)
+	{
+		return Other.Type == Event.Type && Other.BoneName == Event.BoneName && FMath::IsNearlyEqual(Other.Time, Event.Time);
+	});
+
+	if (bDuplicate)
+	{
+		return;
+	}
+
+	if (Event.Type == ECombatMontageEventType::AttackTrace)
+	{
+		Event.bHasBoneLocation = SampleBoneLocation(Montage, Event.Time, Event.BoneName, Event.BoneLocation);
+	}
+
+	Events.Add(Event);
+}
+
+void FCombatMontageEventTable::ReleaseUnloadedTables()
+{
+	for (auto It = CombatMontageEvents::BakedTables.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().ResolveObjectPtr())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+bool FCombatMontageEventTable::SampleBoneLocation(const UAnimMontage* Montage, float Time, FName BoneName, FVector3f& OutLocation)
+{
+	const USkeleton* Skeleton = Montage->GetSkeleton();
+
+	if (!Skeleton)
+	{
+		return false;
+	}
+
+	// find the first slot with an animation playing at this time. Slots can be empty for parts of the montage
+	const FAnimSegment* Segment = nullptr;
+	const UAnimSequence* Sequence = nullptr;
+
+	for (const FSlotAnimationTrack& SlotTrack : Montage->SlotAnimTracks)
+	{
+		Segment = SlotTrack.AnimTrack.GetSegmentAtTime(Time);
+		Sequence = Segment ? Cast<UAnimSequence>(Segment->GetAnimReference()) : nullptr;
+
+		if (Sequence)
+		{
+			break;
+		}
+	}
+
+	if (!Sequence)
+	{
+		return false;
+	}
+
+	// resolve sockets to their bone
+	FTransform ComponentTransform = FTransform::Identity;
+
+	if (const USkeletalMeshSocket* Socket = Skeleton->FindSocket(BoneName))
+	{
+		ComponentTransform = Socket->GetSocketLocalTransform();
+		BoneName = Socket->BoneName;
+	}
+
+	const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+
+	int32 BoneIndex = RefSkeleton.FindBoneIndex(BoneName);
+
+	if (BoneIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// accumulate the local bone transforms up to the root
+	const double SequenceTime = Segment->ConvertTrackPosToAnimPos(Time);
+
+	for (; BoneIndex != INDEX_NONE; BoneIndex = RefSkeleton.GetParentIndex(BoneIndex))
+	{
+		FTransform BoneTransform;
+		Sequence->GetBoneTransform(BoneTransform, FSkeletonPoseBoneIndex(BoneIndex), SequenceTime, false);
+
+		ComponentTransform *= BoneTransform;
+	}
+
+	OutLocation = FVector3f(ComponentTransform.GetLocation());
+
+	return true;
+}
+
+void FCombatMontageEventPlayer::Play(UAnimMontage* InMontage, float InPlayRate)
+{
+	Stop();
+
+	if (!InMontage || InMontage->CompositeSections.IsEmpty())
+	{
+		return;
+	}
+
+	Montage = InMontage;
+	Table = FCombatMontageEventTable::FindOrBake(InMontage);
+	PlayRate = InPlayRate;
+	Position = 0.0f;
+	SectionIndex = InMontage->GetSectionIndexFromPosition(Position);
+}
+
+void FCombatMontageEventPlayer::Stop()
+{
+	Montage.Reset();
+	Table.Reset();
+	SectionIndex = INDEX_NONE;
+	bSkipEventsAtPosition = false;
+}
+
+bool FCombatMontageEventPlayer::JumpToSection(FName SectionName)
+{
+	const UAnimMontage* PlayingMontage = Montage.Get();
+
+	if (!PlayingMontage)
+	{
+		return false;
+	}
+
+	const int32 NewSectionIndex = PlayingMontage->GetSectionIndex(SectionName);
+
+	if (NewSectionIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	float SectionEnd;
+	PlayingMontage->GetSectionStartAndEndTime(NewSectionIndex, Position, SectionEnd);
+
+	SectionIndex = NewSectionIndex;
+	bSkipEventsAtPosition = false;
+	++JumpCount;
+
+	return true;
+}
+
+bool FCombatMontageEventPlayer::Advance(float DeltaTime, ICombatAttacker& Attacker, const USkeletalMeshComponent& Mesh)
+{
+	const UAnimMontage* PlayingMontage = Montage.Get();
+
+	if (!PlayingMontage)
+	{
+		return false;
+	}
+
+	// keep the table alive even if an event restarts playback
+	const TSharedPtr<const FCombatMontageEventTable> PlayingTable = Table;
+
+	float Remaining = DeltaTime * PlayRate;
+
+	// a few section transitions per update is plenty, and guards against zero length section loops
+	for (int32 Iteration = 0; Iteration < 8 && Remaining > 0.0f; ++Iteration)
+	{
+		float SectionStart, SectionEnd;
+		PlayingMontage->GetSectionStartAndEndTime(SectionIndex, SectionStart, SectionEnd);
+
+		const float NewPosition = FMath::Min(Position + Remaining, SectionEnd);
+
+		// events exactly at the section end fire before we leave the section, since the next section may not start there
+		const bool bReachesSectionEnd = NewPosition >= SectionEnd;
+
+		// fire the events we cross
+		const uint32 StartJumpCount = JumpCount;
+		const bool bSkipStartEvents = bSkipEventsAtPosition;
+
+		bSkipEventsAtPosition = false;
+
+		for (const FCombatMontageEvent& Event : PlayingTable->Events)
+		{
+			if (Event.Time > NewPosition || (Event.Time == NewPosition && !bReachesSectionEnd))
+			{
+				break;
+			}
+
+			if (Event.Time > Position || (Event.Time == Position && !bSkipStartEvents))
+			{
+				DispatchEvent(Event, Attacker, Mesh);
+
+				// the event jumped to another section or stopped playback, so pick up from there on the next update
+				if (JumpCount != StartJumpCount || Montage.Get() != PlayingMontage)
+				{
+					return false;
+				}
+			}
+		}
+
+		Remaining -= NewPosition - Position;
+		Position = NewPosition;
+
+		if (Position < SectionEnd)
+		{
+			break;
+		}
+
+		// move on to the next section, or finish
+		const int32 NextSectionIndex = PlayingMontage->GetSectionIndex(PlayingMontage->CompositeSections[SectionIndex].NextSectionName);
+
+		if (NextSectionIndex == INDEX_NONE)
+		{
+			Stop();
+			return true;
+		}
+
+		const float PreviousSectionEnd = SectionEnd;
+
+		SectionIndex = NextSectionIndex;
+		PlayingMontage->GetSectionStartAndEndTime(SectionIndex, Position, SectionEnd);
+
+		// don't fire the section end events again if the next section continues from there
+		bSkipEventsAtPosition = Position == PreviousSectionEnd;
+	}
+
+	return false;
+}
+
+void FCombatMontageEventPlayer::DispatchEvent(const FCombatMontageEvent& Event, ICombatAttacker& Attacker, const USkeletalMeshComponent& Mesh) const
+{
+	switch (Event.Type)
+	{
+	case ECombatMontageEventType::AttackTrace:
+
+		// trace from the baked damage source location, so we don't need the evaluated pose
+		if (Event.bHasBoneLocation)
+		{
+			Attacker.DoAttackTraceFrom(Mesh.GetComponentTransform().TransformPosition(FVector(Event.BoneLocation)));
+
+		} else {
+
+			Attacker.DoAttackTrace(Event.BoneName);
+
+		}
+		break;
+
+	case ECombatMontageEventType::CheckCombo:
+
+		Attacker.CheckCombo();
+		break;
+
+	case ECombatMontageEventType::CheckChargedAttack:
+
+		Attacker.CheckChargedAttack();
+		break;
+	}
+}
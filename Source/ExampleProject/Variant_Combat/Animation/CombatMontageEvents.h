@@ -0,0 +1,118 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UAnimMontage;
+class UAnimNotify;
+class USkeletalMeshComponent;
+class ICombatAttacker;
+
+/** Gameplay event types baked from the combat AnimNotifies */
+enum class ECombatMontageEventType : uint8
+{
+	AttackTrace,
+	CheckCombo,
+	CheckChargedAttack
+};
+
+/** Gameplay event baked from a montage AnimNotify */
+struct FCombatMontageEvent
+{
+	/** Montage time the event fires at */
+	float Time = 0.0f;
+
+	/** Event type */
+	ECombatMontageEventType Type = ECombatMontageEventType::AttackTrace;
+
+	/** If true, BoneLocation was baked. Otherwise attack traces fall back to the socket on the mesh */
+	bool bHasBoneLocation = false;
+
+	/** Damage source bone or socket for attack traces */
+	FName BoneName;
+
+	/** Component space location of the damage source at the event time, sampled from the montage's bone tracks */
+	FVector3f BoneLocation = FVector3f::ZeroVector;
+};
+
+/**
+ *  Compact table of the gameplay events in a montage, sorted by time.
+ *  Tables are baked once per montage and shared by every character that plays it.
+ *  Tables for montages that were unloaded are released after garbage collection.
+ */
+struct FCombatMontageEventTable
+{
+	/** Baked events, sorted by time */
+	TArray<FCombatMontageEvent> Events;
+
+	/** Returns the event table for a montage, baking it the first time it's requested */
+	static TSharedRef<const FCombatMontageEventTable> FindOrBake(const UAnimMontage* Montage);
+
+	/** Rebuilds the table from the AnimNotifies on the montage and on the sequences its segments play */
+	void Bake(const UAnimMontage* Montage);
+
+protected:
+
+	/** Adds the event for a gameplay AnimNotify firing at a montage time. Other notifies are ignored */
+	void AddNotifyEvent(const UAnimMontage* Montage, const UAnimNotify* Notify, float Time);
+
+	/** Samples the component space location of a bone or socket at a montage time. Returns false if it can't be sampled */
+	static bool SampleBoneLocation(const UAnimMontage* Montage, float Time, FName BoneName, FVector3f& OutLocation);
+
+	/** Releases the baked tables of montages that no longer exist */
+	static void ReleaseUnloadedTables();
+};
+
+/**
+ *  Plays back a montage's section timeline and fires its baked gameplay events,
+ *  so attacks keep their timing without ticking the anim instance or evaluating the pose.
+ */
+class FCombatMontageEventPlayer
+{
+public:
+
+	/** Starts playing a montage from its start */
+	void Play(UAnimMontage* InMontage, float InPlayRate = 1.0f);
+
+	/** Stops playback without firing any more events */
+	void Stop();
+
+	/** Jumps to the start of a section. Returns false if the section wasn't found */
+	bool JumpToSection(FName SectionName);
+
+	/** Advances playback, dispatching the events crossed to the attacker. Returns true if the montage finished during this update */
+	bool Advance(float DeltaTime, ICombatAttacker& Attacker, const USkeletalMeshComponent& Mesh);
+
+	/** Returns true if a montage is playing */
+	bool IsPlaying() const { return Montage.IsValid(); }
+
+	/** Returns the playing montage */
+	UAnimMontage* GetMontage() const { return Montage.Get(); }
+
+protected:
+
+	/** Calls the attacker function for an event */
+	void DispatchEvent(const FCombatMontageEvent& Event, ICombatAttacker& Attacker, const USkeletalMeshComponent& Mesh) const;
+
+	/** Playing montage */
+	TWeakObjectPtr<UAnimMontage> Montage;
+
+	/** Baked events for the playing montage */
+	TSharedPtr<const FCombatMontageEventTable> Table;
+
+	/** Index of the current montage section */
+	int32 SectionIndex = INDEX_NONE;
+
+	/** Current montage time */
+	float Position = 0.0f;
+
+	/** Playback rate */
+	float PlayRate = 1.0f;
+
+	/** Incremented on every section jump, so event dispatch can stop when an event jumps */
+	uint32 JumpCount = 0;
+
+	/** If true, the events at the current position already fired at the end of the previous section */
+	bool bSkipEventsAtPosition = false;
+};
@@ -7,6 +7,7 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimMontage.h"
 #include "Camera/CameraComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "EnhancedInputComponent.h"
@@ -15,6 +16,41 @@
 #include "TimerManager.h"
 #include "Engine/LocalPlayer.h"
 #include "CombatPlayerController.h"
+#include "../Core/InputBufferComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+
+namespace CombatAttackState
+{
+	/** Packs the attack state into 16 bits: 4 bits of attack counter, 2 bits of attack type and 4 bits of montage section */
+	uint16 Pack(uint8 Counter, ECombatAttackType Type, uint8 Section)
+	{
+		return static_cast<uint16>((Counter & 0xF) | ((static_cast<uint8>(Type) & 0x3) << 4) | ((Section & 0xF) << 6));
+	}
+
+	/** Unpacks the attack state */
+	void Unpack(uint16 State, uint8& OutCounter, ECombatAttackType& OutType, uint8& OutSection)
+	{
+		OutCounter = State & 0xF;
+		OutType = static_cast<ECombatAttackType>((State >> 4) & 0x3);
+		OutSection = (State >> 6) & 0xF;
+	}
+
+	/** Returns the server time estimate in wrapping milliseconds */
+	uint16 GetTimeStamp(const UWorld* World)
+	{
+		const AGameStateBase* GameState = World->GetGameState();
+		const double ServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+
+		return static_cast<uint16>(static_cast<int64>(ServerTime * 1000.0) & 0xFFFF);
+	}
+
+	/** Returns true if an attack input starts a new attack, rather than being buffered to continue the current one */
+	bool StartsNewAttack(ECombatAttackInput Input, bool bIsAttacking)
+	{
+		return Input != ECombatAttackInput::ChargedReleased && !bIsAttacking;
+	}
+}
 
 ACombatCharacter::ACombatCharacter()
 {
@@ -47,6 +83,9 @@ ACombatCharacter::ACombatCharacter()
 	LifeBar = CreateDefaultSubobject<UWidgetComponent>(TEXT("LifeBar"));
 	LifeBar->SetupAttachment(RootComponent);
 
+	// create the input buffer
+	InputBuffer = CreateDefaultSubobject<UInputBufferComponent>(TEXT("InputBuffer"));
+
 	// set the player tag
 	Tags.Add(FName("Player"));
 }
@@ -117,12 +156,40 @@ void ACombatCharacter::DoLook(float Yaw, float Pitch)
 }
 
 void ACombatCharacter::DoComboAttackStart()
+{
+	// let the server validate the input, and predict it locally
+	SendAttackInput(ECombatAttackInput::ComboPressed);
+
+	HandleComboAttackInput(GetWorld()->GetTimeSeconds());
+}
+
+void ACombatCharacter::DoComboAttackEnd()
+{
+	// stub
+}
+
+void ACombatCharacter::DoChargedAttackStart()
+{
+	// let the server validate the input, and predict it locally
+	SendAttackInput(ECombatAttackInput::ChargedPressed);
+
+	HandleChargedAttackInput(GetWorld()->GetTimeSeconds());
+}
+
+void ACombatCharacter::DoChargedAttackEnd()
+{
+	SendAttackInput(ECombatAttackInput::ChargedReleased);
+
+	HandleChargedAttackRelease();
+}
+
+void ACombatCharacter::HandleComboAttackInput(double InputTime)
 {
 	// are we already playing an attack animation?
 	if (bIsAttacking)
 	{
-		// cache the input time so we can check it later
-		CachedAttackInputTime = GetWorld()->GetTimeSeconds();
+		// buffer the input so we can check it later
+		InputBuffer->RecordInputAt(ComboAttackAction, InputTime);
 
 		return;
 	}
@@ -131,20 +198,15 @@ void ACombatCharacter::DoComboAttackStart()
 	ComboAttack();
 }
 
-void ACombatCharacter::DoComboAttackEnd()
-{
-	// stub
-}
-
-void ACombatCharacter::DoChargedAttackStart()
+void ACombatCharacter::HandleChargedAttackInput(double InputTime)
 {
 	// raise the charging attack flag
 	bIsChargingAttack = true;
 
 	if (bIsAttacking)
 	{
-		// cache the input time so we can check it later
-		CachedAttackInputTime = GetWorld()->GetTimeSeconds();
+		// buffer the input so we can check it later
+		InputBuffer->RecordInputAt(ChargedAttackAction, InputTime);
 
 		return;
 	}
@@ -152,7 +214,7 @@ void ACombatCharacter::DoChargedAttackStart()
 	ChargedAttack();
 }
 
-void ACombatCharacter::DoChargedAttackEnd()
+void ACombatCharacter::HandleChargedAttackRelease()
 {
 	// lower the charging attack flag
 	bIsChargingAttack = false;
@@ -181,19 +243,11 @@ void ACombatCharacter::ComboAttack()
 	// reset the combo count
 	ComboCount = 0;
 
-	// play the attack montage
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-	{
-		const float MontageLength = AnimInstance->Montage_Play(ComboAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
-
-		// subscribe to montage completed and interrupted events
-		if (MontageLength > 0.0f)
-		{
-			// set the end delegate for the montage
-			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ComboAttackMontage);
-		}
-	}
+	// replicate the new attack
+	UpdateAttackState(ECombatAttackType::Combo, 0, true);
 
+	// play the attack montage
+	PlayAttackMontage(ComboAttackMontage);
 }
 
 void ACombatCharacter::ChargedAttack()
@@ -204,18 +258,11 @@ void ACombatCharacter::ChargedAttack()
 	// reset the charge loop flag
 	bHasLoopedChargedAttack = false;
 
-	// play the charged attack montage
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-	{
-		const float MontageLength = AnimInstance->Montage_Play(ChargedAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+	// replicate the new attack
+	UpdateAttackState(ECombatAttackType::Charged, 0, true);
 
-		// subscribe to montage completed and interrupted events
-		if (MontageLength > 0.0f)
-		{
-			// set the end delegate for the montage
-			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ChargedAttackMontage);
-		}
-	}
+	// play the charged attack montage
+	PlayAttackMontage(ChargedAttackMontage);
 }
 
 void ACombatCharacter::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted)
@@ -223,8 +270,10 @@ void ACombatCharacter::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupt
 	// reset the attacking flag
 	bIsAttacking = false;
 
-	// check if we have a non-stale cached input
-	if (GetWorld()->GetTimeSeconds() - CachedAttackInputTime <= AttackInputCacheTimeTolerance)
+	UpdateAttackState(ECombatAttackType::None, 0, false);
+
+	// check if we have a non-stale buffered input
+	if (ConsumeAttackInput(AttackInputCacheTimeTolerance))
 	{
 		// are we holding the charged attack button?
 		if (bIsChargingAttack)
@@ -240,13 +289,264 @@ void ACombatCharacter::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupt
 	}
 }
 
+void ACombatCharacter::SendAttackInput(ECombatAttackInput Input)
+{
+	// the server and standalone games handle their inputs directly
+	if (HasAuthority() || !IsLocallyControlled())
+	{
+		return;
+	}
+
+	// this is called before the input is handled locally, so the attacking flag tells us what the client is about to predict
+	ServerAttackInput(Input, CombatAttackState::GetTimeStamp(GetWorld()), CombatAttackState::StartsNewAttack(Input, bIsAttacking));
+}
+
+void ACombatCharacter::ServerAttackInput_Implementation(ECombatAttackInput Input, uint16 TimeStamp, bool bPredictedNewAttack)
+{
+	// tell the client to drop its prediction if we didn't accept the input
+	if (!AcceptAttackInput(Input, TimeStamp, bPredictedNewAttack))
+	{
+		ClientRejectAttackInput();
+	}
+}
+
+bool ACombatCharacter::AcceptAttackInput(ECombatAttackInput Input, uint16 TimeStamp, bool bPredictedNewAttack)
+{
+	// find out how long ago the client pressed the input. Small negative ages come from the client's server time estimate
+	const int16 InputAgeMs = static_cast<int16>(CombatAttackState::GetTimeStamp(GetWorld()) - TimeStamp);
+	const float InputAge = FMath::Max(InputAgeMs, 0) / 1000.0f;
+
+	// don't trust inputs that are too old
+	if (InputAge > MaxAttackInputLatency && Input != ECombatAttackInput::ChargedReleased)
+	{
+		return false;
+	}
+
+	// the client started a new attack while we're still attacking, or buffered the input while we're idle.
+	// Don't act on an input the client mispredicted, or we'd be playing a different attack than the client
+	if (CombatAttackState::StartsNewAttack(Input, bIsAttacking) != bPredictedNewAttack)
+	{
+		return false;
+	}
+
+	// validate buffered inputs against the combo windows at the time the client pressed them
+	const double InputTime = GetWorld()->GetTimeSeconds() - InputAge;
+
+	switch (Input)
+	{
+	case ECombatAttackInput::ComboPressed:
+
+		HandleComboAttackInput(InputTime);
+		break;
+
+	case ECombatAttackInput::ChargedPressed:
+
+		HandleChargedAttackInput(InputTime);
+		break;
+
+	case ECombatAttackInput::ChargedReleased:
+
+		HandleChargedAttackRelease();
+		break;
+	}
+
+	return true;
+}
+
+void ACombatCharacter::ClientRejectAttackInput_Implementation()
+{
+	// drop any other buffered inputs, so stopping the attack doesn't start another one
+	InputBuffer->Clear();
+
+	bIsChargingAttack = false;
+
+	// stop the predicted attack
+	StopAttackMontages();
+}
+
+void ACombatCharacter::StopAttackMontages()
+{
+	// stop the baked events, and end the attack like an interrupted montage would
+	if (bUseBakedMontageEvents)
+	{
+		if (MontageEvents.IsPlaying())
+		{
+			UAnimMontage* Montage = MontageEvents.GetMontage();
+			MontageEvents.Stop();
+
+			AttackMontageEnded(Montage, true);
+		}
+
+		// stop any montage playing for its root motion. It has no end delegate, so this doesn't end the attack twice
+		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+		{
+			AnimInstance->Montage_Stop(0.1f, ComboAttackMontage);
+			AnimInstance->Montage_Stop(0.1f, ChargedAttackMontage);
+		}
+
+		return;
+	}
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->Montage_Stop(0.1f, ComboAttackMontage);
+		AnimInstance->Montage_Stop(0.1f, ChargedAttackMontage);
+	}
+}
+
+void ACombatCharacter::UpdateAttackState(ECombatAttackType Type, uint8 Section, bool bNewAttack)
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	if (bNewAttack)
+	{
+		++AttackCounter;
+	}
+
+	AttackState = CombatAttackState::Pack(AttackCounter, Type, Section);
+}
+
+void ACombatCharacter::OnRep_AttackState(uint16 PreviousAttackState)
+{
+	uint8 Counter, PreviousCounter, Section, PreviousSection;
+	ECombatAttackType Type, PreviousType;
+
+	CombatAttackState::Unpack(AttackState, Counter, Type, Section);
+	CombatAttackState::Unpack(PreviousAttackState, PreviousCounter, PreviousType, PreviousSection);
+
+	// let the montage finish on its own when the attack ends
+	if (Type == ECombatAttackType::None)
+	{
+		return;
+	}
+
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+
+	if (!AnimInstance)
+	{
+		return;
+	}
+
+	UAnimMontage* Montage = Type == ECombatAttackType::Combo ? ComboAttackMontage : ChargedAttackMontage;
+
+	// restart the montage for new attacks. Proxies only play it cosmetically, so we don't need the end delegate
+	if (Counter != PreviousCounter || Type != PreviousType)
+	{
+		AnimInstance->Montage_Play(Montage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+	}
+
+	// follow the server's section changes
+	const FName SectionName = GetAttackSectionName(Type, Section);
+
+	if (Section > 0 && !SectionName.IsNone())
+	{
+		AnimInstance->Montage_JumpToSection(SectionName, Montage);
+	}
+}
+
+FName ACombatCharacter::GetAttackSectionName(ECombatAttackType Type, uint8 Section) const
+{
+	if (Type == ECombatAttackType::Combo)
+	{
+		return ComboSectionNames.IsValidIndex(Section) ? ComboSectionNames[Section] : NAME_None;
+	}
+
+	// charged attacks start at the montage start, then loop or release
+	if (Type == ECombatAttackType::Charged)
+	{
+		return Section == 1 ? ChargeLoopSection : (Section == 2 ? ChargeAttackSection : NAME_None);
+	}
+
+	return NAME_None;
+}
+
+void ACombatCharacter::PlayAttackMontage(UAnimMontage* Montage)
+{
+	// without a ticking anim instance, play back the baked montage events instead
+	if (bUseBakedMontageEvents)
+	{
+		MontageEvents.Play(Montage);
+
+		// the baked events don't move the pawn, so keep playing root motion montages for their root motion.
+		// Only the montage ticks, the notifies skip themselves and the baked player ends the attack
+		if (Montage && Montage->HasRootMotion())
+		{
+			if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+			{
+				AnimInstance->Montage_Play(Montage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+			}
+		}
+
+		return;
+	}
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		const float MontageLength = AnimInstance->Montage_Play(Montage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+
+		// subscribe to montage completed and interrupted events
+		if (MontageLength > 0.0f)
+		{
+			// set the end delegate for the montage
+			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, Montage);
+		}
+	}
+}
+
+void ACombatCharacter::JumpToAttackSection(FName SectionName, UAnimMontage* Montage)
+{
+	if (bUseBakedMontageEvents)
+	{
+		MontageEvents.JumpToSection(SectionName);
+
+		// keep any root motion montage in step with the baked events
+		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+		{
+			if (AnimInstance->Montage_IsPlaying(Montage))
+			{
+				AnimInstance->Montage_JumpToSection(SectionName, Montage);
+			}
+		}
+
+		return;
+	}
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->Montage_JumpToSection(SectionName, Montage);
+	}
+}
+
+bool ACombatCharacter::ConsumeAttackInput(float TimeWindow)
+{
+	// either attack input continues the attack, so consume both
+	const bool bComboInput = InputBuffer->ConsumeInput(ComboAttackAction, TimeWindow);
+	const bool bChargedInput = InputBuffer->ConsumeInput(ChargedAttackAction, TimeWindow);
+
+	return bComboInput || bChargedInput;
+}
+
 void ACombatCharacter::DoAttackTrace(FName DamageSourceBone)
 {
+	// start at the provided socket location
+	DoAttackTraceFrom(GetMesh()->GetSocketLocation(DamageSourceBone));
+}
+
+void ACombatCharacter::DoAttackTraceFrom(const FVector& TraceStart)
+{
+	// damage is only dealt by the server
+	if (!HasAuthority())
+	{
+		return;
+	}
+
 	// sweep for objects in front of the character to be hit by the attack
 	TArray<FHitResult> OutHits;
 
-	// start at the provided socket location, sweep forward
-	const FVector TraceStart = GetMesh()->GetSocketLocation(DamageSourceBone);
+	// sweep forward from the trace start
 	const FVector TraceEnd = TraceStart + (GetActorForwardVector() * MeleeTraceDistance);
 
 	// check for pawn and world dynamic collision object types
@@ -287,15 +587,18 @@ void ACombatCharacter::DoAttackTrace(FName DamageSourceBone)
 
 void ACombatCharacter::CheckCombo()
 {
+	// simulated proxies follow the replicated attack state instead
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
 	// are we playing a non-charge attack animation?
 	if (bIsAttacking && !bIsChargingAttack)
 	{
-		// is the last attack input not stale?
-		if (GetWorld()->GetTimeSeconds() - CachedAttackInputTime <= ComboInputCacheTimeTolerance)
+		// is the last attack input not stale? Consume it so we don't accidentally trigger it twice
+		if (ConsumeAttackInput(ComboInputCacheTimeTolerance))
 		{
-			// consume the attack input so we don't accidentally trigger it twice
-			CachedAttackInputTime = 0.0f;
-
 			// increase the combo counter
 			++ComboCount;
 
@@ -303,10 +606,9 @@ void ACombatCharacter::CheckCombo()
 			if (ComboCount < ComboSectionNames.Num())
 			{
 				// jump to the next combo section
-				if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-				{
-					AnimInstance->Montage_JumpToSection(ComboSectionNames[ComboCount], ComboAttackMontage);
-				}
+				UpdateAttackState(ECombatAttackType::Combo, ComboCount, false);
+
+				JumpToAttackSection(ComboSectionNames[ComboCount], ComboAttackMontage);
 			}
 		}
 	}
@@ -314,14 +616,19 @@ void ACombatCharacter::CheckCombo()
 
 void ACombatCharacter::CheckChargedAttack()
 {
+	// simulated proxies follow the replicated attack state instead
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
 	// raise the looped charged attack flag
 	bHasLoopedChargedAttack = true;
 
 	// jump to either the loop or the attack section depending on whether we're still holding the charge button
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-	{
-		AnimInstance->Montage_JumpToSection(bIsChargingAttack ? ChargeLoopSection : ChargeAttackSection, ChargedAttackMontage);
-	}
+	UpdateAttackState(ECombatAttackType::Charged, bIsChargingAttack ? 1 : 2, false);
+
+	JumpToAttackSection(bIsChargingAttack ? ChargeLoopSection : ChargeAttackSection, ChargedAttackMontage);
 }
 
 void ACombatCharacter::ApplyDamage(float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
@@ -421,10 +728,43 @@ void ACombatCharacter::Landed(const FHitResult& Hit)
 	}
 }
 
+void ACombatCharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// advance the baked attack events, and end the attack when the montage would have finished
+	if (MontageEvents.IsPlaying())
+	{
+		UAnimMontage* Montage = MontageEvents.GetMontage();
+
+		if (MontageEvents.Advance(DeltaSeconds, *this, *GetMesh()))
+		{
+			AttackMontageEnded(Montage, false);
+		}
+	}
+}
+
+void ACombatCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// the owning client predicts its own attacks
+	DOREPLIFETIME_CONDITION(ACombatCharacter, AttackState, COND_SkipOwner);
+}
+
 void ACombatCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// dedicated servers don't need the pose, so fire the attack events from the baked montage tables instead of AnimNotifies
+	bUseBakedMontageEvents = bSkipServerAnimation && GetNetMode() == NM_DedicatedServer;
+
+	if (bUseBakedMontageEvents)
+	{
+		// still tick the montages, so root motion attacks move the pawn like they do on the owning client
+		GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+	}
+
 	// get the life bar from the widget component
 	LifeBarWidget = Cast<UCombatLifeBar>(LifeBar->GetUserWidgetObject());
 	check(LifeBarWidget);
@@ -7,6 +7,7 @@
 #include "CombatAttacker.h"
 #include "CombatDamageable.h"
 #include "Animation/AnimInstance.h"
+#include "CombatMontageEvents.h"
 #include "CombatCharacter.generated.h"
 
 class USpringArmComponent;
@@ -15,9 +16,28 @@ class UInputAction;
 struct FInputActionValue;
 class UCombatLifeBar;
 class UWidgetComponent;
+class UInputBufferComponent;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogCombatCharacter, Log, All);
 
+/** Attack inputs sent from the owning client to the server */
+UENUM()
+enum class ECombatAttackInput : uint8
+{
+	ComboPressed,
+	ChargedPressed,
+	ChargedReleased
+};
+
+/** Attack types replicated to simulated proxies */
+UENUM()
+enum class ECombatAttackType : uint8
+{
+	None,
+	Combo,
+	Charged
+};
+
 /**
  *  An enhanced Third Person Character with melee combat capabilities:
  *  - Combo attack string
@@ -31,6 +51,8 @@ class ACombatCharacter : public ACharacter, public ICombatAttacker, public IComb
 {
 	GENERATED_BODY()
 
+	friend class FCombatAttackLatencyTest;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	USpringArmComponent* CameraBoom;
@@ -42,6 +64,10 @@ class ACombatCharacter : public ACharacter, public ICombatAttacker, public IComb
 	/** Life bar widget component */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	UWidgetComponent* LifeBar;
+
+	/** Buffers attack inputs that arrive while an attack is playing */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
+	UInputBufferComponent* InputBuffer;
 	
 protected:
 
@@ -93,9 +119,6 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Melee Attack", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
 	float AttackInputCacheTimeTolerance = 1.0f;
 
-	/** Time at which an attack button was last pressed */
-	float CachedAttackInputTime = 0.0f;
-
 	/** If true, the character is currently playing an attack animation */
 	bool bIsAttacking = false;
 
@@ -167,6 +190,27 @@ protected:
 	/** Attack montage ended delegate */
 	FOnMontageEnded OnAttackMontageEnded;
 
+	/** If true, dedicated servers skip pose ticks and fire the attack events from tables baked from the attack montages */
+	UPROPERTY(EditAnywhere, Category="Melee Attack")
+	bool bSkipServerAnimation = true;
+
+	/** If true, the attack montage events are played back from baked tables instead of AnimNotifies */
+	bool bUseBakedMontageEvents = false;
+
+	/** Plays back the attack montage events while the anim instance isn't ticking */
+	FCombatMontageEventPlayer MontageEvents;
+
+	/** Max age of a remote client's attack input that the server still accepts. Older inputs are rejected */
+	UPROPERTY(EditAnywhere, Category="Melee Attack|Network", meta = (ClampMin = 0, ClampMax = 2, Units = "s"))
+	float MaxAttackInputLatency = 0.5f;
+
+	/** Quantized attack state, packing an attack counter, the attack type and the montage section. Lets simulated proxies follow the server's attacks */
+	UPROPERTY(ReplicatedUsing=OnRep_AttackState)
+	uint16 AttackState = 0;
+
+	/** Number of attacks started on the server, so repeated attacks replicate */
+	uint8 AttackCounter = 0;
+
 	/** Character respawn timer */
 	FTimerHandle RespawnTimer;
 
@@ -235,6 +279,51 @@ protected:
 	/** Called from a delegate when the attack montage ends */
 	void AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted);
 
+	/** Plays an attack montage, or its baked events if we're skipping animation */
+	void PlayAttackMontage(UAnimMontage* Montage);
+
+	/** Jumps to a section of the playing attack montage */
+	void JumpToAttackSection(FName SectionName, UAnimMontage* Montage);
+
+	/** Consumes any buffered attack input within the time window. Returns true if one was found */
+	bool ConsumeAttackInput(float TimeWindow);
+
+	/** Handles a combo attack press at the provided world time */
+	void HandleComboAttackInput(double InputTime);
+
+	/** Handles a charged attack press at the provided world time */
+	void HandleChargedAttackInput(double InputTime);
+
+	/** Handles a charged attack release */
+	void HandleChargedAttackRelease();
+
+	/** Sends an attack input to the server if we're a remote client. The attack itself is predicted locally */
+	void SendAttackInput(ECombatAttackInput Input);
+
+	/** Sends an attack input with the client's estimate of the server time it was pressed at, in wrapping milliseconds, and whether the client started a new attack from it */
+	UFUNCTION(Server, Reliable)
+	void ServerAttackInput(ECombatAttackInput Input, uint16 TimeStamp, bool bPredictedNewAttack);
+
+	/** Validates and handles an attack input from the owning client on the server. Returns false if the input was rejected */
+	bool AcceptAttackInput(ECombatAttackInput Input, uint16 TimeStamp, bool bPredictedNewAttack);
+
+	/** Tells the owning client that an attack input was too old or mispredicted, so it can stop the predicted attack */
+	UFUNCTION(Client, Reliable)
+	void ClientRejectAttackInput();
+
+	/** Stops any playing attack montage, or its baked events */
+	void StopAttackMontages();
+
+	/** Updates the replicated attack state on the server */
+	void UpdateAttackState(ECombatAttackType Type, uint8 Section, bool bNewAttack);
+
+	/** Plays the replicated attack on simulated proxies */
+	UFUNCTION()
+	void OnRep_AttackState(uint16 PreviousAttackState);
+
+	/** Returns the montage section name for a replicated attack section, or None for the montage start */
+	FName GetAttackSectionName(ECombatAttackType Type, uint8 Section) const;
+
 	
 public:
 
@@ -249,6 +338,12 @@ public:
 	/** Performs the charged attack hold check */
 	virtual void CheckChargedAttack() override;
 
+	/** Performs the collision check for an attack from a world location */
+	virtual void DoAttackTraceFrom(const FVector& TraceStart) override;
+
+	/** Returns true if the attack events are fired from baked montage tables */
+	virtual bool UsesBakedMontageEvents() const override { return bUseBakedMontageEvents; }
+
 	// ~end CombatAttacker interface
 
 	// ~begin CombatDamageable interface
@@ -275,6 +370,12 @@ public:
 	/** Overrides landing to reset damage ragdoll physics */
 	virtual void Landed(const FHitResult& Hit) override;
 
+	/** Advances the baked attack montage events */
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Sets up the replicated attack state */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 protected:
 
 	/** Blueprint handler to play damage dealt effects */
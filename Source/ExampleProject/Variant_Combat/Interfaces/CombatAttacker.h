@@ -33,4 +33,10 @@ public:
 	/** Performs a charged attack's check to loop the charge animation. Usually called from a montage's AnimNotify */
 	UFUNCTION(BlueprintCallable, Category="Attacker")
 	virtual void CheckChargedAttack() = 0;
+
+	/** Performs an attack's collision check from a precomputed world location. Called from baked montage events */
+	virtual void DoAttackTraceFrom(const FVector& TraceStart) = 0;
+
+	/** Returns true if the attack montage events are fired from baked tables instead of AnimNotifies */
+	virtual bool UsesBakedMontageEvents() const { return false; }
 };
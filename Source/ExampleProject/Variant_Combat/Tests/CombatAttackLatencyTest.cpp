@@ -0,0 +1,185 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CombatCharacter.h"
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CombatAttackLatencyTest
+{
+	/** World ticks per second */
+	constexpr int32 StepRate = 60;
+
+	/** One way latency in ticks. 100ms, so 200ms round trip */
+	constexpr int32 LatencyFrames = 6;
+
+	/** One way latency of an input that got through faster than the previous one, so it reaches the server before its attack ends */
+	constexpr int32 JitteredLatencyFrames = 4;
+
+	/** Blueprint character with the attack montages and input actions set up */
+	const TCHAR* CharacterClassPath = TEXT("/Game/Variant_Combat/Blueprints/BP_CombatCharacter.BP_CombatCharacter_C");
+
+	/** Attack input sent from the client to the server */
+	struct FSentInput
+	{
+		int32 DeliveryFrame = 0;
+		ECombatAttackInput Input = ECombatAttackInput::ComboPressed;
+		uint16 TimeStamp = 0;
+		bool bPredictedNewAttack = false;
+	};
+
+	/** Returns the world time in wrapping milliseconds. Both characters share the world, so this is the exact server time */
+	uint16 GetTimeStamp(const UWorld* World)
+	{
+		return static_cast<uint16>(static_cast<int64>(World->GetTimeSeconds() * 1000.0) & 0xFFFF);
+	}
+}
+
+// the character needs its life bar widget, so this test doesn't run on servers
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatAttackLatencyTest, "ExampleProject.Combat.Attack.LatencyCorrection", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FCombatAttackLatencyTest::RunTest(const FString& Parameters)
+{
+	using namespace CombatAttackLatencyTest;
+
+	UClass* CharacterClass = LoadClass<ACombatCharacter>(nullptr, CharacterClassPath);
+
+	if (!TestNotNull(TEXT("Combat character class"), CharacterClass))
+	{
+		return false;
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	// one character stands in for the server, the other for the owning client. Keep them far apart so their attacks don't hit each other
+	ACombatCharacter* Server = World->SpawnActor<ACombatCharacter>(CharacterClass, FVector::ZeroVector, FRotator::ZeroRotator);
+	ACombatCharacter* Client = World->SpawnActor<ACombatCharacter>(CharacterClass, FVector(100000.0f, 0.0f, 0.0f), FRotator::ZeroRotator);
+
+	if (TestNotNull(TEXT("Server character"), Server) && TestNotNull(TEXT("Client character"), Client))
+	{
+		// play the attacks from the baked montage events, so they advance without a rendered pose
+		for (ACombatCharacter* Character : { Server, Client })
+		{
+			Character->GetCharacterMovement()->DisableMovement();
+			Character->bUseBakedMontageEvents = true;
+		}
+
+		TArray<FSentInput> InputsInFlight;
+		TArray<int32> RejectionsInFlight;
+
+		int32 Frame = 0;
+		int32 NumRejections = 0;
+
+		// presses the combo attack on the client, predicts it, and sends it to the server
+		auto PressComboAttack = [&](int32 Latency)
+		{
+			FSentInput Sent;
+			Sent.DeliveryFrame = Frame + Latency;
+			Sent.TimeStamp = GetTimeStamp(World);
+			Sent.bPredictedNewAttack = !Client->bIsAttacking;
+
+			// reliable RPCs arrive in order
+			if (InputsInFlight.Num() > 0)
+			{
+				Sent.DeliveryFrame = FMath::Max(Sent.DeliveryFrame, InputsInFlight.Last().DeliveryFrame);
+			}
+
+			InputsInFlight.Add(Sent);
+
+			Client->HandleComboAttackInput(World->GetTimeSeconds());
+		};
+
+		// delivers the messages that arrived, then ticks the world
+		auto StepFrame = [&]()
+		{
+			while (InputsInFlight.Num() > 0 && InputsInFlight[0].DeliveryFrame <= Frame)
+			{
+				const FSentInput Sent = InputsInFlight[0];
+				InputsInFlight.RemoveAt(0);
+
+				if (!Server->AcceptAttackInput(Sent.Input, Sent.TimeStamp, Sent.bPredictedNewAttack))
+				{
+					RejectionsInFlight.Add(Frame + LatencyFrames);
+					++NumRejections;
+				}
+			}
+
+			while (RejectionsInFlight.Num() > 0 && RejectionsInFlight[0] <= Frame)
+			{
+				RejectionsInFlight.RemoveAt(0);
+
+				Client->ClientRejectAttackInput_Implementation();
+			}
+
+			World->Tick(LEVELTICK_All, 1.0f / StepRate);
+			++Frame;
+		};
+
+		// steps until nothing is in flight and neither character is attacking. Returns false if that takes more than 10s
+		auto StepUntilSettled = [&]()
+		{
+			for (int32 i = 0; i < 10 * StepRate; ++i)
+			{
+				if (InputsInFlight.Num() == 0 && RejectionsInFlight.Num() == 0 && !Client->bIsAttacking && !Server->bIsAttacking)
+				{
+					return true;
+				}
+
+				StepFrame();
+			}
+
+			return false;
+		};
+
+		// a press at 200ms round trip: the server agrees with the prediction and plays the same attack
+		PressComboAttack(LatencyFrames);
+
+		for (int32 i = 0; i <= LatencyFrames; ++i)
+		{
+			StepFrame();
+		}
+
+		TestTrue(TEXT("The server started the predicted attack"), Server->bIsAttacking);
+
+		// press again as soon as the client's attack ends. The server lags 100ms behind, so it's still attacking when the input arrives
+		for (int32 i = 0; i < 10 * StepRate && Client->bIsAttacking; ++i)
+		{
+			StepFrame();
+		}
+
+		TestTrue(TEXT("The server is still attacking when the client's attack ends"), Server->bIsAttacking);
+
+		PressComboAttack(JitteredLatencyFrames);
+
+		TestTrue(TEXT("The client predicted a new attack"), Client->bIsAttacking);
+		TestTrue(TEXT("Everything settled after the mispredicted attack"), StepUntilSettled());
+
+		TestEqual(TEXT("The mispredicted attack was rejected"), NumRejections, 1);
+		TestEqual(TEXT("The server only played the first attack"), Server->AttackCounter, static_cast<uint8>(1));
+
+		// an input older than the max latency is rejected too, even though the client predicted it correctly
+		PressComboAttack(FMath::CeilToInt32((Server->MaxAttackInputLatency + 0.1f) * StepRate));
+
+		TestTrue(TEXT("Everything settled after the stale attack"), StepUntilSettled());
+
+		TestEqual(TEXT("The stale attack was rejected"), NumRejections, 2);
+		TestEqual(TEXT("The server didn't play the stale attack"), Server->AttackCounter, static_cast<uint8>(1));
+
+		AddInfo(FString::Printf(TEXT("%d rejected attack inputs at %.0f ms round trip."), NumRejections, LatencyFrames * 2 * 1000.0f / StepRate));
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif
@@ -10,7 +10,7 @@ void UAnimNotify_EndDash::Notify(USkeletalMeshComponent* MeshComp, UAnimSequence
 	// cast the owner to the attacker interface
 	if (APlatformingCharacter* PlatformingCharacter = Cast<APlatformingCharacter>(MeshComp->GetOwner()))
 	{
-		// tell the actor to end the dash
+		// tell the actor to end the dash. Timed dashes ignore this and end on the movement component
 		PlatformingCharacter->EndDash();
 	}
 }
@@ -7,7 +7,8 @@
 #include "AnimNotify_EndDash.generated.h"
 
 /**
- *  AnimNotify to finish the dash animation and restore player control
+ *  AnimNotify to finish the dash animation and restore player control.
+ *  Only ends untimed dashes. Timed dashes end on the platforming movement component
  */
 UCLASS()
 class UAnimNotify_EndDash : public UAnimNotify
@@ -4,25 +4,19 @@
 #include "PlatformingCharacter.h"
 
 #include "Components/CapsuleComponent.h"
-#include "GameFramework/CharacterMovementComponent.h"
+#include "PlatformingMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Camera/CameraComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "EnhancedInputComponent.h"
-#include "TimerManager.h"
 #include "Engine/LocalPlayer.h"
 
-APlatformingCharacter::APlatformingCharacter()
+APlatformingCharacter::APlatformingCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UPlatformingMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
  	PrimaryActorTick.bCanEverTick = true;
 
-	// initialize the flags
-	bHasWallJumped = false;
-	bHasDoubleJumped = false;
-	bHasDashed = false;
-	bIsDashing = false;
-
 	// bind the attack montage ended delegate
 	OnDashMontageEnded.BindUObject(this, &APlatformingCharacter::DashMontageEnded);
 
@@ -60,6 +54,10 @@ APlatformingCharacter::APlatformingCharacter()
 	GetCharacterMovement()->NavAgentProps.AgentRadius = 42.0;
 	GetCharacterMovement()->NavAgentProps.AgentHeight = 192.0;
 
+	// time the dash on the movement component, so the dash montage is purely cosmetic
+	GetPlatformingMovement()->DashSpeed = 1500.0f;
+	GetPlatformingMovement()->DashDuration = 0.35f;
+
 	// create the camera boom
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
 	CameraBoom->SetupAttachment(RootComponent);
@@ -103,83 +101,14 @@ void APlatformingCharacter::Dash()
 void APlatformingCharacter::MultiJump()
 {
 	// ignore jumps while dashing
-	if(bIsDashing)
+	if (GetPlatformingMovement()->IsDashing())
 		return;
 
 	// are we already in the air?
 	if (GetCharacterMovement()->IsFalling())
 	{
-
-		// have we already wall jumped?
-		if (!bHasWallJumped)
-		{
-			// run a sphere sweep to check if we're in front of a wall
-			FHitResult OutHit;
-
-			const FVector TraceStart = GetActorLocation();
-			const FVector TraceEnd = TraceStart + (GetActorForwardVector() * WallJumpTraceDistance);
-			const FCollisionShape TraceShape = FCollisionShape::MakeSphere(WallJumpTraceRadius);
-
-			FCollisionQueryParams QueryParams;
-			QueryParams.AddIgnoredActor(this);
-
-			if (GetWorld()->SweepSingleByChannel(OutHit, TraceStart, TraceEnd, FQuat(), ECollisionChannel::ECC_Visibility, TraceShape, QueryParams))
-			{
-				// rotate the character to face away from the wall, so we're correctly oriented for the next wall jump
-				FRotator WallOrientation = OutHit.ImpactNormal.ToOrientationRotator();
-				WallOrientation.Pitch = 0.0f;
-				WallOrientation.Roll = 0.0f;
-
-				SetActorRotation(WallOrientation);
-
-				// apply a launch impulse to the character to perform the actual wall jump
-				const FVector WallJumpImpulse = (OutHit.ImpactNormal * WallJumpBounceImpulse) + (FVector::UpVector * WallJumpVerticalImpulse);
-
-				LaunchCharacter(WallJumpImpulse, true, true);
-
-				// enable the jump trail
-				SetJumpTrailState(true);
-
-				// raise the wall jump flag to prevent an immediate second wall jump
-				bHasWallJumped = true;
-
-				GetWorld()->GetTimerManager().SetTimer(WallJumpTimer, this, &APlatformingCharacter::ResetWallJump, DelayBetweenWallJumps, false);
-			}
-			// no wall jump, try a double jump next
-			else
-			{
-				// are we still within coyote time frames?
-				if (GetWorld()->GetTimeSeconds() - LastFallTime < MaxCoyoteTime)
-				{
-					UE_LOG(LogTemp, Warning, TEXT("Coyote Jump"));
-
-					// use the built-in CMC functionality to do the jump
-					Jump();
-
-					// enable the jump trail
-					SetJumpTrailState(true);
-
-				// no coyote time jump
-				} else {
-
-					// only double jump once while we're in the air
-					if (!bHasDoubleJumped)
-					{
-						bHasDoubleJumped = true;
-
-						// use the built-in CMC functionality to do the double jump
-						Jump();
-
-						// enable the jump trail
-						SetJumpTrailState(true);
-					}
-
-				}
-
-				
-			}
-		}
-
+		// let the movement component decide between a wall jump, coyote time jump or double jump as part of a predicted move
+		GetPlatformingMovement()->RequestAirJump();
 	}
 	else
 	{
@@ -191,18 +120,12 @@ void APlatformingCharacter::MultiJump()
 	}
 }
 
-void APlatformingCharacter::ResetWallJump()
-{
-	// reset the wall jump input lock
-	bHasWallJumped = false;
-}
-
 void APlatformingCharacter::DoMove(float Right, float Forward)
 {
 	if (GetController() != nullptr)
 	{
 		// momentarily disable movement inputs if we've just wall jumped
-		if (!bHasWallJumped)
+		if (!GetPlatformingMovement()->HasWallJumped())
 		{
 			// find out which way is forward
 			const FRotator Rotation = GetController()->GetControlRotation();
@@ -233,20 +156,24 @@ void APlatformingCharacter::DoLook(float Yaw, float Pitch)
 
 void APlatformingCharacter::DoDash()
 {
-	// ignore the input if we've already dashed and have yet to reset
-	if (bHasDashed)
-		return;
-
-	// raise the dash flags
-	bIsDashing = true;
-	bHasDashed = true;
+	// let the movement component start the dash as part of a predicted move
+	GetPlatformingMovement()->RequestDash();
+}
 
-	// disable gravity while dashing
-	GetCharacterMovement()->GravityScale = 0.0f;
+void APlatformingCharacter::DoJumpStart()
+{
+	// handle special jump cases
+	MultiJump();
+}
 
-	// reset the character velocity so we don't carry momentum into the dash
-	GetCharacterMovement()->Velocity = FVector::ZeroVector;
+void APlatformingCharacter::DoJumpEnd()
+{
+	// stop jumping
+	StopJumping();
+}
 
+void APlatformingCharacter::DashStarted()
+{
 	// enable the jump trails
 	SetJumpTrailState(true);
 
@@ -259,25 +186,56 @@ void APlatformingCharacter::DoDash()
 		if (MontageLength > 0.0f)
 		{
 			AnimInstance->Montage_SetEndDelegate(OnDashMontageEnded, DashMontage);
+
+			// let the movement component move the character during timed dashes instead of the montage's root motion.
+			// Only ignore root motion while the dash montage plays, so other montages keep theirs
+			if (GetPlatformingMovement()->DashSpeed > 0.0f && !bIgnoringDashRootMotion)
+			{
+				DefaultRootMotionMode = AnimInstance->RootMotionMode;
+				AnimInstance->SetRootMotionMode(ERootMotionMode::IgnoreRootMotion);
+
+				bIgnoringDashRootMotion = true;
+			}
 		}
 	}
 }
 
-void APlatformingCharacter::DoJumpStart()
+void APlatformingCharacter::RestoreDashRootMotion()
 {
-	// handle special jump cases
-	MultiJump();
+	if (!bIgnoringDashRootMotion)
+	{
+		return;
+	}
+
+	bIgnoringDashRootMotion = false;
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->SetRootMotionMode(DefaultRootMotionMode);
+	}
 }
 
-void APlatformingCharacter::DoJumpEnd()
+void APlatformingCharacter::DashEnded()
 {
-	// stop jumping
-	StopJumping();
+	// deactivate the jump trails if we're grounded after the dash, since we won't receive a landed event
+	if (GetCharacterMovement()->IsMovingOnGround())
+	{
+		SetJumpTrailState(false);
+	}
+}
+
+void APlatformingCharacter::AirJumped()
+{
+	// enable the jump trail
+	SetJumpTrailState(true);
 }
 
 void APlatformingCharacter::DashMontageEnded(UAnimMontage* Montage, bool bInterrupted)
 {
-	// if the montage was interrupted, end the dash
+	// the dash montage is done, so montages can use root motion again
+	RestoreDashRootMotion();
+
+	// if the montage was interrupted, end any untimed dash
 	if (bInterrupted)
 	{
 		EndDash();
@@ -286,39 +244,54 @@ void APlatformingCharacter::DashMontageEnded(UAnimMontage* Montage, bool bInterr
 
 void APlatformingCharacter::EndDash()
 {
-	// restore gravity
-	GetCharacterMovement()->GravityScale = 2.5f;
-
-	// reset the dashing flag
-	bIsDashing = false;
-
-	// are we grounded after the dash?
-	if (GetCharacterMovement()->IsMovingOnGround())
+	// timed dashes end on the movement component, regardless of the animation
+	if (GetPlatformingMovement()->DashDuration > 0.0f)
 	{
-		// reset the dash usage flag, since we won't receive a landed event
-		bHasDashed = false;
-
-		// deactivate the jump trails
-		SetJumpTrailState(false);
+		return;
 	}
+
+	// end the dash on the movement component. This also restores gravity
+	GetPlatformingMovement()->EndDash();
 }
 
 bool APlatformingCharacter::HasDoubleJumped() const
 {
-	return bHasDoubleJumped;
+	return GetPlatformingMovement()->HasDoubleJumped();
 }
 
 bool APlatformingCharacter::HasWallJumped() const
 {
-	return bHasWallJumped;
+	return GetPlatformingMovement()->HasWallJumped();
 }
 
-void APlatformingCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+UPlatformingMovementComponent* APlatformingCharacter::GetPlatformingMovement() const
 {
-	Super::EndPlay(EndPlayReason);
+	return GetCharacterMovement<UPlatformingMovementComponent>();
+}
+
+void APlatformingCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// pass the wall jump and coyote time settings to the movement component, so Blueprint overrides apply
+	GetPlatformingMovement()->WallJumpTraceDistance = WallJumpTraceDistance;
+	GetPlatformingMovement()->WallJumpTraceRadius = WallJumpTraceRadius;
+	GetPlatformingMovement()->WallJumpHorizontalSpeed = WallJumpBounceImpulse;
+	GetPlatformingMovement()->WallJumpVerticalSpeed = WallJumpVerticalImpulse;
+	GetPlatformingMovement()->DelayBetweenWallJumps = DelayBetweenWallJumps;
+	GetPlatformingMovement()->MaxCoyoteTime = MaxCoyoteTime;
+
+	// play the ability effects when the movement component performs them
+	GetPlatformingMovement()->OnDashStarted.AddUObject(this, &APlatformingCharacter::DashStarted);
+	GetPlatformingMovement()->OnDashEnded.AddUObject(this, &APlatformingCharacter::DashEnded);
+	GetPlatformingMovement()->OnAirJump.AddUObject(this, &APlatformingCharacter::AirJumped);
+
+	// with a timed dash, the animation doesn't drive gameplay, so it doesn't need to tick on dedicated servers
+	if (bSkipServerAnimation && GetNetMode() == NM_DedicatedServer && GetPlatformingMovement()->DashDuration > 0.0f)
+	{
+		GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+	}
 
-	// clear the wall jump reset timer
-	GetWorld()->GetTimerManager().ClearTimer(WallJumpTimer);
 }
 
 void APlatformingCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -347,23 +320,6 @@ void APlatformingCharacter::Landed(const FHitResult& Hit)
 {
 	Super::Landed(Hit);
 
-	// reset the double jump and dash flags
-	bHasDoubleJumped = false;
-	bHasDashed = false;
-
 	// deactivate the jump trail
 	SetJumpTrailState(false);
 }
-
-void APlatformingCharacter::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode /*= 0*/)
-{
-	Super::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
-
-	// are we falling?
-	if (GetCharacterMovement()->MovementMode == EMovementMode::MOVE_Falling)
-	{
-		// save the game time when we started falling, so we can check it later for coyote time jumps
-		LastFallTime = GetWorld()->GetTimeSeconds();
-	}
-}
-
@@ -13,6 +13,7 @@ class UCameraComponent;
 class UInputAction;
 struct FInputActionValue;
 class UAnimMontage;
+class UPlatformingMovementComponent;
 
 /**
  *  An enhanced Third Person Character with the following functionality:
@@ -21,6 +22,7 @@ class UAnimMontage;
  *  - Double Jump
  *  - Wall Jump
  *  - Dash
+ *  The advanced movement abilities run on the platforming movement component, so they're network predicted.
  */
 UCLASS(abstract)
 class APlatformingCharacter : public ACharacter
@@ -59,8 +61,8 @@ protected:
 
 public:
 
-	/** Constructor */
-	APlatformingCharacter();
+	/** Constructor. Replaces the default movement component with the platforming movement component */
+	APlatformingCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 
@@ -76,9 +78,6 @@ protected:
 	/** Called for jump pressed to check for advanced multi-jump conditions */
 	void MultiJump();
 
-	/** Resets the wall jump input lock */
-	void ResetWallJump();
-
 public:
 
 	/** Handles move inputs from either controls or UI interfaces */
@@ -103,6 +102,18 @@ public:
 
 protected:
 
+	/** Called from the movement component when a dash starts */
+	void DashStarted();
+
+	/** Called from the movement component when a dash ends */
+	void DashEnded();
+
+	/** Called from the movement component when an air jump or wall jump is performed */
+	void AirJumped();
+
+	/** Restores the root motion mode that was replaced while the dash montage plays */
+	void RestoreDashRootMotion();
+
 	/** Called from a delegate when the dash montage ends */
 	void DashMontageEnded(UAnimMontage* Montage, bool bInterrupted);
 
@@ -112,7 +123,7 @@ protected:
 
 public:
 
-	/** Ends the dash state */
+	/** Ends the dash state. Ignored for timed dashes, where the animation is only cosmetic */
 	void EndDash();
 
 public:
@@ -127,32 +138,26 @@ public:
 
 public:	
 	
-	/** EndPlay cleanup */
-	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	/** Gameplay initialization */
+	virtual void BeginPlay() override;
 
 	/** Sets up input action bindings */
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
-	/** Handle landings to reset dash and advanced jump state */
+	/** Handle landings to reset the jump trails */
 	virtual void Landed(const FHitResult& Hit) override;
 
-	/** Handle movement mode changes to keep track of coyote time jumps */
-	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
-
 protected:
 
-	/** movement state flag bits, packed into a uint8 for memory efficiency */
-	uint8 bHasWallJumped : 1;
-	uint8 bHasDoubleJumped : 1;
-	uint8 bHasDashed : 1;
-	uint8 bIsDashing : 1;
-
-	/** timer for wall jump input reset */
-	FTimerHandle WallJumpTimer;
-
 	/** Dash montage ended delegate */
 	FOnMontageEnded OnDashMontageEnded;
 
+	/** Root motion mode to restore once the dash montage ends */
+	TEnumAsByte<ERootMotionMode::Type> DefaultRootMotionMode = ERootMotionMode::RootMotionFromMontagesOnly;
+
+	/** If true, root motion is ignored while the dash montage plays */
+	bool bIgnoringDashRootMotion = false;
+
 	/** Distance to trace ahead of the character to look for walls to jump from */
 	UPROPERTY(EditAnywhere, Category="Wall Jump", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm"))
 	float WallJumpTraceDistance = 50.0f;
@@ -173,16 +178,17 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Wall Jump", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
 	float DelayBetweenWallJumps = 0.1f;
 
+	/** Max amount of time that can pass since we started falling when we allow a regular jump */
+	UPROPERTY(EditAnywhere, Category="Coyote Time", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float MaxCoyoteTime = 0.16f;
+
 	/** AnimMontage to use for the Dash action */
 	UPROPERTY(EditAnywhere, Category="Dash")
 	UAnimMontage* DashMontage;
 
-	/** Last recorded time when this character started falling */
-	float LastFallTime = 0.0f;
-
-	/** Max amount of time that can pass since we started falling when we allow a regular jump */
-	UPROPERTY(EditAnywhere, Category="Coyote Time", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
-	float MaxCoyoteTime = 0.16f;
+	/** If true, dedicated servers skip pose ticks for this character. Only safe while the movement component times the dash */
+	UPROPERTY(EditAnywhere, Category="Dash")
+	bool bSkipServerAnimation = true;
 
 public:
 	/** Returns CameraBoom subobject **/
@@ -191,4 +197,7 @@ public:
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
+	/** Returns the platforming movement component **/
+	UPlatformingMovementComponent* GetPlatformingMovement() const;
+
 };
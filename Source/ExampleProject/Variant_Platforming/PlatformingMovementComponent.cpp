@@ -0,0 +1,536 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "PlatformingMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "ExampleProject.h"
+
+UPlatformingMovementComponent::UPlatformingMovementComponent()
+{
+	// initialize the flags
+	bWantsJumpPadLaunch = false;
+	bWantsToDash = false;
+	bWantsAirJump = false;
+
+	// send the ability state with corrections
+	SetMoveResponseDataContainer(PlatformingMoveResponseData);
+}
+
+void UPlatformingMovementComponent::RequestJumpPadLaunch(float LaunchSpeed)
+{
+	// ignore overlaps triggered while replaying moves after a correction. The saved moves already carry the launch
+	if (!CharacterOwner || CharacterOwner->bClientUpdating)
+	{
+		return;
+	}
+
+	// simulated proxies receive the launch through replicated movement
+	if (GetOwnerRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
+	JumpPadLaunchSpeed = LaunchSpeed;
+
+	// remote clients predict the launch and send it with their moves. The server only arms it so it can validate the request
+	if (GetOwnerRole() == ROLE_Authority && !CharacterOwner->IsLocallyControlled())
+	{
+		JumpPadArmTime = GetWorld()->GetTimeSeconds();
+		return;
+	}
+
+	bWantsJumpPadLaunch = true;
+}
+
+void UPlatformingMovementComponent::RequestDash()
+{
+	bWantsToDash = true;
+}
+
+void UPlatformingMovementComponent::RequestAirJump()
+{
+	bWantsAirJump = true;
+}
+
+void UPlatformingMovementComponent::EndDash()
+{
+	if (!Abilities.bIsDashing)
+	{
+		return;
+	}
+
+	FPlatformingRules::EndDash(Abilities, IsMovingOnGround());
+
+	if (!CharacterOwner || !CharacterOwner->bClientUpdating)
+	{
+		OnDashEnded.Broadcast();
+	}
+}
+
+FPlatformingSimSettings UPlatformingMovementComponent::GetAbilitySettings() const
+{
+	// the movement itself is owned by the component, so only the ability settings are relevant
+	FPlatformingSimSettings Settings;
+	Settings.MaxCoyoteTime = MaxCoyoteTime;
+	Settings.WallContactTime = WallContactTime;
+	Settings.MaxWallNormalZ = MaxWallNormalZ;
+	Settings.WallJumpHorizontalSpeed = WallJumpHorizontalSpeed;
+	Settings.WallJumpVerticalSpeed = WallJumpVerticalSpeed;
+	Settings.WallJumpLockoutTime = DelayBetweenWallJumps;
+	Settings.DashSpeed = DashSpeed;
+	Settings.DashDuration = DashDuration;
+
+	return Settings;
+}
+
+FPlatformingSimSettings UPlatformingMovementComponent::GetSimulationSettings() const
+{
+	FPlatformingSimSettings Settings = GetAbilitySettings();
+
+	// use the regular gravity, even while dashing
+	Settings.GravityZ = Super::GetGravityZ();
+	Settings.MaxWalkSpeed = MaxWalkSpeed;
+	Settings.MaxAcceleration = MaxAcceleration;
+	Settings.BrakingDeceleration = BrakingDecelerationWalking;
+	Settings.AirControl = AirControl;
+	Settings.JumpSpeed = JumpZVelocity;
+
+	if (CharacterOwner)
+	{
+		Settings.JumpMaxHoldTime = CharacterOwner->JumpMaxHoldTime;
+
+		// approximate the capsule with a box
+		float Radius, HalfHeight;
+		CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(Radius, HalfHeight);
+
+		Settings.HalfExtent = FVector3f(Radius, Radius, HalfHeight);
+	}
+
+	return Settings;
+}
+
+void UPlatformingMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// periodically log the correction rate on the owning client
+	if (bLogCorrections && GetOwnerRole() == ROLE_AutonomousProxy)
+	{
+		CorrectionLogTimer -= DeltaTime;
+
+		if (CorrectionLogTimer <= 0.0f)
+		{
+			UE_LOG(LogExampleProject, Log, TEXT("%s received %d movement corrections in the last minute."), *GetNameSafe(CharacterOwner), NumCorrections);
+
+			CorrectionLogTimer = 60.0f;
+			NumCorrections = 0;
+		}
+	}
+}
+
+FNetworkPredictionData_Client* UPlatformingMovementComponent::GetPredictionData_Client() const
+{
+	check(PawnOwner != nullptr);
+
+	// allocate our custom prediction data the first time it's requested
+	if (!ClientPredictionData)
+	{
+		ClientPredictionData = new FNetworkPredictionData_Client_Platforming(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void UPlatformingMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	ExpireJumpPadLaunch();
+
+	// consume the ability requests
+	if (bWantsJumpPadLaunch)
+	{
+		bWantsJumpPadLaunch = false;
+
+		PerformJumpPadLaunch();
+	}
+
+	if (bWantsToDash)
+	{
+		bWantsToDash = false;
+
+		PerformDash();
+	}
+
+	if (bWantsAirJump)
+	{
+		bWantsAirJump = false;
+
+		PerformAirJump(DeltaSeconds);
+	}
+
+	// advance the ability timers with the move, so replays stay in sync with the server. Timed dashes end here
+	if (FPlatformingRules::AdvanceTimers(GetAbilitySettings(), Abilities, DeltaSeconds, IsFalling()) && !CharacterOwner->bClientUpdating)
+	{
+		OnDashEnded.Broadcast();
+	}
+}
+
+float UPlatformingMovementComponent::GetGravityZ() const
+{
+	// disable gravity while dashing
+	return Abilities.bIsDashing ? 0.0f : Super::GetGravityZ();
+}
+
+void UPlatformingMovementComponent::CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration)
+{
+	// timed dashes ignore input, friction and braking until they end
+	if (Abilities.bIsDashing && DashSpeed > 0.0f)
+	{
+		return;
+	}
+
+	Super::CalcVelocity(DeltaTime, Friction, bFluid, BrakingDeceleration);
+}
+
+void UPlatformingMovementComponent::HandleImpact(const FHitResult& Hit, float TimeSlice, const FVector& MoveDelta)
+{
+	Super::HandleImpact(Hit, TimeSlice, MoveDelta);
+
+	// remember any wall we bump into while in the air, so wall jumps don't need their own trace
+	FPlatformingRules::RecordImpact(GetAbilitySettings(), Abilities, FVector3f(Hit.ImpactNormal), IsFalling());
+}
+
+void UPlatformingMovementComponent::ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse)
+{
+	// take the server's ability state before the correction replays our pending moves from it
+	if (MoveResponse.IsCorrection())
+	{
+		Abilities = static_cast<const FPlatformingMoveResponseDataContainer&>(MoveResponse).Abilities;
+	}
+
+	Super::ClientHandleMoveResponse(MoveResponse);
+}
+
+void UPlatformingMovementComponent::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode, FVector ServerGravityDirection)
+{
+	Super::OnClientCorrectionReceived(ClientData, TimeStamp, NewLocation, NewVelocity, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode, ServerGravityDirection);
+
+	++NumCorrections;
+}
+
+void UPlatformingMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsJumpPadLaunch = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+	bWantsToDash = (Flags & FSavedMove_Character::FLAG_Custom_1) != 0;
+	bWantsAirJump = (Flags & FSavedMove_Character::FLAG_Custom_2) != 0;
+}
+
+void UPlatformingMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	if (IsFalling())
+	{
+		FPlatformingRules::StartFalling(Abilities);
+
+	} else if (IsMovingOnGround()) {
+
+		FPlatformingRules::Land(Abilities);
+
+	}
+}
+
+void UPlatformingMovementComponent::ExpireJumpPadLaunch()
+{
+	// only the server arms launches without a request
+	if (JumpPadLaunchSpeed <= 0.0f || bWantsJumpPadLaunch || GetOwnerRole() != ROLE_Authority || CharacterOwner->IsLocallyControlled())
+	{
+		return;
+	}
+
+	// the client didn't launch from this overlap, so don't let a later move fire it
+	if (GetWorld()->GetTimeSeconds() - JumpPadArmTime > JumpPadLaunchTimeout)
+	{
+		JumpPadLaunchSpeed = 0.0f;
+	}
+}
+
+void UPlatformingMovementComponent::PerformJumpPadLaunch()
+{
+	// skip if we weren't armed by a jump pad overlap
+	if (JumpPadLaunchSpeed <= 0.0f)
+	{
+		return;
+	}
+
+	// override the vertical velocity and keep our horizontal momentum
+	Velocity.Z = JumpPadLaunchSpeed;
+	JumpPadLaunchSpeed = 0.0f;
+
+	SetMovementMode(MOVE_Falling);
+
+	// jump pads used to force a jump along with the launch, so the launch uses up the first jump.
+	// The jump count is saved with the move, so this is predicted and replayed like the launch
+	CharacterOwner->JumpCurrentCount = FMath::Max(CharacterOwner->JumpCurrentCount, 1);
+}
+
+void UPlatformingMovementComponent::PerformDash()
+{
+	// ignore the request if we've already dashed and have yet to reset
+	if (!FPlatformingRules::TryStartDash(GetAbilitySettings(), Abilities))
+	{
+		return;
+	}
+
+	// dash along our facing, or reset the velocity so root motion drives the dash without our momentum
+	Velocity = UpdatedComponent->GetForwardVector().GetSafeNormal2D() * DashSpeed;
+
+	// let the character play its dash effects, but only the first time we simulate this move
+	if (!CharacterOwner->bClientUpdating)
+	{
+		OnDashStarted.Broadcast();
+	}
+}
+
+void UPlatformingMovementComponent::PerformAirJump(float DeltaSeconds)
+{
+	// air jumps are locked out while dashing or right after a wall jump
+	if (!IsFalling() || Abilities.bIsDashing || HasWallJumped())
+	{
+		return;
+	}
+
+	const FPlatformingSimSettings Settings = GetAbilitySettings();
+
+	// without a direction, we can't wall jump
+	FVector Direction = FVector::ZeroVector;
+	const bool bHasDirection = GetWallJumpDirection(Direction);
+
+	// trace ahead for walls we haven't bumped into yet, and record them as a contact
+	FHitResult WallHit;
+
+	if (bHasDirection && bUseWallJumpFallbackTrace && !FPlatformingRules::HasWallContact(Settings, Abilities, FVector3f(Direction)) && TraceForWall(Direction, WallHit))
+	{
+		FPlatformingRules::RecordImpact(Settings, Abilities, FVector3f(WallHit.ImpactNormal), true);
+	}
+
+	FVector3f WallNormal;
+
+	switch (FPlatformingRules::ResolveAirJump(Settings, Abilities, FVector3f(Direction), CharacterOwner->JumpCurrentCount, WallNormal))
+	{
+	case EPlatformingAirJump::WallJump:
+
+		PerformWallJump(FVector(WallNormal));
+		break;
+
+	case EPlatformingAirJump::CoyoteJump:
+	case EPlatformingAirJump::DoubleJump:
+
+		// jump from within the move. The character has already checked its jump input for this move, and clears it before the next one
+		if (!DoJump(CharacterOwner->bClientUpdating, DeltaSeconds))
+		{
+			return;
+		}
+
+		// count the jump like the character's jump input would. Coyote time jumps are the first jump, double jumps the next one
+		++CharacterOwner->JumpCurrentCount;
+
+		// keep the jump going while the input is held, same as a regular press and hold jump
+		CharacterOwner->bPressedJump = true;
+		CharacterOwner->bWasJumping = true;
+		CharacterOwner->JumpKeyHoldTime = 0.0f;
+		CharacterOwner->JumpForceTimeRemaining = CharacterOwner->GetJumpMaxHoldTime();
+		break;
+
+	default:
+		return;
+	}
+
+	if (!CharacterOwner->bClientUpdating)
+	{
+		OnAirJump.Broadcast();
+	}
+}
+
+bool UPlatformingMovementComponent::GetWallJumpDirection(FVector& OutDirection) const
+{
+	if (bWallJumpRequiresInput)
+	{
+		// we need a movement input to pick a direction
+		if (Acceleration.IsNearlyZero())
+		{
+			return false;
+		}
+
+		OutDirection = Acceleration.GetSafeNormal2D();
+
+	} else {
+
+		OutDirection = UpdatedComponent->GetForwardVector().GetSafeNormal2D();
+
+	}
+
+	return true;
+}
+
+bool UPlatformingMovementComponent::TraceForWall(const FVector& Direction, FHitResult& OutHit) const
+{
+	const FVector TraceStart = UpdatedComponent->GetComponentLocation();
+	const FVector TraceEnd = TraceStart + (Direction * WallJumpTraceDistance);
+
+	// sweep a sphere, or trace a line if we have no radius
+	const FCollisionShape TraceShape = WallJumpTraceRadius > 0.0f ? FCollisionShape::MakeSphere(WallJumpTraceRadius) : FCollisionShape();
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(PlatformingWallJump), false, CharacterOwner);
+
+	return GetWorld()->SweepSingleByChannel(OutHit, TraceStart, TraceEnd, FQuat::Identity, ECC_Visibility, TraceShape, QueryParams);
+}
+
+void UPlatformingMovementComponent::PerformWallJump(const FVector& WallNormal)
+{
+	// rotate the character to face away from the wall, so we're correctly oriented for the next wall jump
+	FRotator WallOrientation = WallNormal.ToOrientationRotator();
+	WallOrientation.Pitch = 0.0f;
+	WallOrientation.Roll = 0.0f;
+
+	MoveUpdatedComponent(FVector::ZeroVector, WallOrientation.Quaternion(), false);
+
+	// launch the character away from the wall. The rules have already locked out movement and consumed the contact
+	Velocity = FVector(FPlatformingRules::GetWallJumpVelocity(GetAbilitySettings(), FVector3f(WallNormal)));
+
+	SetMovementMode(MOVE_Falling);
+}
+
+void FSavedMove_Platforming::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsJumpPadLaunch = false;
+	bSavedWantsToDash = false;
+	bSavedWantsAirJump = false;
+	SavedJumpPadLaunchSpeed = 0.0f;
+	SavedAbilities = FPlatformingAbilityState();
+}
+
+uint8 FSavedMove_Platforming::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+
+	if (bSavedWantsJumpPadLaunch)
+	{
+		Result |= FLAG_Custom_0;
+	}
+
+	if (bSavedWantsToDash)
+	{
+		Result |= FLAG_Custom_1;
+	}
+
+	if (bSavedWantsAirJump)
+	{
+		Result |= FLAG_Custom_2;
+	}
+
+	return Result;
+}
+
+bool FSavedMove_Platforming::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_Platforming* NewPlatformingMove = static_cast<const FSavedMove_Platforming*>(NewMove.Get());
+
+	// never merge away an ability request
+	if (bSavedWantsJumpPadLaunch != NewPlatformingMove->bSavedWantsJumpPadLaunch
+		|| bSavedWantsToDash != NewPlatformingMove->bSavedWantsToDash
+		|| bSavedWantsAirJump != NewPlatformingMove->bSavedWantsAirJump)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Platforming::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	if (const UPlatformingMovementComponent* Movement = Cast<UPlatformingMovementComponent>(C->GetCharacterMovement()))
+	{
+		bSavedWantsJumpPadLaunch = Movement->bWantsJumpPadLaunch;
+		bSavedWantsToDash = Movement->bWantsToDash;
+		bSavedWantsAirJump = Movement->bWantsAirJump;
+		SavedJumpPadLaunchSpeed = Movement->JumpPadLaunchSpeed;
+		SavedAbilities = Movement->Abilities;
+	}
+}
+
+void FSavedMove_Platforming::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+
+	if (UPlatformingMovementComponent* Movement = Cast<UPlatformingMovementComponent>(C->GetCharacterMovement()))
+	{
+		Movement->bWantsJumpPadLaunch = bSavedWantsJumpPadLaunch;
+		Movement->bWantsToDash = bSavedWantsToDash;
+		Movement->bWantsAirJump = bSavedWantsAirJump;
+		Movement->JumpPadLaunchSpeed = SavedJumpPadLaunchSpeed;
+	}
+}
+
+void FSavedMove_Platforming::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
+{
+	Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
+
+	if (UPlatformingMovementComponent* Movement = Cast<UPlatformingMovementComponent>(InCharacter->GetCharacterMovement()))
+	{
+		Movement->Abilities = static_cast<const FSavedMove_Platforming*>(OldMove)->SavedAbilities;
+	}
+}
+
+void FPlatformingMoveResponseDataContainer::ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment)
+{
+	Super::ServerFillResponseData(CharacterMovement, PendingAdjustment);
+
+	Abilities = static_cast<const UPlatformingMovementComponent&>(CharacterMovement).Abilities;
+}
+
+bool FPlatformingMoveResponseDataContainer::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap)
+{
+	if (!Super::Serialize(CharacterMovement, Ar, PackageMap))
+	{
+		return false;
+	}
+
+	// good moves don't change the client's state, so only corrections carry the abilities
+	if (IsCorrection())
+	{
+		Ar << Abilities.WallContactNormal;
+		Ar << Abilities.WallContactAge;
+		Ar << Abilities.FallingTime;
+		Ar << Abilities.WallJumpLockoutTime;
+		Ar << Abilities.DashTimeLeft;
+
+		uint8 Flags = (Abilities.bHasDoubleJumped ? 1 : 0) | (Abilities.bHasDashed ? 2 : 0) | (Abilities.bIsDashing ? 4 : 0);
+		Ar.SerializeBits(&Flags, 3);
+
+		Abilities.bHasDoubleJumped = (Flags & 1) != 0;
+		Abilities.bHasDashed = (Flags & 2) != 0;
+		Abilities.bIsDashing = (Flags & 4) != 0;
+	}
+
+	return !Ar.IsError();
+}
+
+FNetworkPredictionData_Client_Platforming::FNetworkPredictionData_Client_Platforming(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Platforming::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Platforming());
+}
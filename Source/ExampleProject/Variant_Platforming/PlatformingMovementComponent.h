@@ -0,0 +1,288 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "PlatformingSimulation.h"
+#include "PlatformingMovementComponent.generated.h"
+
+/** Dash started delegate. Lets the character play its dash effects */
+DECLARE_MULTICAST_DELEGATE(FOnPlatformingDashStarted);
+
+/** Dash ended delegate. Lets the character stop its dash effects */
+DECLARE_MULTICAST_DELEGATE(FOnPlatformingDashEnded);
+
+/** Air jump delegate. Lets the character play its jump effects */
+DECLARE_MULTICAST_DELEGATE(FOnPlatformingAirJump);
+
+/**
+ *  Move response that also carries the server's ability state with corrections,
+ *  so the owning client replays its pending moves from the authoritative state
+ */
+struct FPlatformingMoveResponseDataContainer : public FCharacterMoveResponseDataContainer
+{
+	typedef FCharacterMoveResponseDataContainer Super;
+
+	/** Server ability state at the corrected move */
+	FPlatformingAbilityState Abilities;
+
+	/** Copies the ability state from the server's movement component */
+	virtual void ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment) override;
+
+	/** Serializes the ability state along with corrections */
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap) override;
+};
+
+/**
+ *  Character movement component with network predicted platforming abilities.
+ *  Abilities are requested through movement state flags, which are packed into the saved moves,
+ *  so they are predicted by the owning client, replayed after corrections and validated by the server.
+ *  The ability rules themselves are shared with the standalone platforming simulation.
+ *  Supported abilities:
+ *  - Jump pad launches
+ *  - Dash
+ *  - Wall jump
+ *  - Double jump
+ *  - Coyote time jumps
+ */
+UCLASS()
+class UPlatformingMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_Platforming;
+	friend struct FPlatformingMoveResponseDataContainer;
+
+public:
+
+	/** Dash speed along the character's facing. Zero leaves the dash movement to root motion */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Dash", meta = (ClampMin = 0, ClampMax = 10000, Units = "cm/s"))
+	float DashSpeed = 0.0f;
+
+	/** Dash duration. Zero means the dash only ends when EndDash is called, usually from the dash animation */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Dash", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float DashDuration = 0.0f;
+
+	/** How long a wall the character bumped into while falling stays valid for wall jumps */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Wall Jump", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float WallContactTime = 0.2f;
+
+	/** Max vertical component of a hit normal for the surface to count as a wall */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Wall Jump", meta = (ClampMin = 0, ClampMax = 1))
+	float MaxWallNormalZ = 0.3f;
+
+	/** If true, trace for a wall when the character hasn't recently bumped into one */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Wall Jump")
+	bool bUseWallJumpFallbackTrace = false;
+
+	/** Distance to trace ahead of the character to look for walls to jump from */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Wall Jump", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm", EditCondition = "bUseWallJumpFallbackTrace"))
+	float WallJumpTraceDistance = 50.0f;
+
+	/** Radius of the wall jump sphere trace. Zero uses a line trace */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Wall Jump", meta = (ClampMin = 0, ClampMax = 100, Units = "cm", EditCondition = "bUseWallJumpFallbackTrace"))
+	float WallJumpTraceRadius = 25.0f;
+
+	/** If true, walls are only jumped from when the movement input points into them. Otherwise the character must face them */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Wall Jump")
+	bool bWallJumpRequiresInput = false;
+
+	/** Horizontal speed away from the wall when wall jumping */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Wall Jump", meta = (ClampMin = 0, ClampMax = 10000, Units = "cm/s"))
+	float WallJumpHorizontalSpeed = 800.0f;
+
+	/** Vertical speed when wall jumping */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Wall Jump", meta = (ClampMin = 0, ClampMax = 10000, Units = "cm/s"))
+	float WallJumpVerticalSpeed = 900.0f;
+
+	/** Time to ignore movement and jump inputs after a wall jump */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Wall Jump", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float DelayBetweenWallJumps = 0.1f;
+
+	/** How long the server keeps a jump pad overlap armed, waiting for the owning client's launch request */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Jump Pad", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float JumpPadLaunchTimeout = 0.5f;
+
+	/** Max amount of time that can pass since we walked off a ledge when we allow a regular jump */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Coyote Time", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float MaxCoyoteTime = 0.16f;
+
+	/** If true, the owning client logs how many server corrections it received every minute */
+	UPROPERTY(EditAnywhere, Category="Character Movement: Platforming|Debug")
+	bool bLogCorrections = false;
+
+	/** Called when a dash starts. Not called while replaying moves */
+	FOnPlatformingDashStarted OnDashStarted;
+
+	/** Called when a dash ends. Not called while replaying moves */
+	FOnPlatformingDashEnded OnDashEnded;
+
+	/** Called when an air jump or wall jump is performed. Not called while replaying moves */
+	FOnPlatformingAirJump OnAirJump;
+
+protected:
+
+	/** movement request flag bits, sent to the server through the saved moves */
+	uint8 bWantsJumpPadLaunch : 1;
+	uint8 bWantsToDash : 1;
+	uint8 bWantsAirJump : 1;
+
+	/** Vertical speed of the pending jump pad launch. On the server, a remote client's launch request is only honored if this was set by an overlap */
+	float JumpPadLaunchSpeed = 0.0f;
+
+	/** World time the server armed the jump pad launch for a remote client */
+	float JumpPadArmTime = 0.0f;
+
+	/** Ability state. Corrected from the server's state, then advanced by each replayed move. Timers advance with each move instead of the world time, so replays stay in sync */
+	FPlatformingAbilityState Abilities;
+
+	/** Move response that sends the ability state with corrections */
+	FPlatformingMoveResponseDataContainer PlatformingMoveResponseData;
+
+	/** Corrections received since the last log */
+	int32 NumCorrections = 0;
+
+	/** Time left until the next corrections log */
+	float CorrectionLogTimer = 60.0f;
+
+public:
+
+	/** Constructor */
+	UPlatformingMovementComponent();
+
+	/** Called by jump pads when the character overlaps them. Queues a launch so it happens as part of a predicted move */
+	void RequestJumpPadLaunch(float LaunchSpeed);
+
+	/** Queues a dash for the next move */
+	void RequestDash();
+
+	/** Queues an air jump for the next move. The move decides between a wall jump, a coyote time jump or a double jump */
+	void RequestAirJump();
+
+	/** Ends the dash state */
+	void EndDash();
+
+	/** Returns true if the character has double jumped since it last landed */
+	bool HasDoubleJumped() const { return Abilities.bHasDoubleJumped; }
+
+	/** Returns true if the character has just wall jumped and is locked out of moving and jumping */
+	bool HasWallJumped() const { return FPlatformingRules::IsLockedOut(Abilities); }
+
+	/** Returns true if the character is dashing */
+	bool IsDashing() const { return Abilities.bIsDashing; }
+
+	/** Returns the ability rule settings from the component properties */
+	FPlatformingSimSettings GetAbilitySettings() const;
+
+	/** Returns settings for the standalone simulation that match this character's movement tuning and collision size */
+	FPlatformingSimSettings GetSimulationSettings() const;
+
+public:
+
+	/** Updates the corrections log */
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Returns the client prediction data, allocating our custom saved moves */
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	/** Applies any requested abilities before the move runs */
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+	/** Disables gravity while dashing */
+	virtual float GetGravityZ() const override;
+
+	/** Keeps the dash velocity constant during timed dashes */
+	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration) override;
+
+	/** Caches wall contacts from the movement sweeps for wall jumps */
+	virtual void HandleImpact(const FHitResult& Hit, float TimeSlice = 0.0f, const FVector& MoveDelta = FVector::ZeroVector) override;
+
+	/** Applies the server's ability state from corrections before the pending moves are replayed */
+	virtual void ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse) override;
+
+	/** Counts server corrections */
+	virtual void OnClientCorrectionReceived(class FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode, FVector ServerGravityDirection) override;
+
+protected:
+
+	/** Unpacks the movement state flags sent by the client */
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+
+	/** Resets the air abilities when landing and starts the coyote time when falling */
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+
+	/** Drops a jump pad launch the server armed, but the remote client never requested in time */
+	void ExpireJumpPadLaunch();
+
+	/** Launches the character from a jump pad. The launch counts as the character's first jump */
+	void PerformJumpPadLaunch();
+
+	/** Starts a dash if it's available */
+	void PerformDash();
+
+	/** Performs a wall jump, coyote time jump or double jump, whichever is available */
+	void PerformAirJump(float DeltaSeconds);
+
+	/** Returns the horizontal direction the character needs to point at a wall to jump from it */
+	bool GetWallJumpDirection(FVector& OutDirection) const;
+
+	/** Traces ahead for a wall we haven't bumped into yet. Returns true if one was found */
+	bool TraceForWall(const FVector& Direction, FHitResult& OutHit) const;
+
+	/** Launches the character away from a wall */
+	void PerformWallJump(const FVector& WallNormal);
+};
+
+/**
+ *  Saved move that also stores the platforming ability requests and state
+ */
+class FSavedMove_Platforming : public FSavedMove_Character
+{
+public:
+
+	typedef FSavedMove_Character Super;
+
+	/** Saved ability requests */
+	uint8 bSavedWantsJumpPadLaunch : 1;
+	uint8 bSavedWantsToDash : 1;
+	uint8 bSavedWantsAirJump : 1;
+
+	/** Saved ability state at the start of the move */
+	float SavedJumpPadLaunchSpeed = 0.0f;
+	FPlatformingAbilityState SavedAbilities;
+
+	/** Resets the saved state */
+	virtual void Clear() override;
+
+	/** Packs the ability requests into the custom flag bits */
+	virtual uint8 GetCompressedFlags() const override;
+
+	/** Moves with different ability requests can't be combined */
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+
+	/** Captures the ability requests and state from the movement component */
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+
+	/** Restores the ability requests on the movement component before replaying the move. The ability state comes from the server correction instead */
+	virtual void PrepMoveFor(ACharacter* C) override;
+
+	/** Rewinds the ability state to the start of the old move, so the combined move doesn't advance it twice */
+	virtual void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation) override;
+};
+
+/**
+ *  Client prediction data that allocates platforming saved moves
+ */
+class FNetworkPredictionData_Client_Platforming : public FNetworkPredictionData_Client_Character
+{
+public:
+
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	/** Constructor */
+	FNetworkPredictionData_Client_Platforming(const UCharacterMovementComponent& ClientMovement);
+
+	/** Allocates a platforming saved move */
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
@@ -0,0 +1,396 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "PlatformingSimulation.h"
+#include "Misc/Crc.h"
+
+bool FPlatformingRules::AdvanceTimers(const FPlatformingSimSettings& Settings, FPlatformingAbilityState& State, float DeltaTime, bool bFalling)
+{
+	State.WallJumpLockoutTime = FMath::Max(State.WallJumpLockoutTime - DeltaTime, 0.0f);
+	State.WallContactAge += DeltaTime;
+
+	if (bFalling)
+	{
+		State.FallingTime += DeltaTime;
+	}
+
+	// end timed dashes
+	if (State.bIsDashing && Settings.DashDuration > 0.0f)
+	{
+		State.DashTimeLeft -= DeltaTime;
+
+		if (State.DashTimeLeft <= 0.0f)
+		{
+			EndDash(State, !bFalling);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FPlatformingRules::StartFalling(FPlatformingAbilityState& State)
+{
+	// start counting coyote time
+	State.FallingTime = 0.0f;
+}
+
+void FPlatformingRules::Land(FPlatformingAbilityState& State)
+{
+	// reset the air abilities
+	State.bHasDoubleJumped = false;
+
+	if (!State.bIsDashing)
+	{
+		State.bHasDashed = false;
+	}
+}
+
+void FPlatformingRules::RecordImpact(const FPlatformingSimSettings& Settings, FPlatformingAbilityState& State, const FVector3f& ImpactNormal, bool bFalling)
+{
+	// remember any wall we bump into while in the air
+	if (bFalling && FMath::Abs(ImpactNormal.Z) <= Settings.MaxWallNormalZ)
+	{
+		State.WallContactNormal = ImpactNormal;
+		State.WallContactAge = 0.0f;
+	}
+}
+
+bool FPlatformingRules::HasWallContact(const FPlatformingSimSettings& Settings, const FPlatformingAbilityState& State, const FVector3f& Direction)
+{
+	return State.WallContactAge <= Settings.WallContactTime && (Direction | State.WallContactNormal) < 0.0f;
+}
+
+bool FPlatformingRules::TryStartDash(const FPlatformingSimSettings& Settings, FPlatformingAbilityState& State)
+{
+	// only dash once until we reset
+	if (State.bHasDashed)
+	{
+		return false;
+	}
+
+	State.bIsDashing = true;
+	State.bHasDashed = true;
+	State.DashTimeLeft = Settings.DashDuration;
+
+	return true;
+}
+
+void FPlatformingRules::EndDash(FPlatformingAbilityState& State, bool bGrounded)
+{
+	State.bIsDashing = false;
+	State.DashTimeLeft = 0.0f;
+
+	// we won't receive a landing if we're already grounded
+	if (bGrounded)
+	{
+		State.bHasDashed = false;
+	}
+}
+
+EPlatformingAirJump FPlatformingRules::ResolveAirJump(const FPlatformingSimSettings& Settings, FPlatformingAbilityState& State, const FVector3f& WallJumpDirection, int32 JumpCount, FVector3f& OutWallNormal)
+{
+	// air jumps are locked out while dashing or right after a wall jump
+	if (State.bIsDashing || IsLockedOut(State))
+	{
+		return EPlatformingAirJump::None;
+	}
+
+	// try for a wall jump first
+	if (HasWallContact(Settings, State, WallJumpDirection))
+	{
+		OutWallNormal = State.WallContactNormal;
+
+		// lock out movement and air jumps for a bit to preserve momentum, and don't jump from the same contact twice
+		State.WallJumpLockoutTime = Settings.WallJumpLockoutTime;
+		State.WallContactAge = UE_BIG_NUMBER;
+
+		return EPlatformingAirJump::WallJump;
+	}
+
+	// we can still do a regular jump for a short time after walking off a ledge
+	if (State.FallingTime < Settings.MaxCoyoteTime && JumpCount == 0)
+	{
+		return EPlatformingAirJump::CoyoteJump;
+	}
+
+	// otherwise, only double jump once while we're in the air
+	if (!State.bHasDoubleJumped)
+	{
+		State.bHasDoubleJumped = true;
+
+		return EPlatformingAirJump::DoubleJump;
+	}
+
+	return EPlatformingAirJump::None;
+}
+
+FVector3f FPlatformingRules::GetWallJumpVelocity(const FPlatformingSimSettings& Settings, const FVector3f& WallNormal)
+{
+	return (WallNormal * Settings.WallJumpHorizontalSpeed) + (FVector3f::UpVector * Settings.WallJumpVerticalSpeed);
+}
+
+FPlatformingSimulation::FPlatformingSimulation(const FPlatformingSimSettings& InSettings, float InFixedDeltaTime)
+	: Settings(InSettings)
+	, FixedDeltaTime(InFixedDeltaTime)
+{
+}
+
+void FPlatformingSimulation::AddSolid(const FBox3f& Box)
+{
+	Solids.Add(Box);
+}
+
+int32 FPlatformingSimulation::AddCharacter(const FVector3f& Location)
+{
+	FPlatformingSimCharacter& Character = Characters.AddDefaulted_GetRef();
+	Character.Location = Location;
+
+	// don't let a held jump input lift characters that haven't jumped
+	Character.JumpHoldTime = Settings.JumpMaxHoldTime;
+
+	return Characters.Num() - 1;
+}
+
+void FPlatformingSimulation::Step(TConstArrayView<FPlatformingSimInput> Inputs)
+{
+	check(Inputs.Num() == Characters.Num());
+
+	for (int32 i = 0; i < Characters.Num(); ++i)
+	{
+		StepCharacter(Characters[i], Inputs[i]);
+	}
+
+	++Frame;
+}
+
+uint32 FPlatformingSimulation::ComputeChecksum() const
+{
+	uint32 Checksum = 0;
+
+	for (const FPlatformingSimCharacter& Character : Characters)
+	{
+		const FPlatformingAbilityState& Abilities = Character.Abilities;
+
+		Checksum = FCrc::MemCrc32(&Character.Location, sizeof(FVector3f), Checksum);
+		Checksum = FCrc::MemCrc32(&Character.Velocity, sizeof(FVector3f), Checksum);
+		Checksum = FCrc::MemCrc32(&Character.Facing, sizeof(FVector3f), Checksum);
+		Checksum = FCrc::MemCrc32(&Character.JumpHoldTime, sizeof(float), Checksum);
+		Checksum = FCrc::MemCrc32(&Character.JumpCount, sizeof(int32), Checksum);
+
+		// the ability state decides which jumps and dashes are available next, so it's part of the state to compare
+		Checksum = FCrc::MemCrc32(&Abilities.WallContactNormal, sizeof(FVector3f), Checksum);
+		Checksum = FCrc::MemCrc32(&Abilities.WallContactAge, sizeof(float), Checksum);
+		Checksum = FCrc::MemCrc32(&Abilities.FallingTime, sizeof(float), Checksum);
+		Checksum = FCrc::MemCrc32(&Abilities.WallJumpLockoutTime, sizeof(float), Checksum);
+		Checksum = FCrc::MemCrc32(&Abilities.DashTimeLeft, sizeof(float), Checksum);
+
+		// bit fields can't be hashed in place
+		const uint8 Flags = (Abilities.bHasDoubleJumped ? 1 : 0) | (Abilities.bHasDashed ? 2 : 0) | (Abilities.bIsDashing ? 4 : 0)
+			| (Character.bGrounded ? 8 : 0) | (Character.bJumpHeld ? 16 : 0);
+
+		Checksum = FCrc::MemCrc32(&Flags, sizeof(uint8), Checksum);
+	}
+
+	return Checksum;
+}
+
+void FPlatformingSimulation::StepCharacter(FPlatformingSimCharacter& Character, const FPlatformingSimInput& Input)
+{
+	FPlatformingAbilityState& Abilities = Character.Abilities;
+
+	// process the input
+	const bool bJumpPressed = Input.bJump && !Character.bJumpHeld;
+	Character.bJumpHeld = Input.bJump;
+
+	const FVector3f MoveInput(FMath::Clamp(Input.Move.X, -1.0f, 1.0f), FMath::Clamp(Input.Move.Y, -1.0f, 1.0f), 0.0f);
+
+	if (!MoveInput.IsNearlyZero())
+	{
+		Character.Facing = MoveInput.GetSafeNormal();
+	}
+
+	// apply the abilities first, same as the movement component
+	if (Input.bDash && FPlatformingRules::TryStartDash(Settings, Abilities))
+	{
+		Character.Velocity = Character.Facing * Settings.DashSpeed;
+	}
+
+	bool bStartJump = false;
+
+	if (bJumpPressed && !Abilities.bIsDashing)
+	{
+		if (Character.bGrounded)
+		{
+			bStartJump = true;
+
+		} else {
+
+			FVector3f WallNormal;
+
+			switch (FPlatformingRules::ResolveAirJump(Settings, Abilities, Character.Facing, Character.JumpCount, WallNormal))
+			{
+			case EPlatformingAirJump::WallJump:
+
+				// launch away from the wall and face away from it
+				Character.Velocity = FPlatformingRules::GetWallJumpVelocity(Settings, WallNormal);
+				Character.Facing = FVector3f(WallNormal.X, WallNormal.Y, 0.0f).GetSafeNormal();
+				Character.JumpHoldTime = Settings.JumpMaxHoldTime;
+				break;
+
+			case EPlatformingAirJump::CoyoteJump:
+			case EPlatformingAirJump::DoubleJump:
+
+				bStartJump = true;
+				break;
+
+			default:
+				break;
+			}
+
+		}
+	}
+
+	if (bStartJump)
+	{
+		Character.Velocity.Z = Settings.JumpSpeed;
+		Character.JumpHoldTime = 0.0f;
+		++Character.JumpCount;
+
+	} else if (Character.bJumpHeld && Character.JumpHoldTime < Settings.JumpMaxHoldTime) {
+
+		// keep the jump speed while the jump is held
+		Character.Velocity.Z = FMath::Max(Character.Velocity.Z, Settings.JumpSpeed);
+		Character.JumpHoldTime += FixedDeltaTime;
+
+	} else if (!Character.bJumpHeld) {
+
+		Character.JumpHoldTime = Settings.JumpMaxHoldTime;
+
+	}
+
+	// apply the horizontal input, unless an ability has taken over the movement
+	if (!Abilities.bIsDashing && !FPlatformingRules::IsLockedOut(Abilities))
+	{
+		FVector2f Horizontal(Character.Velocity.X, Character.Velocity.Y);
+
+		if (!MoveInput.IsNearlyZero())
+		{
+			const float Control = Character.bGrounded ? 1.0f : Settings.AirControl;
+
+			Horizontal += FVector2f(MoveInput.X, MoveInput.Y) * (Settings.MaxAcceleration * Control * FixedDeltaTime);
+
+			// clamp to the max walk speed
+			const float SpeedSquared = Horizontal.SizeSquared();
+
+			if (SpeedSquared > FMath::Square(Settings.MaxWalkSpeed))
+			{
+				Horizontal *= Settings.MaxWalkSpeed / FMath::Sqrt(SpeedSquared);
+			}
+
+		} else if (Character.bGrounded) {
+
+			// brake towards a stop
+			const float Speed = Horizontal.Size();
+			const float NewSpeed = FMath::Max(Speed - Settings.BrakingDeceleration * FixedDeltaTime, 0.0f);
+
+			Horizontal = Speed > 0.0f ? Horizontal * (NewSpeed / Speed) : FVector2f::ZeroVector;
+
+		}
+
+		Character.Velocity.X = Horizontal.X;
+		Character.Velocity.Y = Horizontal.Y;
+	}
+
+	// apply gravity, which dashes ignore
+	if (!Abilities.bIsDashing)
+	{
+		Character.Velocity.Z += Settings.GravityZ * FixedDeltaTime;
+	}
+
+	FPlatformingRules::AdvanceTimers(Settings, Abilities, FixedDeltaTime, !Character.bGrounded);
+
+	// move one axis at a time, so collisions resolve the same way every run
+	const bool bWasGrounded = Character.bGrounded;
+	Character.bGrounded = false;
+
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		const FVector3f Normal = MoveAxis(Character, Axis, Character.Velocity[Axis] * FixedDeltaTime);
+
+		if (!Normal.IsZero())
+		{
+			Character.Velocity[Axis] = 0.0f;
+
+			if (Axis == 2)
+			{
+				Character.bGrounded |= Normal.Z > 0.0f;
+
+			} else {
+
+				FPlatformingRules::RecordImpact(Settings, Abilities, Normal, !bWasGrounded);
+
+			}
+		}
+	}
+
+	// handle ground transitions
+	if (bWasGrounded && !Character.bGrounded)
+	{
+		FPlatformingRules::StartFalling(Abilities);
+
+	} else if (!bWasGrounded && Character.bGrounded) {
+
+		FPlatformingRules::Land(Abilities);
+
+		Character.JumpCount = 0;
+		Character.JumpHoldTime = Settings.JumpMaxHoldTime;
+
+	}
+}
+
+FVector3f FPlatformingSimulation::MoveAxis(FPlatformingSimCharacter& Character, int32 Axis, float Delta) const
+{
+	FVector3f Normal = FVector3f::ZeroVector;
+
+	if (Delta == 0.0f)
+	{
+		return Normal;
+	}
+
+	FVector3f NewLocation = Character.Location;
+	NewLocation[Axis] += Delta;
+
+	for (const FBox3f& Solid : Solids)
+	{
+		const FVector3f Min = NewLocation - Settings.HalfExtent;
+		const FVector3f Max = NewLocation + Settings.HalfExtent;
+
+		// only a strict overlap blocks, so sliding along a touching surface is free
+		const bool bOverlaps = Min.X < Solid.Max.X && Max.X > Solid.Min.X
+			&& Min.Y < Solid.Max.Y && Max.Y > Solid.Min.Y
+			&& Min.Z < Solid.Max.Z && Max.Z > Solid.Min.Z;
+
+		if (!bOverlaps)
+		{
+			continue;
+		}
+
+		// push back out against the movement direction
+		if (Delta > 0.0f)
+		{
+			NewLocation[Axis] = Solid.Min[Axis] - Settings.HalfExtent[Axis];
+			Normal[Axis] = -1.0f;
+
+		} else {
+
+			NewLocation[Axis] = Solid.Max[Axis] + Settings.HalfExtent[Axis];
+			Normal[Axis] = 1.0f;
+
+		}
+	}
+
+	Character.Location = NewLocation;
+
+	return Normal;
+}
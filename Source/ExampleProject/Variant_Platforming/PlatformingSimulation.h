@@ -0,0 +1,248 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ *  Platforming ability rules and a standalone platforming simulation.
+ *  Plain structs and functions with no UObject dependencies.
+ *  The ability rules are shared: the character movement component drives the characters' dash, wall jump,
+ *  double jump and coyote time through them, and the standalone simulation runs them for its own characters.
+ *  The standalone simulation is a separate, simplified box collision model for headless runs, bots and tests.
+ *  It doesn't move the characters, so its results only approximate theirs.
+ */
+
+/** Tunable platforming settings */
+struct FPlatformingSimSettings
+{
+	/** Gravity acceleration */
+	float GravityZ = -2450.0f;
+
+	/** Max horizontal speed from movement input */
+	float MaxWalkSpeed = 750.0f;
+
+	/** Horizontal acceleration from movement input */
+	float MaxAcceleration = 1500.0f;
+
+	/** Horizontal deceleration on the ground without movement input */
+	float BrakingDeceleration = 2500.0f;
+
+	/** Fraction of the acceleration available while in the air */
+	float AirControl = 1.0f;
+
+	/** Vertical speed when jumping */
+	float JumpSpeed = 350.0f;
+
+	/** Max time the jump speed is held while the jump input is held */
+	float JumpMaxHoldTime = 0.4f;
+
+	/** Half extents of the collision box used by the standalone simulation */
+	FVector3f HalfExtent = FVector3f(35.0f, 35.0f, 90.0f);
+
+	/** Max time since walking off a ledge when a regular jump is still allowed */
+	float MaxCoyoteTime = 0.16f;
+
+	/** How long a wall contact stays valid for wall jumps */
+	float WallContactTime = 0.2f;
+
+	/** Max vertical component of a hit normal for the surface to count as a wall */
+	float MaxWallNormalZ = 0.3f;
+
+	/** Horizontal speed away from the wall when wall jumping */
+	float WallJumpHorizontalSpeed = 800.0f;
+
+	/** Vertical speed when wall jumping */
+	float WallJumpVerticalSpeed = 900.0f;
+
+	/** Time movement and air jumps are locked out after a wall jump */
+	float WallJumpLockoutTime = 0.1f;
+
+	/** Dash speed. Zero leaves the dash movement to the caller */
+	float DashSpeed = 0.0f;
+
+	/** Dash duration. Zero means the dash only ends when the caller ends it */
+	float DashDuration = 0.0f;
+};
+
+/** Air jump resolved by the platforming rules */
+enum class EPlatformingAirJump : uint8
+{
+	None,
+	WallJump,
+	CoyoteJump,
+	DoubleJump
+};
+
+/** Platforming ability state for a single character */
+struct FPlatformingAbilityState
+{
+	/** Normal of the last wall the character bumped into while falling */
+	FVector3f WallContactNormal = FVector3f::ZeroVector;
+
+	/** Time since the last wall contact */
+	float WallContactAge = UE_BIG_NUMBER;
+
+	/** Time spent falling since the character last left the ground */
+	float FallingTime = 0.0f;
+
+	/** Time left before the character can move or air jump after a wall jump */
+	float WallJumpLockoutTime = 0.0f;
+
+	/** Time left in a timed dash */
+	float DashTimeLeft = 0.0f;
+
+	/** ability flag bits */
+	uint8 bHasDoubleJumped : 1;
+	uint8 bHasDashed : 1;
+	uint8 bIsDashing : 1;
+
+	/** Constructor */
+	FPlatformingAbilityState()
+		: bHasDoubleJumped(false)
+		, bHasDashed(false)
+		, bIsDashing(false)
+	{
+	}
+};
+
+/**
+ *  Platforming ability rules.
+ *  Callers own the movement itself, and report ground, falling and impact events back to the rules.
+ */
+struct FPlatformingRules
+{
+	/** Advances the ability timers by one step. Returns true if a timed dash ended during this step */
+	static bool AdvanceTimers(const FPlatformingSimSettings& Settings, FPlatformingAbilityState& State, float DeltaTime, bool bFalling);
+
+	/** Called when the character leaves the ground */
+	static void StartFalling(FPlatformingAbilityState& State);
+
+	/** Called when the character reaches the ground */
+	static void Land(FPlatformingAbilityState& State);
+
+	/** Records a blocking hit while moving. Only walls hit while falling are kept */
+	static void RecordImpact(const FPlatformingSimSettings& Settings, FPlatformingAbilityState& State, const FVector3f& ImpactNormal, bool bFalling);
+
+	/** Returns true if the character has a recent wall contact that the direction points into */
+	static bool HasWallContact(const FPlatformingSimSettings& Settings, const FPlatformingAbilityState& State, const FVector3f& Direction);
+
+	/** Starts a dash if it's available. Returns true if the dash started */
+	static bool TryStartDash(const FPlatformingSimSettings& Settings, FPlatformingAbilityState& State);
+
+	/** Ends the dash. Grounded characters can dash again right away */
+	static void EndDash(FPlatformingAbilityState& State, bool bGrounded);
+
+	/** Picks the air jump to perform and updates the state for it. Wall jumps use the recorded wall contact along the direction */
+	static EPlatformingAirJump ResolveAirJump(const FPlatformingSimSettings& Settings, FPlatformingAbilityState& State, const FVector3f& WallJumpDirection, int32 JumpCount, FVector3f& OutWallNormal);
+
+	/** Returns the velocity to launch a character away from a wall with */
+	static FVector3f GetWallJumpVelocity(const FPlatformingSimSettings& Settings, const FVector3f& WallNormal);
+
+	/** Returns true if movement and air jumps are locked out after a wall jump */
+	static bool IsLockedOut(const FPlatformingAbilityState& State) { return State.WallJumpLockoutTime > 0.0f; }
+};
+
+/** Input for a single character and simulation step */
+struct FPlatformingSimInput
+{
+	/** Horizontal movement input, in the -1 to 1 range */
+	FVector2f Move = FVector2f::ZeroVector;
+
+	/** input flag bits */
+	uint8 bJump : 1;
+	uint8 bDash : 1;
+
+	/** Constructor */
+	FPlatformingSimInput()
+		: bJump(false)
+		, bDash(false)
+	{
+	}
+};
+
+/** Full state of a character in the standalone simulation */
+struct FPlatformingSimCharacter
+{
+	FVector3f Location = FVector3f::ZeroVector;
+	FVector3f Velocity = FVector3f::ZeroVector;
+
+	/** Direction of the last movement input, used for dashes and wall jumps */
+	FVector3f Facing = FVector3f(1.0f, 0.0f, 0.0f);
+
+	/** Time the current jump has been held for */
+	float JumpHoldTime = 0.0f;
+
+	/** Number of jumps since the character last landed */
+	int32 JumpCount = 0;
+
+	/** Ability state */
+	FPlatformingAbilityState Abilities;
+
+	/** state flag bits */
+	uint8 bGrounded : 1;
+	uint8 bJumpHeld : 1;
+
+	/** Constructor */
+	FPlatformingSimCharacter()
+		: bGrounded(false)
+		, bJumpHeld(false)
+	{
+	}
+};
+
+/**
+ *  Standalone fixed-step platforming simulation.
+ *  Characters move through a static world of boxes with axis-separated collision,
+ *  which keeps every step cheap and reproducible. Its state can be saved and restored for rollback and replays
+ *  of the simulation itself. Use UPlatformingMovementComponent::GetSimulationSettings to match a character's tuning.
+ */
+class FPlatformingSimulation
+{
+public:
+
+	/** Constructor */
+	FPlatformingSimulation(const FPlatformingSimSettings& InSettings, float InFixedDeltaTime);
+
+	/** Adds a static solid box to the world */
+	void AddSolid(const FBox3f& Box);
+
+	/** Adds a character at the provided location. Returns its index */
+	int32 AddCharacter(const FVector3f& Location);
+
+	/** Advances every character by one fixed step. Expects one input per character */
+	void Step(TConstArrayView<FPlatformingSimInput> Inputs);
+
+	/** Returns a checksum of every character's movement and ability state, to compare runs */
+	uint32 ComputeChecksum() const;
+
+	/** Returns all characters. Copy them to save a frame for rollback */
+	TArray<FPlatformingSimCharacter>& GetCharacters() { return Characters; }
+	const TArray<FPlatformingSimCharacter>& GetCharacters() const { return Characters; }
+
+	/** Returns the number of steps simulated so far */
+	uint32 GetFrame() const { return Frame; }
+
+protected:
+
+	/** Advances a single character */
+	void StepCharacter(FPlatformingSimCharacter& Character, const FPlatformingSimInput& Input);
+
+	/** Moves a character along one axis, stopping at solids. Returns the blocking normal, or zero */
+	FVector3f MoveAxis(FPlatformingSimCharacter& Character, int32 Axis, float Delta) const;
+
+	/** Simulation settings */
+	FPlatformingSimSettings Settings;
+
+	/** Fixed step length */
+	float FixedDeltaTime;
+
+	/** Static world solids */
+	TArray<FBox3f> Solids;
+
+	/** Simulated characters */
+	TArray<FPlatformingSimCharacter> Characters;
+
+	/** Number of steps simulated */
+	uint32 Frame = 0;
+};
@@ -0,0 +1,222 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlatformingSimulation.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PlatformingNetEmulationTest
+{
+	/** Simulation steps per second */
+	constexpr int32 StepRate = 60;
+
+	/** Length of the emulated session. One minute, so the correction count is per minute */
+	constexpr int32 NumFrames = 60 * StepRate;
+
+	/** One way latency in steps. About 83ms, so a little over 150ms round trip */
+	constexpr int32 LatencyFrames = 5;
+
+	/** Steps between server-only events the client can't predict, like a hit from an enemy it hasn't seen yet */
+	constexpr int32 ServerEventInterval = 5 * StepRate;
+
+	/** Move sent from the client to the server */
+	struct FClientMove
+	{
+		int32 Frame = 0;
+		FPlatformingSimInput Input;
+
+		/** Client state after the move, for the server to check */
+		FVector3f Location = FVector3f::ZeroVector;
+		FVector3f Velocity = FVector3f::ZeroVector;
+
+		/** Frame of the last correction the client applied */
+		int32 AckedCorrection = INDEX_NONE;
+	};
+
+	/** Correction sent from the server to the client. Carries the whole character state, including the abilities */
+	struct FCorrection
+	{
+		int32 Frame = 0;
+		FPlatformingSimCharacter State;
+	};
+
+	/** Seed of the emulated player's inputs, so every run sends the same moves */
+	constexpr int32 InputSeed = 0x1A2B3C;
+
+	/** Returns a reproducible sequence of inputs. Inputs change every quarter second, so jumps, air jumps and dashes happen often */
+	TArray<FPlatformingSimInput> MakeInputs(int32 NumInputs)
+	{
+		FRandomStream Random(InputSeed);
+
+		TArray<FPlatformingSimInput> Inputs;
+		Inputs.Reserve(NumInputs);
+
+		FPlatformingSimInput Input;
+
+		for (int32 Frame = 0; Frame < NumInputs; ++Frame)
+		{
+			if (Frame % (StepRate / 4) == 0)
+			{
+				Input.Move.X = static_cast<float>(Random.RandRange(-1, 1));
+				Input.bJump = Random.FRand() < 0.5f;
+				Input.bDash = Random.FRand() < 0.15f;
+			}
+
+			Inputs.Add(Input);
+		}
+
+		return Inputs;
+	}
+
+	/** Builds the same level on the client and the server */
+	void SetupLevel(FPlatformingSimulation& Simulation, const FPlatformingSimSettings& Settings)
+	{
+		Simulation.AddSolid(FBox3f(FVector3f(-2000.0f, -500.0f, -100.0f), FVector3f(2000.0f, 500.0f, 0.0f)));
+		Simulation.AddSolid(FBox3f(FVector3f(-2000.0f, -500.0f, 0.0f), FVector3f(-1600.0f, 500.0f, 2000.0f)));
+		Simulation.AddSolid(FBox3f(FVector3f(1600.0f, -500.0f, 0.0f), FVector3f(2000.0f, 500.0f, 2000.0f)));
+		Simulation.AddSolid(FBox3f(FVector3f(-600.0f, -500.0f, 250.0f), FVector3f(-200.0f, 500.0f, 290.0f)));
+
+		Simulation.AddCharacter(FVector3f(0.0f, 0.0f, Settings.HalfExtent.Z));
+	}
+
+	/** Returns true if both characters have the same movement and ability state */
+	bool IsSameState(const FPlatformingSimCharacter& A, const FPlatformingSimCharacter& B)
+	{
+		return A.Location == B.Location
+			&& A.Velocity == B.Velocity
+			&& A.JumpCount == B.JumpCount
+			&& A.Abilities.FallingTime == B.Abilities.FallingTime
+			&& A.Abilities.WallJumpLockoutTime == B.Abilities.WallJumpLockoutTime
+			&& A.Abilities.DashTimeLeft == B.Abilities.DashTimeLeft
+			&& A.Abilities.bHasDoubleJumped == B.Abilities.bHasDoubleJumped
+			&& A.Abilities.bHasDashed == B.Abilities.bHasDashed
+			&& A.Abilities.bIsDashing == B.Abilities.bIsDashing;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlatformingSimulationNetEmulationTest, "ExampleProject.Platforming.Simulation.NetEmulationCorrections", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPlatformingSimulationNetEmulationTest::RunTest(const FString& Parameters)
+{
+	using namespace PlatformingNetEmulationTest;
+
+	// emulate an owning client predicting its moves and a server validating them over a lagged connection.
+	// The client saves its inputs, and when corrected, replays them from the server state.
+	// This only covers the standalone simulation's state and replays, not the movement component's saved moves
+	FPlatformingSimSettings Settings;
+	Settings.DashSpeed = 1500.0f;
+	Settings.DashDuration = 0.25f;
+
+	const float FixedDeltaTime = 1.0f / StepRate;
+
+	FPlatformingSimulation Client(Settings, FixedDeltaTime);
+	FPlatformingSimulation Server(Settings, FixedDeltaTime);
+
+	SetupLevel(Client, Settings);
+	SetupLevel(Server, Settings);
+
+	const TArray<FPlatformingSimInput> Inputs = MakeInputs(NumFrames);
+
+	TArray<FPlatformingSimInput> SavedInputs;
+	TArray<TPair<int32, FClientMove>> MovesInFlight;
+	TArray<TPair<int32, FCorrection>> CorrectionsInFlight;
+
+	int32 AckedCorrection = INDEX_NONE;
+	int32 LastSentCorrection = INDEX_NONE;
+	int32 NumServerEvents = 0;
+	int32 NumCorrections = 0;
+
+	// keep running after the last client move until everything in flight has arrived
+	for (int32 Frame = 0; Frame < NumFrames + LatencyFrames * 2; ++Frame)
+	{
+		// client: apply any correction that arrived, then replay the moves the server hasn't seen yet
+		for (int32 i = 0; i < CorrectionsInFlight.Num(); ++i)
+		{
+			if (CorrectionsInFlight[i].Key > Frame)
+			{
+				continue;
+			}
+
+			const FCorrection& Correction = CorrectionsInFlight[i].Value;
+
+			Client.GetCharacters()[0] = Correction.State;
+
+			for (int32 ReplayFrame = Correction.Frame + 1; ReplayFrame < SavedInputs.Num(); ++ReplayFrame)
+			{
+				Client.Step(MakeArrayView(&SavedInputs[ReplayFrame], 1));
+			}
+
+			AckedCorrection = Correction.Frame;
+
+			CorrectionsInFlight.RemoveAt(i--);
+		}
+
+		// client: predict the next move and send it
+		if (Frame < NumFrames)
+		{
+			const FPlatformingSimInput& Input = Inputs[Frame];
+			SavedInputs.Add(Input);
+
+			Client.Step(MakeArrayView(&Input, 1));
+
+			FClientMove Move;
+			Move.Frame = Frame;
+			Move.Input = Input;
+			Move.Location = Client.GetCharacters()[0].Location;
+			Move.Velocity = Client.GetCharacters()[0].Velocity;
+			Move.AckedCorrection = AckedCorrection;
+
+			MovesInFlight.Emplace(Frame + LatencyFrames, Move);
+		}
+
+		// server: simulate the moves that arrived, in order, and correct the client if it mispredicted
+		while (MovesInFlight.Num() > 0 && MovesInFlight[0].Key <= Frame)
+		{
+			const FClientMove Move = MovesInFlight[0].Value;
+			MovesInFlight.RemoveAt(0);
+
+			FPlatformingSimCharacter& ServerCharacter = Server.GetCharacters()[0];
+
+			// knock the character up with something the client doesn't know about
+			if (Move.Frame % ServerEventInterval == ServerEventInterval / 2)
+			{
+				ServerCharacter.Velocity.Z = 900.0f;
+				++NumServerEvents;
+			}
+
+			Server.Step(MakeArrayView(&Move.Input, 1));
+
+			// don't send another correction until the client has acknowledged the last one
+			if (LastSentCorrection > Move.AckedCorrection)
+			{
+				continue;
+			}
+
+			if (!ServerCharacter.Location.Equals(Move.Location, 0.1f) || !ServerCharacter.Velocity.Equals(Move.Velocity, 0.1f))
+			{
+				FCorrection Correction;
+				Correction.Frame = Move.Frame;
+				Correction.State = ServerCharacter;
+
+				CorrectionsInFlight.Emplace(Frame + LatencyFrames, Correction);
+
+				LastSentCorrection = Move.Frame;
+				++NumCorrections;
+			}
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("%d server corrections per minute at %.0f ms round trip, for %d server-only events."), NumCorrections, LatencyFrames * 2 * FixedDeltaTime * 1000.0f, NumServerEvents));
+
+	// every unpredictable event needs one correction at most. More means a replay from the corrected state diverged again
+	TestTrue(TEXT("The server-only events caused corrections"), NumCorrections > 0);
+	TestTrue(TEXT("Each server-only event caused at most one correction"), NumCorrections <= NumServerEvents);
+
+	// once the last correction was applied, the client must end in the exact same state as the server, including the abilities
+	TestTrue(TEXT("Client and server end in the same state"), IsSameState(Client.GetCharacters()[0], Server.GetCharacters()[0]));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,145 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlatformingSimulation.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/PlatformTime.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PlatformingSimulationTest
+{
+	/** Simulation steps per second */
+	constexpr int32 StepRate = 60;
+
+	/** Returns a reproducible input for a character and frame. Inputs change every half second, staggered per character */
+	FPlatformingSimInput MakeInput(int32 CharacterIndex, int32 Frame)
+	{
+		const uint32 Seed = HashCombineFast(GetTypeHash(CharacterIndex), GetTypeHash((Frame + CharacterIndex * 7) / 30));
+
+		FPlatformingSimInput Input;
+		Input.Move.X = static_cast<float>(static_cast<int32>(Seed % 3) - 1);
+		Input.bJump = (Seed & 0x30) == 0x30;
+		Input.bDash = (Seed & 0x7C0) == 0;
+
+		return Input;
+	}
+
+	/** Returns settings with a timed dash, so dashes are simulated too */
+	FPlatformingSimSettings MakeSettings()
+	{
+		FPlatformingSimSettings Settings;
+		Settings.DashSpeed = 1500.0f;
+		Settings.DashDuration = 0.25f;
+
+		return Settings;
+	}
+
+	/** Builds a walled arena with a couple of platforms. Characters don't collide with each other */
+	void SetupArena(FPlatformingSimulation& Simulation, int32 NumCharacters)
+	{
+		const FPlatformingSimSettings Settings = MakeSettings();
+
+		Simulation.AddSolid(FBox3f(FVector3f(-2500.0f, -500.0f, -100.0f), FVector3f(2500.0f, 500.0f, 0.0f)));
+		Simulation.AddSolid(FBox3f(FVector3f(-2500.0f, -500.0f, 0.0f), FVector3f(-2000.0f, 500.0f, 2000.0f)));
+		Simulation.AddSolid(FBox3f(FVector3f(2000.0f, -500.0f, 0.0f), FVector3f(2500.0f, 500.0f, 2000.0f)));
+		Simulation.AddSolid(FBox3f(FVector3f(-800.0f, -500.0f, 200.0f), FVector3f(-400.0f, 500.0f, 240.0f)));
+		Simulation.AddSolid(FBox3f(FVector3f(400.0f, -500.0f, 300.0f), FVector3f(800.0f, 500.0f, 340.0f)));
+
+		for (int32 i = 0; i < NumCharacters; ++i)
+		{
+			Simulation.AddCharacter(FVector3f(-1900.0f + (i % 3800), 0.0f, Settings.HalfExtent.Z));
+		}
+	}
+
+	/** Steps the simulation over a range of frames with the reproducible inputs */
+	void StepFrames(FPlatformingSimulation& Simulation, int32 FirstFrame, int32 EndFrame)
+	{
+		const int32 NumCharacters = Simulation.GetCharacters().Num();
+
+		TArray<FPlatformingSimInput> Inputs;
+		Inputs.SetNum(NumCharacters);
+
+		for (int32 Frame = FirstFrame; Frame < EndFrame; ++Frame)
+		{
+			for (int32 i = 0; i < NumCharacters; ++i)
+			{
+				Inputs[i] = MakeInput(i, Frame);
+			}
+
+			Simulation.Step(Inputs);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlatformingSimulationRollbackTest, "ExampleProject.Platforming.Simulation.Rollback", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FPlatformingSimulationRollbackTest::RunTest(const FString& Parameters)
+{
+	using namespace PlatformingSimulationTest;
+
+	constexpr int32 NumCharacters = 64;
+	constexpr int32 SaveFrame = 5 * StepRate;
+	constexpr int32 EndFrame = 10 * StepRate;
+
+	FPlatformingSimulation Simulation(MakeSettings(), 1.0f / StepRate);
+	SetupArena(Simulation, NumCharacters);
+
+	// run to the save point and save the frame
+	StepFrames(Simulation, 0, SaveFrame);
+
+	const TArray<FPlatformingSimCharacter> SavedFrame = Simulation.GetCharacters();
+
+	StepFrames(Simulation, SaveFrame, EndFrame);
+	const uint32 FirstChecksum = Simulation.ComputeChecksum();
+
+	// roll back and resimulate the same inputs
+	Simulation.GetCharacters() = SavedFrame;
+
+	StepFrames(Simulation, SaveFrame, EndFrame);
+	const uint32 SecondChecksum = Simulation.ComputeChecksum();
+
+	TestEqual(TEXT("Resimulating from a saved frame reproduces the same state"), SecondChecksum, FirstChecksum);
+
+	// the checksum has to see ability state differences, or a mispredicted double jump would go unnoticed until it moves the character
+	Simulation.GetCharacters()[0].Abilities.bHasDoubleJumped = !Simulation.GetCharacters()[0].Abilities.bHasDoubleJumped;
+
+	TestNotEqual(TEXT("The checksum covers the ability state"), Simulation.ComputeChecksum(), SecondChecksum);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPlatformingSimulationBenchmarkTest, "ExampleProject.Platforming.Simulation.Benchmark", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FPlatformingSimulationBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace PlatformingSimulationTest;
+
+	constexpr int32 NumCharacters = 10000;
+	constexpr int32 NumFrames = 60 * StepRate;
+
+	uint32 Checksums[2];
+	double StepTimes[2];
+
+	// run twice with the same inputs, so the benchmark also checks the runs are reproducible
+	for (int32 Run = 0; Run < 2; ++Run)
+	{
+		FPlatformingSimulation Simulation(MakeSettings(), 1.0f / StepRate);
+		SetupArena(Simulation, NumCharacters);
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		StepFrames(Simulation, 0, NumFrames);
+
+		StepTimes[Run] = FPlatformTime::Seconds() - StartTime;
+		Checksums[Run] = Simulation.ComputeChecksum();
+	}
+
+	AddInfo(FString::Printf(TEXT("%d characters for %d s took %.1f ms and %.1f ms (%.2f us per character step)."),
+		NumCharacters, NumFrames / StepRate, StepTimes[0] * 1000.0, StepTimes[1] * 1000.0, StepTimes[1] * 1000000.0 / (static_cast<double>(NumCharacters) * NumFrames)));
+
+	TestEqual(TEXT("Both runs end in the same state"), Checksums[1], Checksums[0]);
+
+	return true;
+}
+
+#endif
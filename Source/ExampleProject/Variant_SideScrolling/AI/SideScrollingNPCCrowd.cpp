@@ -0,0 +1,420 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SideScrollingNPCCrowd.h"
+#include "SideScrollingNPC.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+
+ASideScrollingNPCCrowd::ASideScrollingNPCCrowd()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// create the instanced mesh. Crowd agents are purely visual, so they have no collision
+	RootComponent = CrowdMesh = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Crowd Mesh"));
+
+	CrowdMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	CrowdMesh->SetCanEverAffectNavigation(false);
+	CrowdMesh->SetMobility(EComponentMobility::Movable);
+
+	// the server decides promotion and replicates the agent states. The crowd spans the whole level, so it's always relevant
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	SetReplicatingMovement(false);
+}
+
+void ASideScrollingNPCCrowd::BeginPlay()
+{
+	Super::BeginPlay();
+
+	InitializeAgents();
+
+	PromotedAgents.Init(false, NumAgents);
+	RemovedAgents.Init(false, NumAgents);
+	PromotedNPCs.SetNumZeroed(NumAgents);
+
+	// apply any agent states that replicated before we were initialized
+	if (!HasAuthority())
+	{
+		OnRep_AgentStates();
+	}
+
+	UpdateMovement();
+
+	// create the instances
+	InstanceTransforms.SetNumUninitialized(NumAgents);
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		InstanceTransforms[i] = GetAgentTransform(i);
+	}
+
+	CrowdMesh->ClearInstances();
+	CrowdMesh->AddInstances(InstanceTransforms, false, true);
+}
+
+void ASideScrollingNPCCrowd::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	// destroy any promoted actors we still own
+	for (ASideScrollingNPC* NPC : PromotedNPCs)
+	{
+		if (IsValid(NPC))
+		{
+			NPC->Destroy();
+		}
+	}
+
+	PromotedNPCs.Reset();
+}
+
+void ASideScrollingNPCCrowd::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ASideScrollingNPCCrowd, ReplicatedPromotedAgents);
+	DOREPLIFETIME(ASideScrollingNPCCrowd, ReplicatedRemovedAgents);
+	DOREPLIFETIME(ASideScrollingNPCCrowd, ReplicatedPhases);
+	DOREPLIFETIME_CONDITION(ASideScrollingNPCCrowd, RandomSeed, COND_InitialOnly);
+}
+
+void ASideScrollingNPCCrowd::InitializeAgents()
+{
+	FRandomStream Random(RandomSeed);
+
+	const float StartX = GetActorLocation().X;
+
+	AgentSpeed.SetNumUninitialized(NumAgents);
+	AgentPatrolMinX.SetNumUninitialized(NumAgents);
+	AgentPatrolMaxX.SetNumUninitialized(NumAgents);
+	AgentPhase.SetNumUninitialized(NumAgents);
+	AgentX.SetNumZeroed(NumAgents);
+	AgentFacesBack.Init(false, NumAgents);
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		const float SpawnX = StartX + Random.FRandRange(0.0f, SpawnLength);
+		const float PatrolDistance = Random.FRandRange(MinPatrolDistance, MaxPatrolDistance);
+
+		AgentSpeed[i] = WalkSpeed * Random.FRandRange(0.8f, 1.2f);
+		AgentPatrolMinX[i] = SpawnX - PatrolDistance;
+		AgentPatrolMaxX[i] = SpawnX + PatrolDistance;
+
+		// start at the spawn point, in the middle of either the walk up or the walk back down
+		AgentPhase[i] = Random.FRand() < 0.5f ? 3.0f * PatrolDistance : PatrolDistance;
+	}
+
+	// agents demoted by the server continue from where their actor left off
+	for (const FSideScrollingNPCCrowdPhase& Phase : ReplicatedPhases)
+	{
+		if (AgentPhase.IsValidIndex(Phase.Agent))
+		{
+			AgentPhase[Phase.Agent] = Phase.Phase;
+		}
+	}
+}
+
+double ASideScrollingNPCCrowd::GetCrowdTime() const
+{
+	// the game state keeps the server time in sync on clients, so every machine evaluates the same patrols
+	if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+	{
+		return GameState->GetServerWorldTimeSeconds();
+	}
+
+	return GetWorld()->GetTimeSeconds();
+}
+
+void ASideScrollingNPCCrowd::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateMovement();
+
+	// promotion doesn't need to run every frame. Clients receive the results from the server
+	PromotionCheckTimer -= DeltaTime;
+
+	if (HasAuthority() && PromotionCheckTimer <= 0.0f)
+	{
+		PromotionCheckTimer = PromotionCheckInterval;
+
+		UpdatePromotion();
+	}
+
+	UpdateRepresentation();
+}
+
+void ASideScrollingNPCCrowd::UpdateMovement()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SideScrollingNPCCrowd_Movement);
+
+	const double Time = GetCrowdTime();
+
+	// place every agent on its patrol loop. The loop walks up to the max X, turns around and walks back down
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		const float PatrolLength = AgentPatrolMaxX[i] - AgentPatrolMinX[i];
+
+		if (PatrolLength <= 0.0f)
+		{
+			AgentX[i] = AgentPatrolMinX[i];
+			continue;
+		}
+
+		const float Distance = static_cast<float>(FMath::Fmod(AgentPhase[i] + AgentSpeed[i] * Time, 2.0 * PatrolLength));
+
+		if (Distance < PatrolLength)
+		{
+			AgentX[i] = AgentPatrolMinX[i] + Distance;
+			AgentFacesBack[i] = false;
+
+		} else {
+
+			AgentX[i] = AgentPatrolMaxX[i] - (Distance - PatrolLength);
+			AgentFacesBack[i] = true;
+
+		}
+	}
+}
+
+void ASideScrollingNPCCrowd::UpdatePromotion()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SideScrollingNPCCrowd_Promotion);
+
+	// gather the player locations
+	TArray<FVector, TInlineAllocator<8>> PlayerLocations;
+
+	if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+	{
+		for (const APlayerState* PlayerState : GameState->PlayerArray)
+		{
+			if (const APawn* PlayerPawn = PlayerState ? PlayerState->GetPawn() : nullptr)
+			{
+				PlayerLocations.Add(PlayerPawn->GetActorLocation());
+			}
+		}
+	}
+
+	const float AgentZ = GetActorLocation().Z;
+
+	const float PromotionRadiusSquared = FMath::Square(PromotionRadius);
+	const float DemotionRadiusSquared = FMath::Square(DemotionRadius);
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		if (RemovedAgents[i])
+		{
+			continue;
+		}
+
+		// find the closest player on the side scrolling plane
+		float ClosestDistanceSquared = UE_BIG_NUMBER;
+
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			const float DeltaX = PlayerLocation.X - AgentX[i];
+			const float DeltaZ = PlayerLocation.Z - AgentZ;
+
+			ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, DeltaX * DeltaX + DeltaZ * DeltaZ);
+		}
+
+		if (PromotedAgents[i])
+		{
+			// was the promoted actor destroyed by gameplay?
+			if (!IsValid(PromotedNPCs[i]))
+			{
+				PromotedAgents[i] = false;
+				PromotedNPCs[i] = nullptr;
+				RemovedAgents[i] = true;
+				--NumPromotedAgents;
+
+				ReplicatedPromotedAgents.RemoveSwap(i);
+				ReplicatedRemovedAgents.Add(i);
+
+				continue;
+			}
+
+			// return to the crowd once every player is far enough
+			if (ClosestDistanceSquared > DemotionRadiusSquared)
+			{
+				DemoteAgent(i);
+			}
+
+		} else if (ClosestDistanceSquared < PromotionRadiusSquared && NumPromotedAgents < MaxPromotedAgents) {
+
+			// agents that fail to spawn stay in the crowd and are tried again on the next check
+			PromoteAgent(i);
+
+		}
+	}
+}
+
+void ASideScrollingNPCCrowd::OnRep_AgentStates()
+{
+	// wait until BeginPlay has sized the agent state
+	if (PromotedAgents.Num() != NumAgents)
+	{
+		return;
+	}
+
+	PromotedAgents.Init(false, NumAgents);
+	RemovedAgents.Init(false, NumAgents);
+	NumPromotedAgents = 0;
+
+	for (const int32 AgentIndex : ReplicatedPromotedAgents)
+	{
+		if (PromotedAgents.IsValidIndex(AgentIndex))
+		{
+			PromotedAgents[AgentIndex] = true;
+			++NumPromotedAgents;
+		}
+	}
+
+	for (const int32 AgentIndex : ReplicatedRemovedAgents)
+	{
+		if (RemovedAgents.IsValidIndex(AgentIndex))
+		{
+			RemovedAgents[AgentIndex] = true;
+		}
+	}
+
+	for (const FSideScrollingNPCCrowdPhase& Phase : ReplicatedPhases)
+	{
+		if (AgentPhase.IsValidIndex(Phase.Agent))
+		{
+			AgentPhase[Phase.Agent] = Phase.Phase;
+		}
+	}
+}
+
+void ASideScrollingNPCCrowd::OnRep_RandomSeed()
+{
+	// BeginPlay spawns the agents if the seed arrives first
+	if (HasActorBegunPlay())
+	{
+		InitializeAgents();
+	}
+}
+
+void ASideScrollingNPCCrowd::UpdateRepresentation()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SideScrollingNPCCrowd_Representation);
+
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		InstanceTransforms[i] = GetAgentTransform(i);
+	}
+
+	// push all instances in one batch
+	CrowdMesh->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, false);
+}
+
+FTransform ASideScrollingNPCCrowd::GetAgentTransform(int32 AgentIndex) const
+{
+	// hide promoted and removed agents by collapsing their instance
+	const bool bHidden = PromotedAgents[AgentIndex] || RemovedAgents[AgentIndex];
+
+	const FVector Location(AgentX[AgentIndex], GetActorLocation().Y, GetActorLocation().Z);
+	const FRotator Rotation(0.0f, AgentFacesBack[AgentIndex] ? 180.0f : 0.0f, 0.0f);
+
+	return FTransform(Rotation, Location, bHidden ? FVector::ZeroVector : FVector::OneVector);
+}
+
+bool ASideScrollingNPCCrowd::PromoteAgent(int32 AgentIndex)
+{
+	if (!NPCClass)
+	{
+		return false;
+	}
+
+	// spawn the NPC standing on the crowd's ground height
+	const ASideScrollingNPC* NPCDefaults = NPCClass->GetDefaultObject<ASideScrollingNPC>();
+	const float HalfHeight = NPCDefaults->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	FTransform SpawnTransform = GetAgentTransform(AgentIndex);
+	SpawnTransform.SetScale3D(FVector::OneVector);
+	SpawnTransform.AddToTranslation(FVector(0.0f, 0.0f, HalfHeight));
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	ASideScrollingNPC* NPC = GetWorld()->SpawnActor<ASideScrollingNPC>(NPCClass, SpawnTransform, SpawnParams);
+
+	if (!NPC)
+	{
+		return false;
+	}
+
+	// make sure the NPC gets its AI controller
+	if (!NPC->GetController())
+	{
+		NPC->SpawnDefaultController();
+	}
+
+	// only mark the agent once its actor exists, or the next check would take it for destroyed and remove it for good
+	PromotedNPCs[AgentIndex] = NPC;
+	PromotedAgents[AgentIndex] = true;
+	++NumPromotedAgents;
+
+	// clients hide the agent once this replicates, and receive the replicated NPC
+	ReplicatedPromotedAgents.Add(AgentIndex);
+
+	return true;
+}
+
+void ASideScrollingNPCCrowd::DemoteAgent(int32 AgentIndex)
+{
+	// keep promoted NPCs around until they recover from an interaction
+	ASideScrollingNPC* NPC = PromotedNPCs[AgentIndex];
+
+	if (IsValid(NPC))
+	{
+		if (NPC->bDeactivated)
+		{
+			return;
+		}
+
+		// continue the patrol from where the actor left off, in the direction it faces.
+		// Find the phase that puts the agent there at the current server time, and replicate it so clients follow
+		const float PatrolLength = AgentPatrolMaxX[AgentIndex] - AgentPatrolMinX[AgentIndex];
+
+		if (PatrolLength > 0.0f)
+		{
+			const float X = FMath::Clamp(NPC->GetActorLocation().X, AgentPatrolMinX[AgentIndex], AgentPatrolMaxX[AgentIndex]);
+			const bool bFacesBack = NPC->GetActorForwardVector().X < 0.0f;
+
+			const double Distance = bFacesBack ? PatrolLength + (AgentPatrolMaxX[AgentIndex] - X) : X - AgentPatrolMinX[AgentIndex];
+			double Phase = FMath::Fmod(Distance - AgentSpeed[AgentIndex] * GetCrowdTime(), 2.0 * PatrolLength);
+
+			if (Phase < 0.0)
+			{
+				Phase += 2.0 * PatrolLength;
+			}
+
+			AgentPhase[AgentIndex] = static_cast<float>(Phase);
+
+			FSideScrollingNPCCrowdPhase* ReplicatedPhase = ReplicatedPhases.FindByPredicate([AgentIndex](const FSideScrollingNPCCrowdPhase& Entry) { return Entry.Agent == AgentIndex; });
+
+			if (!ReplicatedPhase)
+			{
+				ReplicatedPhase = &ReplicatedPhases.AddDefaulted_GetRef();
+				ReplicatedPhase->Agent = AgentIndex;
+			}
+
+			ReplicatedPhase->Phase = AgentPhase[AgentIndex];
+		}
+
+		NPC->Destroy();
+	}
+
+	PromotedNPCs[AgentIndex] = nullptr;
+	PromotedAgents[AgentIndex] = false;
+	--NumPromotedAgents;
+
+	ReplicatedPromotedAgents.RemoveSwap(AgentIndex);
+}
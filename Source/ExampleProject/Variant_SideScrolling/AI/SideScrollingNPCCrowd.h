@@ -0,0 +1,195 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SideScrollingNPCCrowd.generated.h"
+
+class UInstancedStaticMeshComponent;
+class ASideScrollingNPC;
+
+/**
+ *  Patrol phase of a crowd agent, set by the server when the agent is demoted back into the crowd
+ */
+USTRUCT()
+struct FSideScrollingNPCCrowdPhase
+{
+	GENERATED_BODY()
+
+	/** Index of the agent */
+	UPROPERTY()
+	int32 Agent = 0;
+
+	/** Distance along the patrol loop the agent was at on server time zero */
+	UPROPERTY()
+	float Phase = 0.0f;
+};
+
+/**
+ *  A large crowd of lightweight background NPCs for the side scrolling game.
+ *  Agents are simulated as plain arrays patrolling back and forth along the X axis,
+ *  and drawn through a single instanced static mesh.
+ *  When a player gets close, nearby agents are promoted to full ASideScrollingNPC actors,
+ *  and demoted back into the crowd once all players have moved away.
+ *  Promotion is decided by the server, and the promoted and removed agents are replicated so clients hide them.
+ *  Agent positions are a function of the replicated server time, the random seed and the phases the server sets
+ *  when it demotes agents, so every machine, including late joiners, simulates the same crowd.
+ *  The promotion radius should be larger than the player's interaction radius,
+ *  so agents are always promoted before they can be interacted with.
+ */
+UCLASS(abstract)
+class ASideScrollingNPCCrowd : public AActor
+{
+	GENERATED_BODY()
+
+	/** Instanced mesh used to draw the agents that haven't been promoted */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
+	UInstancedStaticMeshComponent* CrowdMesh;
+
+protected:
+
+	/** NPC class to spawn when an agent is promoted */
+	UPROPERTY(EditAnywhere, Category="Crowd")
+	TSubclassOf<ASideScrollingNPC> NPCClass;
+
+	/** Number of agents in the crowd */
+	UPROPERTY(EditAnywhere, Category="Crowd", meta = (ClampMin = 0, ClampMax = 100000))
+	int32 NumAgents = 1000;
+
+	/** Seed for the agent spawn and patrol randomization. Replicated, so clients spawn the same agents */
+	UPROPERTY(EditAnywhere, ReplicatedUsing=OnRep_RandomSeed, Category="Crowd")
+	int32 RandomSeed = 0;
+
+	/** Length of the spawn area along the X axis, starting at the actor location */
+	UPROPERTY(EditAnywhere, Category="Crowd", meta = (ClampMin = 0, ClampMax = 1000000, Units = "cm"))
+	float SpawnLength = 50000.0f;
+
+	/** Min distance each agent patrols away from its spawn point */
+	UPROPERTY(EditAnywhere, Category="Crowd", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
+	float MinPatrolDistance = 200.0f;
+
+	/** Max distance each agent patrols away from its spawn point */
+	UPROPERTY(EditAnywhere, Category="Crowd", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
+	float MaxPatrolDistance = 1000.0f;
+
+	/** Agent walk speed. Each agent varies it slightly */
+	UPROPERTY(EditAnywhere, Category="Crowd", meta = (ClampMin = 0, ClampMax = 10000, Units = "cm/s"))
+	float WalkSpeed = 150.0f;
+
+	/** Distance to a player under which agents are promoted to actors */
+	UPROPERTY(EditAnywhere, Category="Crowd|Promotion", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
+	float PromotionRadius = 1500.0f;
+
+	/** Distance to all players past which promoted agents return to the crowd. Should be larger than the promotion radius */
+	UPROPERTY(EditAnywhere, Category="Crowd|Promotion", meta = (ClampMin = 0, ClampMax = 100000, Units = "cm"))
+	float DemotionRadius = 2500.0f;
+
+	/** Max number of agents that can be promoted at the same time */
+	UPROPERTY(EditAnywhere, Category="Crowd|Promotion", meta = (ClampMin = 0, ClampMax = 1000))
+	int32 MaxPromotedAgents = 32;
+
+	/** Time between promotion checks */
+	UPROPERTY(EditAnywhere, Category="Crowd|Promotion", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float PromotionCheckInterval = 0.2f;
+
+	/** Agent state, stored as parallel arrays. The speed is always positive */
+	TArray<float> AgentSpeed;
+	TArray<float> AgentPatrolMinX;
+	TArray<float> AgentPatrolMaxX;
+
+	/** Distance along the patrol loop each agent was at on server time zero. The loop walks up to the max X, then back down */
+	TArray<float> AgentPhase;
+
+	/** Agent locations and walk directions at the current server time, evaluated every frame */
+	TArray<float> AgentX;
+	TBitArray<> AgentFacesBack;
+
+	/** Agents currently replaced by an actor. Rebuilt from the replicated list on clients */
+	TBitArray<> PromotedAgents;
+
+	/** Actor each agent is promoted to. Only spawned on the server */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ASideScrollingNPC>> PromotedNPCs;
+
+	/** Agents that were promoted and then destroyed, and will no longer be simulated. Rebuilt from the replicated list on clients */
+	TBitArray<> RemovedAgents;
+
+	/** Indices of the promoted agents. Bounded by the max number of promoted agents */
+	UPROPERTY(ReplicatedUsing=OnRep_AgentStates)
+	TArray<int32> ReplicatedPromotedAgents;
+
+	/** Indices of the removed agents */
+	UPROPERTY(ReplicatedUsing=OnRep_AgentStates)
+	TArray<int32> ReplicatedRemovedAgents;
+
+	/** Phases of the agents the server demoted, so they continue their patrol from where their actor left off. One entry per agent at most */
+	UPROPERTY(ReplicatedUsing=OnRep_AgentStates)
+	TArray<FSideScrollingNPCCrowdPhase> ReplicatedPhases;
+
+	/** Scratch instance transforms, reused every frame */
+	TArray<FTransform> InstanceTransforms;
+
+	/** Number of currently promoted agents */
+	int32 NumPromotedAgents = 0;
+
+	/** Time left until the next promotion check */
+	float PromotionCheckTimer = 0.0f;
+
+public:
+
+	/** Constructor */
+	ASideScrollingNPCCrowd();
+
+protected:
+
+	/** Spawns the crowd */
+	virtual void BeginPlay() override;
+
+	/** Destroys any promoted actors */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+public:
+
+	/** Sets up replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+public:
+
+	/** Updates the crowd */
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+
+	/** Sets up the agent patrols from the random seed and the replicated phases */
+	void InitializeAgents();
+
+	/** Returns the server time the patrols are evaluated at. It's the same on every machine */
+	double GetCrowdTime() const;
+
+	/** Moves all crowd agents to their patrol location at the current server time */
+	void UpdateMovement();
+
+	/** Promotes or demotes agents based on the player locations. Server only */
+	void UpdatePromotion();
+
+	/** Rebuilds the promoted and removed agent flags and the agent phases from the replicated lists */
+	UFUNCTION()
+	void OnRep_AgentStates();
+
+	/** Spawns the agents again from the server's seed */
+	UFUNCTION()
+	void OnRep_RandomSeed();
+
+	/** Pushes the agent locations to the instanced mesh */
+	void UpdateRepresentation();
+
+	/** Returns the transform for an agent instance */
+	FTransform GetAgentTransform(int32 AgentIndex) const;
+
+	/** Replaces an agent with a full NPC actor. Returns false, leaving the agent in the crowd, if the actor couldn't be spawned */
+	bool PromoteAgent(int32 AgentIndex);
+
+	/** Returns a promoted agent to the crowd */
+	void DemoteAgent(int32 AgentIndex);
+};
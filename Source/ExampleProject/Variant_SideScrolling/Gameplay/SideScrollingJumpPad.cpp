@@ -5,6 +5,7 @@
 #include "Components/BoxComponent.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "PlatformingMovementComponent.h"
 #include "Components/SceneComponent.h"
 
 ASideScrollingJumpPad::ASideScrollingJumpPad()
@@ -36,6 +37,19 @@ void ASideScrollingJumpPad::BeginOverlap(AActor* OverlappedActor, AActor* OtherA
 	// were we overlapped by a character?
 	if (ACharacter* OverlappingCharacter = Cast<ACharacter>(OtherActor))
 	{
+		// let the platforming movement component launch the character as part of a predicted move
+		if (UPlatformingMovementComponent* PlatformingMovement = Cast<UPlatformingMovementComponent>(OverlappingCharacter->GetCharacterMovement()))
+		{
+			PlatformingMovement->RequestJumpPadLaunch(ZStrength);
+			return;
+		}
+
+		// other characters can't predict the launch, so only the server moves them
+		if (!OverlappingCharacter->HasAuthority())
+		{
+			return;
+		}
+
 		// force the character to jump
 		OverlappingCharacter->Jump();
 
@@ -10,6 +10,8 @@ class UBoxComponent;
 
 /**
  *  A simple jump pad that launches characters into the air
+ *  Characters using the platforming movement component are launched through a predicted move,
+ *  so the owning client and the server apply the launch at the same point in the move history.
  */
 UCLASS(abstract)
 class ASideScrollingJumpPad : public AActor
@@ -0,0 +1,25 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SideScrollingLevelChunkSet.h"
+#include "Algo/BinarySearch.h"
+
+bool USideScrollingLevelChunkSet::FindChunksInRange(float MinX, float MaxX, int32& OutFirst, int32& OutLast) const
+{
+	// find the first chunk that ends past the start of the range
+	OutFirst = Algo::LowerBoundBy(Chunks, MinX, [](const FSideScrollingLevelChunk& Chunk) { return Chunk.MaxX; });
+
+	// find the first chunk that starts past the end of the range
+	OutLast = Algo::UpperBoundBy(Chunks, MaxX, [](const FSideScrollingLevelChunk& Chunk) { return Chunk.MinX; }) - 1;
+
+	return OutFirst <= OutLast;
+}
+
+#if WITH_EDITOR
+void USideScrollingLevelChunkSet::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	Chunks.StableSort([](const FSideScrollingLevelChunk& A, const FSideScrollingLevelChunk& B) { return A.MinX < B.MinX; });
+}
+#endif
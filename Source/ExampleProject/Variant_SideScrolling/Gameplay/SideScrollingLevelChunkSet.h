@@ -0,0 +1,60 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SideScrollingLevelChunkSet.generated.h"
+
+class UWorld;
+
+/**
+ *  A single streamable section of a side scrolling level
+ */
+USTRUCT(BlueprintType)
+struct FSideScrollingLevelChunk
+{
+	GENERATED_BODY()
+
+	/** Level holding this chunk's geometry, pickups, NPCs, jump pads and moving platforms */
+	UPROPERTY(EditAnywhere, Category="Chunk")
+	TSoftObjectPtr<UWorld> Level;
+
+	/** World space offset to load the chunk level at */
+	UPROPERTY(EditAnywhere, Category="Chunk")
+	FVector Offset = FVector::ZeroVector;
+
+	/** Start of the chunk along the side scrolling axis, in world space */
+	UPROPERTY(EditAnywhere, Category="Chunk", meta = (Units="cm"))
+	float MinX = 0.0f;
+
+	/** End of the chunk along the side scrolling axis, in world space */
+	UPROPERTY(EditAnywhere, Category="Chunk", meta = (Units="cm"))
+	float MaxX = 0.0f;
+};
+
+/**
+ *  Data asset describing how a long side scrolling level is split into chunks along the X axis.
+ *  Chunks are streamed in and out by ASideScrollingLevelStreamer.
+ */
+UCLASS(BlueprintType)
+class USideScrollingLevelChunkSet : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	/** List of chunks in this level. Should be sorted by MinX and not overlap */
+	UPROPERTY(EditAnywhere, Category="Chunks")
+	TArray<FSideScrollingLevelChunk> Chunks;
+
+public:
+
+	/** Returns the index range [OutFirst, OutLast] of the chunks overlapping the provided X range. Returns false if there are none */
+	bool FindChunksInRange(float MinX, float MaxX, int32& OutFirst, int32& OutLast) const;
+
+#if WITH_EDITOR
+	/** Keeps the chunk list sorted so range lookups can use a binary search */
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+};
@@ -0,0 +1,376 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SideScrollingLevelStreamer.h"
+#include "SideScrollingLevelChunkSet.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "Components/SceneComponent.h"
+#include "Algo/BinarySearch.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "Camera/PlayerCameraManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Net/UnrealNetwork.h"
+#include "ExampleProject.h"
+
+ASideScrollingLevelStreamer::ASideScrollingLevelStreamer()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// create the root comp
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	// the server decides the resident chunks and replicates them. Streaming covers the whole level, so it's always relevant
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	SetReplicatingMovement(false);
+}
+
+void ASideScrollingLevelStreamer::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// size the per-chunk state
+	const int32 NumChunks = ChunkSet ? ChunkSet->Chunks.Num() : 0;
+
+	ChunkLevels.SetNumZeroed(NumChunks);
+	ResidentChunks.Init(false, NumChunks);
+	ChunkRequestTimes.Init(-1.0, NumChunks);
+
+	if (!ChunkSet)
+	{
+		UE_LOG(LogExampleProject, Warning, TEXT("Level streamer %s has no chunk set."), *GetName());
+
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	// follow any resident set that replicated before we were initialized
+	if (!HasAuthority())
+	{
+		OnRep_ResidentChunks();
+	}
+}
+
+void ASideScrollingLevelStreamer::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	if (bLogStreamingStats)
+	{
+		LogStreamingStats();
+	}
+}
+
+void ASideScrollingLevelStreamer::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ASideScrollingLevelStreamer, ReplicatedResidentChunks);
+}
+
+void ASideScrollingLevelStreamer::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdatePendingChunks(DeltaTime);
+
+	// only the server sees every player. Clients follow the resident set it replicates
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	float PlayersMinX, PlayersMaxX;
+
+	if (!GetPlayersRange(PlayersMinX, PlayersMaxX))
+	{
+		return;
+	}
+
+	// unload chunks that fell outside the unload range first, so their memory is freed before loading more
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkLevels.Num(); ++ChunkIndex)
+	{
+		if (ResidentChunks[ChunkIndex])
+		{
+			const FSideScrollingLevelChunk& Chunk = ChunkSet->Chunks[ChunkIndex];
+
+			if (Chunk.MaxX < PlayersMinX - UnloadDistance || Chunk.MinX > PlayersMaxX + UnloadDistance)
+			{
+				UnloadChunk(ChunkIndex);
+			}
+		}
+	}
+
+	int32 FirstChunk, LastChunk;
+
+	if (!ChunkSet->FindChunksInRange(PlayersMinX - LoadDistance, PlayersMaxX + LoadDistance, FirstChunk, LastChunk))
+	{
+		return;
+	}
+
+	// load the chunks in range, closest to the players first, evicting farther chunks once we hit the resident limit
+	const float PlayersCenterX = (PlayersMinX + PlayersMaxX) * 0.5f;
+
+	int32 Behind = FMath::Clamp(Algo::UpperBoundBy(ChunkSet->Chunks, PlayersCenterX, [](const FSideScrollingLevelChunk& Chunk) { return Chunk.MinX; }) - 1, FirstChunk, LastChunk);
+	int32 Ahead = Behind + 1;
+
+	while (Behind >= FirstChunk || Ahead <= LastChunk)
+	{
+		// pick the closer of the next chunk behind and the next chunk ahead
+		const float BehindDistance = Behind >= FirstChunk ? PlayersCenterX - ChunkSet->Chunks[Behind].MaxX : UE_BIG_NUMBER;
+		const float AheadDistance = Ahead <= LastChunk ? ChunkSet->Chunks[Ahead].MinX - PlayersCenterX : UE_BIG_NUMBER;
+
+		const int32 ChunkIndex = BehindDistance <= AheadDistance ? Behind-- : Ahead++;
+
+		if (ResidentChunks[ChunkIndex])
+		{
+			continue;
+		}
+
+		// at the resident limit, make room by evicting the farthest chunk, as long as it's farther than this one.
+		// Chunks are visited closest first, so once nothing can be evicted no later chunk can be loaded either
+		if (NumResidentChunks >= MaxResidentChunks)
+		{
+			const int32 FarthestChunk = FindFarthestResidentChunk(PlayersMinX, PlayersMaxX);
+
+			if (FarthestChunk == INDEX_NONE || GetChunkDistance(FarthestChunk, PlayersMinX, PlayersMaxX) <= GetChunkDistance(ChunkIndex, PlayersMinX, PlayersMaxX))
+			{
+				break;
+			}
+
+			UnloadChunk(FarthestChunk);
+		}
+
+		LoadChunk(ChunkIndex);
+	}
+}
+
+float ASideScrollingLevelStreamer::GetChunkDistance(int32 ChunkIndex, float PlayersMinX, float PlayersMaxX) const
+{
+	const FSideScrollingLevelChunk& Chunk = ChunkSet->Chunks[ChunkIndex];
+
+	// zero if the chunk overlaps the players range
+	return FMath::Max3(0.0f, Chunk.MinX - PlayersMaxX, PlayersMinX - Chunk.MaxX);
+}
+
+int32 ASideScrollingLevelStreamer::FindFarthestResidentChunk(float PlayersMinX, float PlayersMaxX) const
+{
+	int32 FarthestChunk = INDEX_NONE;
+	float FarthestDistance = -1.0f;
+
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkLevels.Num(); ++ChunkIndex)
+	{
+		if (ResidentChunks[ChunkIndex])
+		{
+			const float Distance = GetChunkDistance(ChunkIndex, PlayersMinX, PlayersMaxX);
+
+			if (Distance > FarthestDistance)
+			{
+				FarthestChunk = ChunkIndex;
+				FarthestDistance = Distance;
+			}
+		}
+	}
+
+	return FarthestChunk;
+}
+
+bool ASideScrollingLevelStreamer::GetPlayersRange(float& OutMinX, float& OutMaxX) const
+{
+	bool bFound = false;
+
+	OutMinX = UE_BIG_NUMBER;
+	OutMaxX = -UE_BIG_NUMBER;
+
+	// the server has a controller for every player, local or remote
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PC = It->Get();
+
+		if (!PC)
+		{
+			continue;
+		}
+
+		// prefer the pawn location, since remote players don't have a valid camera on the server
+		float PlayerX;
+
+		if (const APawn* PlayerPawn = PC->GetPawn())
+		{
+			PlayerX = PlayerPawn->GetActorLocation().X;
+
+		} else if (PC->PlayerCameraManager) {
+
+			PlayerX = PC->PlayerCameraManager->GetCameraLocation().X;
+
+		} else {
+
+			continue;
+
+		}
+
+		OutMinX = FMath::Min(OutMinX, PlayerX);
+		OutMaxX = FMath::Max(OutMaxX, PlayerX);
+
+		bFound = true;
+	}
+
+	return bFound;
+}
+
+void ASideScrollingLevelStreamer::OnRep_ResidentChunks()
+{
+	// wait until BeginPlay has sized the chunk state
+	if (!ChunkSet || ResidentChunks.Num() != ChunkSet->Chunks.Num())
+	{
+		return;
+	}
+
+	TBitArray<> WantedChunks(false, ResidentChunks.Num());
+
+	for (const int32 ChunkIndex : ReplicatedResidentChunks)
+	{
+		if (WantedChunks.IsValidIndex(ChunkIndex))
+		{
+			WantedChunks[ChunkIndex] = true;
+		}
+	}
+
+	// unload first, so their memory is freed before loading more
+	for (int32 ChunkIndex = 0; ChunkIndex < ResidentChunks.Num(); ++ChunkIndex)
+	{
+		if (ResidentChunks[ChunkIndex] && !WantedChunks[ChunkIndex])
+		{
+			UnloadChunk(ChunkIndex);
+		}
+	}
+
+	for (int32 ChunkIndex = 0; ChunkIndex < ResidentChunks.Num(); ++ChunkIndex)
+	{
+		if (WantedChunks[ChunkIndex] && !ResidentChunks[ChunkIndex])
+		{
+			LoadChunk(ChunkIndex);
+		}
+	}
+}
+
+FString ASideScrollingLevelStreamer::GetChunkInstanceName(int32 ChunkIndex) const
+{
+	// the streamer is placed in the persistent level, so its name is the same on every machine
+	return FString::Printf(TEXT("%s_Chunk%d"), *GetName(), ChunkIndex);
+}
+
+void ASideScrollingLevelStreamer::LoadChunk(int32 ChunkIndex)
+{
+	const FSideScrollingLevelChunk& Chunk = ChunkSet->Chunks[ChunkIndex];
+
+	ULevelStreamingDynamic* StreamingLevel = ChunkLevels[ChunkIndex];
+
+	if (StreamingLevel)
+	{
+		// reuse the streaming level from the last time this chunk was resident, so it loads under the same name
+		StreamingLevel->SetShouldBeLoaded(true);
+		StreamingLevel->SetShouldBeVisible(true);
+
+	} else {
+
+		// request the level instance. This loads asynchronously unless something flushes streaming.
+		// The instance name must match between the server and the clients for the chunk's replicated actors to resolve
+		bool bSuccess = false;
+
+		StreamingLevel = ULevelStreamingDynamic::LoadLevelInstanceBySoftObjectPtr(this, Chunk.Level, Chunk.Offset, FRotator::ZeroRotator, bSuccess, GetChunkInstanceName(ChunkIndex));
+
+		if (!bSuccess || !StreamingLevel)
+		{
+			UE_LOG(LogExampleProject, Error, TEXT("Could not load side scrolling level chunk %d (%s)."), ChunkIndex, *Chunk.Level.ToString());
+			return;
+		}
+
+		ChunkLevels[ChunkIndex] = StreamingLevel;
+	}
+
+	ResidentChunks[ChunkIndex] = true;
+	ChunkRequestTimes[ChunkIndex] = FPlatformTime::Seconds();
+
+	++NumResidentChunks;
+
+	if (HasAuthority())
+	{
+		ReplicatedResidentChunks.Add(ChunkIndex);
+	}
+}
+
+void ASideScrollingLevelStreamer::UnloadChunk(int32 ChunkIndex)
+{
+	// the level and all the actors in it will be removed once streaming processes the request.
+	// Keep the streaming level so the chunk loads under the same name next time
+	ChunkLevels[ChunkIndex]->SetShouldBeVisible(false);
+	ChunkLevels[ChunkIndex]->SetShouldBeLoaded(false);
+
+	ResidentChunks[ChunkIndex] = false;
+	ChunkRequestTimes[ChunkIndex] = -1.0;
+
+	--NumResidentChunks;
+
+	if (HasAuthority())
+	{
+		ReplicatedResidentChunks.RemoveSwap(ChunkIndex);
+	}
+}
+
+void ASideScrollingLevelStreamer::UpdatePendingChunks(float DeltaTime)
+{
+	bool bAnyPending = false;
+
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkLevels.Num(); ++ChunkIndex)
+	{
+		// skip chunks that aren't loading
+		if (!ResidentChunks[ChunkIndex] || ChunkRequestTimes[ChunkIndex] < 0.0)
+		{
+			continue;
+		}
+
+		if (!ChunkLevels[ChunkIndex]->IsLevelVisible())
+		{
+			bAnyPending = true;
+			continue;
+		}
+
+		// record the load latency
+		const double LoadTime = FPlatformTime::Seconds() - ChunkRequestTimes[ChunkIndex];
+
+		ChunkRequestTimes[ChunkIndex] = -1.0;
+
+		TotalLoadTime += LoadTime;
+		++NumChunksLoaded;
+
+		PeakUsedMemory = FMath::Max(PeakUsedMemory, static_cast<uint64>(FPlatformMemory::GetStats().UsedPhysical));
+
+		if (bLogStreamingStats)
+		{
+			UE_LOG(LogExampleProject, Log, TEXT("Level chunk %d visible after %.1f ms. Resident chunks: %d"), ChunkIndex, LoadTime * 1000.0, NumResidentChunks);
+		}
+	}
+
+	// track the busy time and the worst frame while streaming is in flight
+	if (bAnyPending)
+	{
+		StreamingBusyTime += DeltaTime;
+		PeakStreamingFrameTime = FMath::Max(PeakStreamingFrameTime, DeltaTime);
+	}
+}
+
+void ASideScrollingLevelStreamer::LogStreamingStats() const
+{
+	const double AverageLoadTime = NumChunksLoaded > 0 ? TotalLoadTime / NumChunksLoaded : 0.0;
+	const double Throughput = StreamingBusyTime > 0.0 ? NumChunksLoaded / StreamingBusyTime : 0.0;
+
+	UE_LOG(LogExampleProject, Log, TEXT("Level streaming stats: %d chunks loaded, average load %.1f ms, throughput %.2f chunks/s, peak streaming frame %.1f ms, peak used memory %.1f MB"),
+		NumChunksLoaded,
+		AverageLoadTime * 1000.0,
+		Throughput,
+		PeakStreamingFrameTime * 1000.0f,
+		PeakUsedMemory / (1024.0 * 1024.0));
+}
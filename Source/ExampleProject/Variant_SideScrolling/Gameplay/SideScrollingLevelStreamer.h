@@ -0,0 +1,129 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SideScrollingLevelStreamer.generated.h"
+
+class USideScrollingLevelChunkSet;
+class ULevelStreamingDynamic;
+
+/**
+ *  Streams the chunks of a long side scrolling level in and out around the players.
+ *  Chunks ahead of the camera are loaded asynchronously, and chunks left far behind are unloaded,
+ *  so only a bounded number of chunks is resident at any time.
+ *  The server decides the resident chunks from the positions of all players, and clients follow the replicated set.
+ *  Each chunk is always instanced under the same name, so actors replicated from inside a chunk resolve on clients.
+ *  Place one in the persistent level and point it to a chunk set.
+ */
+UCLASS()
+class ASideScrollingLevelStreamer : public AActor
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Chunks that make up this level */
+	UPROPERTY(EditAnywhere, Category="Level Streaming")
+	TObjectPtr<USideScrollingLevelChunkSet> ChunkSet;
+
+	/** Distance around the players where chunks are loaded */
+	UPROPERTY(EditAnywhere, Category="Level Streaming", meta = (ClampMin = 0, ClampMax = 100000, Units="cm"))
+	float LoadDistance = 4000.0f;
+
+	/** Distance around the players past which chunks are unloaded. Should be larger than the load distance to avoid thrashing */
+	UPROPERTY(EditAnywhere, Category="Level Streaming", meta = (ClampMin = 0, ClampMax = 100000, Units="cm"))
+	float UnloadDistance = 6000.0f;
+
+	/** Max number of chunks that can be loaded or loading at the same time. At the limit, the farthest chunk is evicted to load a closer one */
+	UPROPERTY(EditAnywhere, Category="Level Streaming", meta = (ClampMin = 1, ClampMax = 100))
+	int32 MaxResidentChunks = 6;
+
+	/** If true, streaming stats will be logged when chunks finish loading and when the streamer is removed */
+	UPROPERTY(EditAnywhere, Category="Level Streaming|Stats")
+	bool bLogStreamingStats = false;
+
+	/** Streaming level for each chunk. Created the first time the chunk is loaded, and kept so the chunk keeps its instance name */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ULevelStreamingDynamic>> ChunkLevels;
+
+	/** Chunks currently loaded or loading */
+	TBitArray<> ResidentChunks;
+
+	/** Indices of the chunks the server keeps resident. Clients load and unload chunks to match */
+	UPROPERTY(ReplicatedUsing=OnRep_ResidentChunks)
+	TArray<int32> ReplicatedResidentChunks;
+
+	/** Time the load of each chunk was requested. Negative once the chunk is visible */
+	TArray<double> ChunkRequestTimes;
+
+	/** Number of chunks currently loaded or loading */
+	int32 NumResidentChunks = 0;
+
+	/** Number of chunks that have finished loading */
+	int32 NumChunksLoaded = 0;
+
+	/** Total time between load requests and the chunks becoming visible */
+	double TotalLoadTime = 0.0;
+
+	/** Total time with at least one chunk loading */
+	double StreamingBusyTime = 0.0;
+
+	/** Longest frame seen while any chunk was loading */
+	float PeakStreamingFrameTime = 0.0f;
+
+	/** Highest process memory use seen after a chunk was loaded */
+	uint64 PeakUsedMemory = 0;
+
+public:
+
+	/** Constructor */
+	ASideScrollingLevelStreamer();
+
+protected:
+
+	/** Initialization */
+	virtual void BeginPlay() override;
+
+	/** Cleanup */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+public:
+
+	/** Sets up replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Updates the resident chunk set */
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+
+	/** Loads and unloads chunks to match the resident set replicated from the server */
+	UFUNCTION()
+	void OnRep_ResidentChunks();
+
+	/** Returns the instance name of a chunk, which is the same on the server and every client */
+	FString GetChunkInstanceName(int32 ChunkIndex) const;
+
+	/** Finds the X range covered by all players. Server only. Returns false if there are no players */
+	bool GetPlayersRange(float& OutMinX, float& OutMaxX) const;
+
+	/** Returns the X distance between a chunk and the players range. Zero if they overlap */
+	float GetChunkDistance(int32 ChunkIndex, float PlayersMinX, float PlayersMaxX) const;
+
+	/** Returns the resident chunk farthest from the players range, or INDEX_NONE if there are none */
+	int32 FindFarthestResidentChunk(float PlayersMinX, float PlayersMaxX) const;
+
+	/** Requests an async load for a chunk */
+	void LoadChunk(int32 ChunkIndex);
+
+	/** Requests an unload for a chunk */
+	void UnloadChunk(int32 ChunkIndex);
+
+	/** Checks pending chunks and records stats for the ones that became visible */
+	void UpdatePendingChunks(float DeltaTime);
+
+	/** Logs the accumulated streaming stats */
+	void LogStreamingStats() const;
+};
@@ -2,7 +2,11 @@
 
 
 #include "SideScrollingMovingPlatform.h"
+#include "SideScrollingPlatformMoverSubsystem.h"
 #include "Components/SceneComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
 
 ASideScrollingMovingPlatform::ASideScrollingMovingPlatform()
 {
@@ -10,6 +14,37 @@ ASideScrollingMovingPlatform::ASideScrollingMovingPlatform()
 
 	// create the root comp
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	// replicate the move start time. The movement itself is simulated on each machine
+	bReplicates = true;
+	SetReplicatingMovement(false);
+}
+
+void ASideScrollingMovingPlatform::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// save the starting location so we can return to it
+	StartLocation = GetActorLocation();
+}
+
+void ASideScrollingMovingPlatform::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	// make sure the mover doesn't keep a reference to us
+	if (USideScrollingPlatformMoverSubsystem* Mover = GetWorld()->GetSubsystem<USideScrollingPlatformMoverSubsystem>())
+	{
+		Mover->StopMove(this);
+	}
+}
+
+void ASideScrollingMovingPlatform::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ASideScrollingMovingPlatform, bMoveFromTarget);
+	DOREPLIFETIME(ASideScrollingMovingPlatform, MoveStartTime);
 }
 
 void ASideScrollingMovingPlatform::Interaction(AActor* Interactor)
@@ -23,8 +58,27 @@ void ASideScrollingMovingPlatform::Interaction(AActor* Interactor)
 	// raise the movement flag
 	bMoving = true;
 
-	// pass control to BP for the actual movement
-	BP_MoveToTarget();
+	// pass control to BP for the actual movement if we're not using native movement
+	if (!bUseNativeMovement)
+	{
+		BP_MoveToTarget();
+		return;
+	}
+
+	// platforms that don't return on their own head back from wherever they're resting
+	bMoveFromTarget = bAtTarget && !(bReturnToStart && !bOneShot);
+
+	// stamp the move start time so clients can follow
+	if (HasAuthority())
+	{
+		if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+		{
+			MoveStartTime = GameState->GetServerWorldTimeSeconds();
+		}
+	}
+
+	// start moving from the beginning
+	StartNativeMove(0.0f);
 }
 
 void ASideScrollingMovingPlatform::ResetInteraction()
@@ -38,3 +92,86 @@ void ASideScrollingMovingPlatform::ResetInteraction()
 	// reset the movement flag
 	bMoving = false;
 }
+
+void ASideScrollingMovingPlatform::NativeMoveFinished()
+{
+	// do we need to head back?
+	if (!bReturning && bReturnToStart && !bOneShot)
+	{
+		bReturning = true;
+
+		if (USideScrollingPlatformMoverSubsystem* Mover = GetWorld()->GetSubsystem<USideScrollingPlatformMoverSubsystem>())
+		{
+			Mover->StartMove(this, PlatformTarget, StartLocation, MoveDuration, EaseExponent);
+		}
+
+		return;
+	}
+
+	// the move is complete. Round trips always end back at the start
+	bAtTarget = !bReturning && !bMoveFromTarget;
+	bReturning = false;
+
+	ResetInteraction();
+}
+
+void ASideScrollingMovingPlatform::StartNativeMove(float ElapsedTime)
+{
+	USideScrollingPlatformMoverSubsystem* Mover = GetWorld()->GetSubsystem<USideScrollingPlatformMoverSubsystem>();
+
+	if (!Mover)
+	{
+		return;
+	}
+
+	const float LegDuration = FMath::Max(MoveDuration, UE_KINDA_SMALL_NUMBER);
+	const bool bRoundTrip = bReturnToStart && !bOneShot && !bMoveFromTarget;
+
+	// the first leg goes to the other end from where the platform was resting
+	const FVector& LegStart = bMoveFromTarget ? PlatformTarget : StartLocation;
+	const FVector& LegEnd = bMoveFromTarget ? StartLocation : PlatformTarget;
+
+	// are we still on the first leg?
+	if (ElapsedTime < LegDuration)
+	{
+		bReturning = false;
+		bAtTarget = false;
+		Mover->StartMove(this, LegStart, LegEnd, MoveDuration, EaseExponent, ElapsedTime / LegDuration);
+
+	// are we on the way back?
+	} else if (bRoundTrip && ElapsedTime < LegDuration * 2.0f) {
+
+		bReturning = true;
+		bAtTarget = false;
+		Mover->StartMove(this, PlatformTarget, StartLocation, MoveDuration, EaseExponent, (ElapsedTime - LegDuration) / LegDuration);
+
+	// the move already finished before we heard about it
+	} else {
+
+		Mover->StopMove(this);
+
+		SetActorLocation(bRoundTrip ? StartLocation : LegEnd, false, nullptr, ETeleportType::TeleportPhysics);
+
+		bAtTarget = !bRoundTrip && !bMoveFromTarget;
+		bReturning = false;
+		ResetInteraction();
+	}
+}
+
+void ASideScrollingMovingPlatform::OnRep_MoveStartTime()
+{
+	// ignore if we're moving through BP code
+	if (!bUseNativeMovement || MoveStartTime < 0.0f)
+	{
+		return;
+	}
+
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+
+	const float ElapsedTime = GameState ? FMath::Max(0.0f, static_cast<float>(GameState->GetServerWorldTimeSeconds()) - MoveStartTime) : 0.0f;
+
+	// catch up with the server move, replacing any locally predicted one
+	bMoving = true;
+
+	StartNativeMove(ElapsedTime);
+}
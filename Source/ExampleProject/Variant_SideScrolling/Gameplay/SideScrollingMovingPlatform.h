@@ -9,7 +9,9 @@
 
 /**
  *  Simple moving platform that can be triggered through interactions by other actors.
- *  The actual movement is performed by Blueprint code through latent execution nodes.
+ *  By default the movement is handed over to Blueprint code through latent execution nodes,
+ *  but it can also be simulated natively by the platform mover subsystem.
+ *  Native moves only replicate their start time and direction; clients derive the platform position from them.
  */
 UCLASS(abstract)
 class ASideScrollingMovingPlatform : public AActor, public ISideScrollingInteractable
@@ -26,6 +28,15 @@ protected:
 	/** If this is true, the platform is mid-movement and will ignore further interactions */
 	bool bMoving = false;
 
+	/** If this is true, the platform is moving back to its starting location */
+	bool bReturning = false;
+
+	/** If this is true, the platform is resting at its target after a native move that didn't return to start */
+	bool bAtTarget = false;
+
+	/** Location of the platform when the game started */
+	FVector StartLocation;
+
 	/** Destination of the platform in world space */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Moving Platform")
 	FVector PlatformTarget;
@@ -38,8 +49,38 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Moving Platform")
 	bool bOneShot = false;
 
+	/** If this is true, the platform is moved by the native platform mover instead of Blueprint code */
+	UPROPERTY(EditAnywhere, Category="Moving Platform|Native Movement")
+	bool bUseNativeMovement = false;
+
+	/** If this is true, the platform moves back to its starting location after reaching the target, then resets. Ignored for one-shot platforms.
+	 *  Otherwise, each interaction moves the platform to the other end */
+	UPROPERTY(EditAnywhere, Category="Moving Platform|Native Movement", meta = (EditCondition = "bUseNativeMovement"))
+	bool bReturnToStart = true;
+
+	/** Easing exponent for the native movement. 1 is linear, higher values ease in and out more sharply */
+	UPROPERTY(EditAnywhere, Category="Moving Platform|Native Movement", meta = (ClampMin = 1, ClampMax = 10, EditCondition = "bUseNativeMovement"))
+	float EaseExponent = 2.0f;
+
+	/** If this is true, the current native move goes from the target back to the starting location */
+	UPROPERTY(Replicated)
+	bool bMoveFromTarget = false;
+
+	/** Server time when the current move started. Negative if the platform hasn't moved yet */
+	UPROPERTY(ReplicatedUsing=OnRep_MoveStartTime)
+	float MoveStartTime = -1.0f;
+
 public:
 
+	/** Initialization */
+	virtual void BeginPlay() override;
+
+	/** Cleanup */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+	/** Sets up replicated properties */
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 // ~begin IInteractable interface 
 
 	/** Performs an interaction triggered by another actor */
@@ -47,14 +88,24 @@ public:
 
 // ~end IInteractable interface
 
-	/** Resets the interaction state. Must be called from BP code to reset the platform */
+	/** Resets the interaction state. Called when a native move finishes, or must be called from BP code to reset the platform */
 	UFUNCTION(BlueprintCallable, Category="Moving Platform")
 	virtual void ResetInteraction();
 
+	/** Called by the platform mover when a native move leg finishes */
+	void NativeMoveFinished();
+
 protected:
 
 	/** Allows Blueprint code to do the actual platform movement */
 	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable, Category="Moving Platform", meta = (DisplayName="Move to Target"))
 	void BP_MoveToTarget();
 
+	/** Starts or resumes the native movement from the time elapsed since the move started */
+	void StartNativeMove(float ElapsedTime);
+
+	/** Syncs the native movement on clients when the move start time replicates */
+	UFUNCTION()
+	void OnRep_MoveStartTime();
+
 };
@@ -0,0 +1,110 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SideScrollingPlatformMoverSubsystem.h"
+#include "SideScrollingMovingPlatform.h"
+#include "Components/SceneComponent.h"
+
+bool USideScrollingPlatformMoverSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USideScrollingPlatformMoverSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const int32 NumMoves = Platforms.Num();
+
+	// skip if nothing is moving
+	if (NumMoves == 0)
+	{
+		return;
+	}
+
+	// advance all the moves
+	for (int32 i = 0; i < NumMoves; ++i)
+	{
+		Alphas[i] = FMath::Min(Alphas[i] + Speeds[i] * DeltaTime, 1.0f);
+	}
+
+	// update the platform transforms. Teleport so physics doesn't derive velocities from the move
+	for (int32 i = 0; i < NumMoves; ++i)
+	{
+		const FVector NewLocation = FMath::InterpEaseInOut(StartLocations[i], EndLocations[i], Alphas[i], EaseExponents[i]);
+
+		Roots[i]->SetWorldLocation(NewLocation, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	// remove the finished moves
+	for (int32 i = NumMoves - 1; i >= 0; --i)
+	{
+		if (Alphas[i] >= 1.0f)
+		{
+			FinishedPlatforms.Add(Platforms[i]);
+			RemoveMoveAt(i);
+		}
+	}
+
+	// notify the platforms once we're done iterating, since they may start a new move
+	for (ASideScrollingMovingPlatform* Platform : FinishedPlatforms)
+	{
+		if (IsValid(Platform))
+		{
+			Platform->NativeMoveFinished();
+		}
+	}
+
+	FinishedPlatforms.Reset();
+}
+
+TStatId USideScrollingPlatformMoverSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USideScrollingPlatformMoverSubsystem, STATGROUP_Tickables);
+}
+
+void USideScrollingPlatformMoverSubsystem::StartMove(ASideScrollingMovingPlatform* Platform, const FVector& Start, const FVector& End, float Duration, float EaseExponent, float InitialAlpha)
+{
+	check(Platform && Platform->GetRootComponent());
+
+	int32 MoveIndex = Platforms.IndexOfByKey(Platform);
+
+	// add a new move if the platform isn't already moving
+	if (MoveIndex == INDEX_NONE)
+	{
+		MoveIndex = Platforms.Add(Platform);
+		Roots.Add(Platform->GetRootComponent());
+		StartLocations.AddUninitialized();
+		EndLocations.AddUninitialized();
+		Alphas.AddUninitialized();
+		Speeds.AddUninitialized();
+		EaseExponents.AddUninitialized();
+	}
+
+	StartLocations[MoveIndex] = Start;
+	EndLocations[MoveIndex] = End;
+	Alphas[MoveIndex] = FMath::Clamp(InitialAlpha, 0.0f, 1.0f);
+	Speeds[MoveIndex] = 1.0f / FMath::Max(Duration, UE_KINDA_SMALL_NUMBER);
+	EaseExponents[MoveIndex] = EaseExponent;
+}
+
+void USideScrollingPlatformMoverSubsystem::StopMove(ASideScrollingMovingPlatform* Platform)
+{
+	const int32 MoveIndex = Platforms.IndexOfByKey(Platform);
+
+	if (MoveIndex != INDEX_NONE)
+	{
+		RemoveMoveAt(MoveIndex);
+	}
+}
+
+void USideScrollingPlatformMoverSubsystem::RemoveMoveAt(int32 MoveIndex)
+{
+	Platforms.RemoveAtSwap(MoveIndex);
+	Roots.RemoveAtSwap(MoveIndex);
+	StartLocations.RemoveAtSwap(MoveIndex);
+	EndLocations.RemoveAtSwap(MoveIndex);
+	Alphas.RemoveAtSwap(MoveIndex);
+	Speeds.RemoveAtSwap(MoveIndex);
+	EaseExponents.RemoveAtSwap(MoveIndex);
+}
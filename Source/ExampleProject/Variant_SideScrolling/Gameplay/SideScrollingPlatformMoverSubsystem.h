@@ -0,0 +1,65 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SideScrollingPlatformMoverSubsystem.generated.h"
+
+class ASideScrollingMovingPlatform;
+class USceneComponent;
+
+/**
+ *  Moves all active side scrolling moving platforms natively in a single loop.
+ *  Platform moves are stored as parallel arrays and advanced together every tick,
+ *  instead of running one Blueprint timeline per platform.
+ */
+UCLASS()
+class USideScrollingPlatformMoverSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Platforms currently moving */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<ASideScrollingMovingPlatform>> Platforms;
+
+	/** Root components of the moving platforms */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<USceneComponent>> Roots;
+
+	/** Per-move state */
+	TArray<FVector> StartLocations;
+	TArray<FVector> EndLocations;
+	TArray<float> Alphas;
+	TArray<float> Speeds;
+	TArray<float> EaseExponents;
+
+	/** Scratch list of platforms that finished moving this tick */
+	TArray<ASideScrollingMovingPlatform*> FinishedPlatforms;
+
+public:
+
+	/** Only run in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Advances all active platform moves */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Starts or restarts a platform move from Start to End. InitialAlpha allows resuming a move partway through */
+	void StartMove(ASideScrollingMovingPlatform* Platform, const FVector& Start, const FVector& End, float Duration, float EaseExponent, float InitialAlpha = 0.0f);
+
+	/** Stops a platform move where it is */
+	void StopMove(ASideScrollingMovingPlatform* Platform);
+
+protected:
+
+	/** Removes the move at the provided index */
+	void RemoveMoveAt(int32 MoveIndex);
+};
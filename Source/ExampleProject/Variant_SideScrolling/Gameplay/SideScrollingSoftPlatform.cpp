@@ -5,11 +5,12 @@
 #include "Components/SceneComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "Components/BoxComponent.h"
-#include "SideScrollingCharacter.h"
+#include "SideScrollingSoftPlatformSubsystem.h"
+#include "Engine/World.h"
 
 ASideScrollingSoftPlatform::ASideScrollingSoftPlatform()
 {
- 	PrimaryActorTick.bCanEverTick = true;
+ 	PrimaryActorTick.bCanEverTick = false;
 
 	// create the root component
 	RootComponent = Root = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
@@ -22,38 +23,46 @@ ASideScrollingSoftPlatform::ASideScrollingSoftPlatform()
 	Mesh->SetCollisionObjectType(ECC_WorldStatic);
 	Mesh->SetCollisionResponseToAllChannels(ECR_Block);
 
-	// create the collision check box
+	// keep the deprecated collision check box so Blueprints that customized it still load, but without collision
 	CollisionCheckBox = CreateDefaultSubobject<UBoxComponent>(TEXT("Collision Check Box"));
 	CollisionCheckBox->SetupAttachment(Mesh);
 
-	CollisionCheckBox->SetRelativeLocation(FVector(0.0f, 0.0f, -40.0f));
-	CollisionCheckBox->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-	CollisionCheckBox->SetCollisionObjectType(ECC_WorldDynamic);
-	CollisionCheckBox->SetCollisionResponseToAllChannels(ECR_Ignore);
-	CollisionCheckBox->SetCollisionResponseToChannel(ECC_Pawn, ECR_Overlap);
-
-	// subscribe to the overlap events
-	CollisionCheckBox->OnComponentBeginOverlap.AddDynamic(this, &ASideScrollingSoftPlatform::OnSoftCollisionOverlap);
+	CollisionCheckBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	CollisionCheckBox->SetGenerateOverlapEvents(false);
 }
 
-void ASideScrollingSoftPlatform::OnSoftCollisionOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void ASideScrollingSoftPlatform::BeginPlay()
 {
-	// have we overlapped a character?
-	if (ASideScrollingCharacter* Char = Cast<ASideScrollingCharacter>(OtherActor))
+	Super::BeginPlay();
+
+	// register the platform span with the soft platform manager
+	if (USideScrollingSoftPlatformSubsystem* SoftPlatforms = GetWorld()->GetSubsystem<USideScrollingSoftPlatformSubsystem>())
 	{
-		// disable the soft collision channel
-		Char->SetSoftCollision(true);
+		SoftPlatforms->RegisterPlatform(this, Mesh->Bounds.GetBox());
 	}
+
+	// keep the span up to date if the platform moves
+	Mesh->TransformUpdated.AddUObject(this, &ASideScrollingSoftPlatform::OnMeshTransformUpdated);
 }
 
-void ASideScrollingSoftPlatform::NotifyActorEndOverlap(AActor* OtherActor)
+void ASideScrollingSoftPlatform::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
-	Super::NotifyActorEndOverlap(OtherActor);
+	Super::EndPlay(EndPlayReason);
 
-	// have we overlapped a character?
-	if (ASideScrollingCharacter* Char = Cast<ASideScrollingCharacter>(OtherActor))
+	Mesh->TransformUpdated.RemoveAll(this);
+
+	// remove the platform span from the soft platform manager
+	if (USideScrollingSoftPlatformSubsystem* SoftPlatforms = GetWorld()->GetSubsystem<USideScrollingSoftPlatformSubsystem>())
+	{
+		SoftPlatforms->UnregisterPlatform(this);
+	}
+}
+
+void ASideScrollingSoftPlatform::OnMeshTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	// the mesh bounds are already updated when the transform change is broadcast
+	if (USideScrollingSoftPlatformSubsystem* SoftPlatforms = GetWorld()->GetSubsystem<USideScrollingSoftPlatformSubsystem>())
 	{
-		// enable the soft collision channel
-		Char->SetSoftCollision(false);
+		SoftPlatforms->UpdatePlatform(this, Mesh->Bounds.GetBox());
 	}
 }
@@ -12,6 +12,8 @@ class UBoxComponent;
 
 /**
  *  A side scrolling game platform that the character can jump or drop through.
+ *  Pass-through is decided by the soft platform subsystem from the platform's mesh bounds,
+ *  which are updated whenever the mesh moves.
  */
 UCLASS(abstract)
 class ASideScrollingSoftPlatform : public AActor
@@ -26,8 +28,8 @@ class ASideScrollingSoftPlatform : public AActor
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category ="Components", meta = (AllowPrivateAccess = "true"))
 	UStaticMeshComponent* Mesh;
 
-	/** Collision volume that toggles soft collision on the character when they're below the platform. */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category ="Components", meta = (AllowPrivateAccess = "true"))
+	/** Deprecated collision volume that toggled soft collision on overlapping characters. Kept with its collision disabled so existing Blueprints still load */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category ="Components", meta = (AllowPrivateAccess = "true", DeprecatedProperty, DeprecationMessage = "Soft collision is decided by the soft platform subsystem from the mesh bounds. This box no longer has any effect"))
 	UBoxComponent* CollisionCheckBox;
 
 public:	
@@ -37,10 +39,12 @@ public:
 
 protected:
 
-	/** Handles soft collision check box overlaps */
-	UFUNCTION()
-	void OnSoftCollisionOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+	/** Registers the platform with the soft platform subsystem */
+	virtual void BeginPlay() override;
+
+	/** Unregisters the platform from the soft platform subsystem */
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 
-	/** Restores soft collision state when overlap ends */
-	virtual void NotifyActorEndOverlap(AActor* OtherActor) override;
+	/** Updates the platform span in the soft platform subsystem when the mesh moves */
+	void OnMeshTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
 };
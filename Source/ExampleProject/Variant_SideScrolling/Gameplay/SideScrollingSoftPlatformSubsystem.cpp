@@ -0,0 +1,246 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SideScrollingSoftPlatformSubsystem.h"
+#include "SideScrollingCharacter.h"
+#include "SideScrollingSoftPlatform.h"
+#include "Components/CapsuleComponent.h"
+
+void FSideScrollingIntervalTree::Build(TConstArrayView<float> InMinX, TConstArrayView<float> InMaxX)
+{
+	check(InMinX.Num() == InMaxX.Num());
+
+	const int32 Count = InMinX.Num();
+
+	// sort the span indices by their min X
+	SortedIndices.SetNumUninitialized(Count);
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		SortedIndices[i] = i;
+	}
+
+	SortedIndices.Sort([&InMinX](int32 A, int32 B) { return InMinX[A] < InMinX[B]; });
+
+	// copy the bounds in sorted order so queries walk contiguous memory
+	SortedMinX.SetNumUninitialized(Count);
+	SortedMaxX.SetNumUninitialized(Count);
+	SubtreeMaxX.SetNumUninitialized(Count);
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		SortedMinX[i] = InMinX[SortedIndices[i]];
+		SortedMaxX[i] = InMaxX[SortedIndices[i]];
+	}
+
+	BuildNode(0, Count);
+}
+
+float FSideScrollingIntervalTree::BuildNode(int32 Low, int32 High)
+{
+	if (Low >= High)
+	{
+		return -UE_BIG_NUMBER;
+	}
+
+	const int32 Mid = (Low + High) / 2;
+
+	SubtreeMaxX[Mid] = FMath::Max3(SortedMaxX[Mid], BuildNode(Low, Mid), BuildNode(Mid + 1, High));
+
+	return SubtreeMaxX[Mid];
+}
+
+bool USideScrollingSoftPlatformSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USideScrollingSoftPlatformSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// skip if there's nothing to manage
+	if (Characters.IsEmpty())
+	{
+		return;
+	}
+
+	UpdatePlatformTree();
+
+	for (int32 i = Characters.Num() - 1; i >= 0; --i)
+	{
+		FCharacterState& State = Characters[i];
+
+		ASideScrollingCharacter* Character = State.Character.Get();
+
+		// drop any characters that were destroyed without unregistering
+		if (!IsValid(Character))
+		{
+			Characters.RemoveAtSwap(i);
+			continue;
+		}
+
+		const FVector Location = Character->GetActorLocation();
+		const float HalfHeight = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+		const float Radius = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+
+		const float FeetZ = Location.Z - HalfHeight;
+
+		// look ahead by the upwards velocity so fast jumps don't hit the underside of a platform before we react
+		const float HeadZ = Location.Z + HalfHeight + FMath::Max(0.0, Character->GetVelocity().Z) * DeltaTime;
+
+		// end the drop once we've fallen below the platform
+		if (State.bDropping && FeetZ < State.DropReleaseZ)
+		{
+			State.bDropping = false;
+		}
+
+		bool bPassThrough = State.bDropping;
+
+		if (!bPassThrough)
+		{
+			// pass through if the capsule is under or inside any platform around us
+			PlatformTree.Query(Location.X - Radius, Location.X + Radius, [&](int32 PlatformIndex)
+			{
+				if (FeetZ < PlatformTopZ[PlatformIndex] - StandingTolerance && HeadZ >= PlatformBottomZ[PlatformIndex] - PassThroughMargin)
+				{
+					bPassThrough = true;
+				}
+			});
+		}
+
+		// only touch the collision response when the state changes
+		if (bPassThrough != State.bPassingThrough)
+		{
+			State.bPassingThrough = bPassThrough;
+			Character->SetSoftCollision(bPassThrough);
+		}
+	}
+}
+
+TStatId USideScrollingSoftPlatformSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USideScrollingSoftPlatformSubsystem, STATGROUP_Tickables);
+}
+
+void USideScrollingSoftPlatformSubsystem::RegisterPlatform(ASideScrollingSoftPlatform* Platform, const FBox& Bounds)
+{
+	Platforms.Add(Platform);
+	PlatformMinX.Add(Bounds.Min.X);
+	PlatformMaxX.Add(Bounds.Max.X);
+	PlatformTopZ.Add(Bounds.Max.Z);
+	PlatformBottomZ.Add(Bounds.Min.Z);
+
+	bTreeDirty = true;
+}
+
+void USideScrollingSoftPlatformSubsystem::UpdatePlatform(ASideScrollingSoftPlatform* Platform, const FBox& Bounds)
+{
+	const int32 PlatformIndex = Platforms.IndexOfByKey(Platform);
+
+	if (PlatformIndex != INDEX_NONE)
+	{
+		PlatformMinX[PlatformIndex] = Bounds.Min.X;
+		PlatformMaxX[PlatformIndex] = Bounds.Max.X;
+		PlatformTopZ[PlatformIndex] = Bounds.Max.Z;
+		PlatformBottomZ[PlatformIndex] = Bounds.Min.Z;
+
+		bTreeDirty = true;
+	}
+}
+
+void USideScrollingSoftPlatformSubsystem::UnregisterPlatform(ASideScrollingSoftPlatform* Platform)
+{
+	const int32 PlatformIndex = Platforms.IndexOfByKey(Platform);
+
+	if (PlatformIndex != INDEX_NONE)
+	{
+		Platforms.RemoveAtSwap(PlatformIndex);
+		PlatformMinX.RemoveAtSwap(PlatformIndex);
+		PlatformMaxX.RemoveAtSwap(PlatformIndex);
+		PlatformTopZ.RemoveAtSwap(PlatformIndex);
+		PlatformBottomZ.RemoveAtSwap(PlatformIndex);
+
+		bTreeDirty = true;
+	}
+}
+
+void USideScrollingSoftPlatformSubsystem::RegisterCharacter(ASideScrollingCharacter* Character)
+{
+	if (!FindCharacterState(Character))
+	{
+		FCharacterState& State = Characters.AddDefaulted_GetRef();
+		State.Character = Character;
+	}
+}
+
+void USideScrollingSoftPlatformSubsystem::UnregisterCharacter(ASideScrollingCharacter* Character)
+{
+	Characters.RemoveAllSwap([Character](const FCharacterState& State) { return State.Character == Character; });
+}
+
+bool USideScrollingSoftPlatformSubsystem::RequestDrop(ASideScrollingCharacter* Character, float MaxDistance)
+{
+	FCharacterState* State = FindCharacterState(Character);
+
+	if (!State)
+	{
+		return false;
+	}
+
+	UpdatePlatformTree();
+
+	const FVector Location = Character->GetActorLocation();
+	const float HalfHeight = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const float Radius = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+
+	const float FeetZ = Location.Z - HalfHeight;
+
+	// find the closest platform top below our feet
+	int32 FloorIndex = INDEX_NONE;
+
+	PlatformTree.Query(Location.X - Radius, Location.X + Radius, [&](int32 PlatformIndex)
+	{
+		const float TopZ = PlatformTopZ[PlatformIndex];
+
+		if (TopZ <= FeetZ + StandingTolerance && TopZ >= FeetZ - MaxDistance)
+		{
+			if (FloorIndex == INDEX_NONE || TopZ > PlatformTopZ[FloorIndex])
+			{
+				FloorIndex = PlatformIndex;
+			}
+		}
+	});
+
+	if (FloorIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// pass through until we're fully below the platform
+	State->bDropping = true;
+	State->DropReleaseZ = PlatformBottomZ[FloorIndex] - PassThroughMargin;
+
+	if (!State->bPassingThrough)
+	{
+		State->bPassingThrough = true;
+		Character->SetSoftCollision(true);
+	}
+
+	return true;
+}
+
+void USideScrollingSoftPlatformSubsystem::UpdatePlatformTree()
+{
+	if (bTreeDirty)
+	{
+		bTreeDirty = false;
+
+		PlatformTree.Build(PlatformMinX, PlatformMaxX);
+	}
+}
+
+USideScrollingSoftPlatformSubsystem::FCharacterState* USideScrollingSoftPlatformSubsystem::FindCharacterState(const ASideScrollingCharacter* Character)
+{
+	return Characters.FindByPredicate([Character](const FCharacterState& State) { return State.Character == Character; });
+}
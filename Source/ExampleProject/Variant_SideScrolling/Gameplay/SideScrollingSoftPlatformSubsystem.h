@@ -0,0 +1,167 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SideScrollingSoftPlatformSubsystem.generated.h"
+
+class ASideScrollingCharacter;
+class ASideScrollingSoftPlatform;
+
+/**
+ *  Static 1D interval tree over spans along the side scrolling X axis.
+ *  Spans are sorted by their min X and stored as an implicit balanced tree,
+ *  where each node also keeps the max X of its whole subtree to prune queries.
+ */
+struct FSideScrollingIntervalTree
+{
+	/** Rebuilds the tree from the provided span bounds. Both arrays must have the same length */
+	void Build(TConstArrayView<float> InMinX, TConstArrayView<float> InMaxX);
+
+	/** Calls Visit with the index of every span that overlaps the [QueryMinX, QueryMaxX] range */
+	template<typename VisitorType>
+	void Query(float QueryMinX, float QueryMaxX, VisitorType&& Visit) const
+	{
+		QueryNode(0, SortedIndices.Num(), QueryMinX, QueryMaxX, Visit);
+	}
+
+private:
+
+	/** Computes the subtree max for the [Low, High) range. Returns the result */
+	float BuildNode(int32 Low, int32 High);
+
+	/** Recursively visits the overlapping spans in the [Low, High) range */
+	template<typename VisitorType>
+	void QueryNode(int32 Low, int32 High, float QueryMinX, float QueryMaxX, VisitorType& Visit) const
+	{
+		if (Low >= High)
+		{
+			return;
+		}
+
+		const int32 Mid = (Low + High) / 2;
+
+		// nothing in this subtree reaches the query range
+		if (SubtreeMaxX[Mid] < QueryMinX)
+		{
+			return;
+		}
+
+		QueryNode(Low, Mid, QueryMinX, QueryMaxX, Visit);
+
+		// spans are sorted by min X, so if this one starts past the range, so does everything to its right
+		if (SortedMinX[Mid] > QueryMaxX)
+		{
+			return;
+		}
+
+		if (SortedMaxX[Mid] >= QueryMinX)
+		{
+			Visit(SortedIndices[Mid]);
+		}
+
+		QueryNode(Mid + 1, High, QueryMinX, QueryMaxX, Visit);
+	}
+
+	/** Span indices sorted by min X */
+	TArray<int32> SortedIndices;
+
+	/** Span bounds in sorted order */
+	TArray<float> SortedMinX;
+	TArray<float> SortedMaxX;
+
+	/** Max X of the subtree rooted at each sorted position */
+	TArray<float> SubtreeMaxX;
+};
+
+/**
+ *  Manages soft platform collision for side scrolling characters without overlap volumes or traces.
+ *  Soft platforms register their spans along the X axis, which are kept in an interval tree.
+ *  Every tick, each registered character checks the platforms around it and decides analytically
+ *  from its position and velocity whether it should pass through or stand on them.
+ */
+UCLASS()
+class USideScrollingSoftPlatformSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	/** Soft platform bounds, stored as parallel arrays so the tree can be rebuilt quickly */
+	TArray<TWeakObjectPtr<ASideScrollingSoftPlatform>> Platforms;
+	TArray<float> PlatformMinX;
+	TArray<float> PlatformMaxX;
+	TArray<float> PlatformTopZ;
+	TArray<float> PlatformBottomZ;
+
+	/** Interval tree over the platform X spans */
+	FSideScrollingIntervalTree PlatformTree;
+
+	/** If true, platforms were added, moved or removed since the tree was last built */
+	bool bTreeDirty = false;
+
+	/** Soft collision state tracked for each registered character */
+	struct FCharacterState
+	{
+		/** Character being tracked */
+		TWeakObjectPtr<ASideScrollingCharacter> Character;
+
+		/** Height the character must fall below before a requested drop ends */
+		float DropReleaseZ = 0.0f;
+
+		/** If true, the character is dropping through a platform it was standing on */
+		bool bDropping = false;
+
+		/** If true, the character currently ignores the soft collision channel */
+		bool bPassingThrough = false;
+	};
+
+	/** Registered characters */
+	TArray<FCharacterState> Characters;
+
+	/** Vertical distance below a platform where upwards moving characters start passing through it */
+	float PassThroughMargin = 40.0f;
+
+	/** Vertical tolerance when deciding if a character is standing on top of a platform */
+	float StandingTolerance = 10.0f;
+
+public:
+
+	/** Only run in game worlds */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Updates the soft collision state of all registered characters */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Returns the stat ID for this tickable */
+	virtual TStatId GetStatId() const override;
+
+public:
+
+	/** Adds a soft platform spanning the provided world space bounds */
+	void RegisterPlatform(ASideScrollingSoftPlatform* Platform, const FBox& Bounds);
+
+	/** Updates the bounds of a registered soft platform that moved. Moving platforms rebuild the tree on the next tick */
+	void UpdatePlatform(ASideScrollingSoftPlatform* Platform, const FBox& Bounds);
+
+	/** Removes a soft platform */
+	void UnregisterPlatform(ASideScrollingSoftPlatform* Platform);
+
+	/** Starts tracking soft collision for a character */
+	void RegisterCharacter(ASideScrollingCharacter* Character);
+
+	/** Stops tracking soft collision for a character */
+	void UnregisterCharacter(ASideScrollingCharacter* Character);
+
+	/** Drops the character through the closest soft platform below it, within the max distance. Returns true if a platform was found */
+	bool RequestDrop(ASideScrollingCharacter* Character, float MaxDistance);
+
+protected:
+
+	/** Rebuilds the interval tree if any platforms changed */
+	void UpdatePlatformTree();
+
+	/** Returns the tracked state for a character, or nullptr if it's not registered */
+	FCharacterState* FindCharacterState(const ASideScrollingCharacter* Character);
+};
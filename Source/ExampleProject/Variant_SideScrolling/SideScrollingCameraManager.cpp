@@ -6,9 +6,19 @@
 #include "Engine/HitResult.h"
 #include "CollisionQueryParams.h"
 #include "Engine/World.h"
+#include "Engine/GameViewportClient.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
 
 void ASideScrollingCameraManager::UpdateViewTarget(FTViewTarget& OutVT, float DeltaTime)
 {
+	// frame all players if we're sharing the screen and there's more than one to frame
+	if (ShouldFrameAllPlayers() && GatherFramingTargets() > 1)
+	{
+		UpdateMultiTargetView(OutVT, DeltaTime);
+		return;
+	}
+
 	// ensure the view target is a pawn
 	APawn* TargetPawn = Cast<APawn>(OutVT.Target);
 
@@ -16,8 +26,8 @@ void ASideScrollingCameraManager::UpdateViewTarget(FTViewTarget& OutVT, float De
 	if (IsValid(TargetPawn))
 	{
 		// set the view target FOV and rotation
-		OutVT.POV.Rotation = FRotator(0.0f, -90.0f, 0.0f);
-		OutVT.POV.FOV = 65.0f;
+		OutVT.POV.Rotation = CameraRotation;
+		OutVT.POV.FOV = CameraFOV;
 
 		// cache the current location
 		FVector CurrentActorLocation = OutVT.Target->GetActorLocation();
@@ -42,6 +52,9 @@ void ASideScrollingCameraManager::UpdateViewTarget(FTViewTarget& OutVT, float De
 			// save the current camera height
 			CurrentZ = OutVT.POV.Location.Z;
 
+			// start the camera simulation from rest
+			ResetCameraSimulation(OutVT.POV.Location);
+
 			// skip the rest of the calculations
 			return;
 		}
@@ -70,6 +83,9 @@ void ASideScrollingCameraManager::UpdateViewTarget(FTViewTarget& OutVT, float De
 
 		}
 
+		// if true, the height will blend towards the actor location instead of snapping to it
+		bool bBlendHeight = false;
+
 		// do we need to do a height update?
 		if (bZUpdate)
 		{
@@ -87,8 +103,8 @@ void ASideScrollingCameraManager::UpdateViewTarget(FTViewTarget& OutVT, float De
 
 			} else {
 
-				// blend the height towards the actor location
-				CurrentZ = FMath::FInterpTo(CurrentZ, CurrentActorLocation.Z, DeltaTime, 2.0f);
+				// blend the height towards the actor location during the simulation steps
+				bBlendHeight = true;
 				
 			}
 
@@ -98,8 +114,224 @@ void ASideScrollingCameraManager::UpdateViewTarget(FTViewTarget& OutVT, float De
 		float CurrentX = FMath::Clamp(CurrentActorLocation.X, CameraXMinBounds, CameraXMaxBounds);
 
 		// blend towards the new camera location and update the output
-		FVector TargetCameraLocation(CurrentX, CurrentY, CurrentZ);
+		OutVT.POV.Location = UpdateCameraSimulation(CurrentX, CurrentY, CurrentActorLocation.Z, bBlendHeight, DeltaTime);
+	}
+}
+
+bool ASideScrollingCameraManager::ShouldFrameAllPlayers() const
+{
+	if (!bFrameAllPlayers)
+	{
+		return false;
+	}
+
+	// in split-screen, each viewport's camera manager frames its own view target
+	if (const UGameViewportClient* ViewportClient = GetWorld()->GetGameViewport())
+	{
+		return ViewportClient->GetCurrentSplitscreenConfiguration() == ESplitScreenType::None;
+	}
+
+	return true;
+}
+
+int32 ASideScrollingCameraManager::GatherFramingTargets()
+{
+	NumFramingTargets = 0;
+
+	// use the game state player list so this also works on clients, where remote player controllers don't exist
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
 
-		OutVT.POV.Location = FMath::VInterpTo(CurrentCameraLocation, TargetCameraLocation, DeltaTime, 2.0f);
+	if (!GameState)
+	{
+		return 0;
 	}
-}
\ No newline at end of file
+
+	for (const APlayerState* PlayerState : GameState->PlayerArray)
+	{
+		// ignore any players past the framing limit
+		if (NumFramingTargets == MaxFramingTargets)
+		{
+			break;
+		}
+
+		const APawn* PlayerPawn = PlayerState ? PlayerState->GetPawn() : nullptr;
+
+		if (IsValid(PlayerPawn))
+		{
+			const FVector PawnLocation = PlayerPawn->GetActorLocation();
+
+			FramingX[NumFramingTargets] = static_cast<float>(PawnLocation.X);
+			FramingY[NumFramingTargets] = static_cast<float>(PawnLocation.Y);
+			FramingZ[NumFramingTargets] = static_cast<float>(PawnLocation.Z);
+
+			++NumFramingTargets;
+		}
+	}
+
+	return NumFramingTargets;
+}
+
+void ASideScrollingCameraManager::ComputeFramingBounds(FVector& OutCenter, FVector2D& OutHalfExtent) const
+{
+	check(NumFramingTargets > 0);
+
+	static_assert(MaxFramingTargets == 8, "Framing bounds reduction expects two 4-wide registers per axis");
+
+	// copy the buffers and pad the unused lanes with the first target so they don't affect the bounds
+	float PaddedX[MaxFramingTargets];
+	float PaddedZ[MaxFramingTargets];
+
+	float SumY = 0.0f;
+
+	for (int32 i = 0; i < MaxFramingTargets; ++i)
+	{
+		const int32 Source = i < NumFramingTargets ? i : 0;
+
+		PaddedX[i] = FramingX[Source];
+		PaddedZ[i] = FramingZ[Source];
+
+		SumY += i < NumFramingTargets ? FramingY[i] : 0.0f;
+	}
+
+	// reduce eight lanes down to a single value by folding the two registers, then the register halves
+	auto ReduceMin = [](const float* Lanes)
+	{
+		VectorRegister4Float Result = VectorMin(VectorLoad(Lanes), VectorLoad(Lanes + 4));
+		Result = VectorMin(Result, VectorSwizzle(Result, 2, 3, 0, 1));
+		Result = VectorMin(Result, VectorSwizzle(Result, 1, 0, 3, 2));
+		return VectorGetComponent(Result, 0);
+	};
+
+	auto ReduceMax = [](const float* Lanes)
+	{
+		VectorRegister4Float Result = VectorMax(VectorLoad(Lanes), VectorLoad(Lanes + 4));
+		Result = VectorMax(Result, VectorSwizzle(Result, 2, 3, 0, 1));
+		Result = VectorMax(Result, VectorSwizzle(Result, 1, 0, 3, 2));
+		return VectorGetComponent(Result, 0);
+	};
+
+	const float MinX = ReduceMin(PaddedX);
+	const float MaxX = ReduceMax(PaddedX);
+	const float MinHeight = ReduceMin(PaddedZ);
+	const float MaxHeight = ReduceMax(PaddedZ);
+
+	OutCenter = FVector((MinX + MaxX) * 0.5f, SumY / NumFramingTargets, (MinHeight + MaxHeight) * 0.5f);
+	OutHalfExtent = FVector2D((MaxX - MinX) * 0.5f, (MaxHeight - MinHeight) * 0.5f);
+}
+
+void ASideScrollingCameraManager::UpdateMultiTargetView(FTViewTarget& OutVT, float DeltaTime)
+{
+	// set the view target FOV and rotation
+	OutVT.POV.Rotation = CameraRotation;
+	OutVT.POV.FOV = CameraFOV;
+
+	// find the box enclosing all players
+	FVector FramingCenter;
+	FVector2D FramingHalfExtent;
+
+	ComputeFramingBounds(FramingCenter, FramingHalfExtent);
+
+	// pull the camera back far enough to fit the box horizontally and vertically
+	const float AspectRatio = OutVT.POV.AspectRatio > 0.0f ? OutVT.POV.AspectRatio : 16.0f / 9.0f;
+	const float HalfWidth = FMath::Max(FramingHalfExtent.X, FramingHalfExtent.Y * AspectRatio) + FramingPadding;
+	const float FramingZoom = FMath::Clamp(HalfWidth / FMath::Tan(FMath::DegreesToRadians(CameraFOV * 0.5f)), CurrentZoom, FMath::Max(CurrentZoom, MaxFramingZoom));
+
+	const float CurrentY = FramingCenter.Y + FramingZoom;
+
+	// do first-time setup
+	if (bSetup)
+	{
+		// lower the setup flag
+		bSetup = false;
+
+		// initialize the camera viewpoint and return
+		OutVT.POV.Location = FVector(FramingCenter.X, CurrentY, FramingCenter.Z + CameraZOffset);
+
+		// save the current camera height
+		CurrentZ = OutVT.POV.Location.Z;
+
+		// start the camera simulation from rest
+		ResetCameraSimulation(OutVT.POV.Location);
+
+		return;
+	}
+
+	// clamp the X axis to the min and max camera bounds
+	const float CurrentX = FMath::Clamp(FramingCenter.X, CameraXMinBounds, CameraXMaxBounds);
+
+	// blend towards the new camera location, with the height following the center of the group
+	OutVT.POV.Location = UpdateCameraSimulation(CurrentX, CurrentY, FramingCenter.Z, true, DeltaTime);
+}
+
+void ASideScrollingCameraManager::ResetCameraSimulation(const FVector& Location)
+{
+	SimulationTimeAccumulator = 0.0f;
+
+	PreviousSimulatedLocation = Location;
+	SimulatedLocation = Location;
+	SimulatedVelocity = FVector::ZeroVector;
+}
+
+FVector ASideScrollingCameraManager::UpdateCameraSimulation(float GoalX, float GoalY, float HeightGoal, bool bBlendHeight, float DeltaTime)
+{
+	const float StepTime = 1.0f / SimulationRate;
+
+	// accumulate the frame time
+	SimulationTimeAccumulator += DeltaTime;
+
+	// run as many fixed steps as the accumulated time allows
+	int32 StepCount = 0;
+
+	while (SimulationTimeAccumulator >= StepTime)
+	{
+		SimulationTimeAccumulator -= StepTime;
+
+		// after a long hitch, drop the remaining time instead of spiralling
+		if (++StepCount > MaxSimulationSteps)
+		{
+			SimulationTimeAccumulator = 0.0f;
+			break;
+		}
+
+		// keep the last step so we can interpolate between them
+		PreviousSimulatedLocation = SimulatedLocation;
+
+		// blend the height goal towards the target height
+		if (bBlendHeight)
+		{
+			CurrentZ = FMath::FInterpTo(CurrentZ, HeightGoal, StepTime, 2.0f);
+		}
+
+		const FVector GoalLocation(GoalX, GoalY, CurrentZ);
+
+		if (bUseSpringSmoothing)
+		{
+			SimulatedLocation = StepCriticallyDampedSpring(SimulatedLocation, SimulatedVelocity, GoalLocation, SpringSmoothTime, StepTime);
+
+		} else {
+
+			SimulatedLocation = FMath::VInterpTo(SimulatedLocation, GoalLocation, StepTime, 2.0f);
+
+		}
+	}
+
+	// interpolate between the last two steps using the leftover time
+	const float Alpha = FMath::Clamp(SimulationTimeAccumulator / StepTime, 0.0f, 1.0f);
+
+	return FMath::Lerp(PreviousSimulatedLocation, SimulatedLocation, Alpha);
+}
+
+FVector ASideScrollingCameraManager::StepCriticallyDampedSpring(const FVector& Current, FVector& Velocity, const FVector& Goal, float SmoothTime, float DeltaTime)
+{
+	// angular frequency of a spring that settles in roughly SmoothTime
+	const float Omega = 2.0f / FMath::Max(SmoothTime, UE_KINDA_SMALL_NUMBER);
+	const float Decay = FMath::Exp(-Omega * DeltaTime);
+
+	// closed-form critically damped solution for the offset from the goal
+	const FVector Offset = Current - Goal;
+	const FVector Temp = (Velocity + Omega * Offset) * DeltaTime;
+
+	Velocity = (Velocity - Omega * Temp) * Decay;
+
+	return Goal + (Offset + Temp) * Decay;
+}
@@ -8,12 +8,17 @@
 
 /**
  *  Simple side scrolling camera with smooth scrolling and horizontal bounds
+ *  Can optionally frame every player in the game for shared-screen co-op.
+ *  Each split-screen viewport runs its own camera manager and frames only its own view target.
  */
 UCLASS()
 class ASideScrollingCameraManager : public APlayerCameraManager
 {
 	GENERATED_BODY()
-	
+
+	/** The automation test replays pawn paths through the camera simulation directly */
+	friend class FSideScrollingCameraFrameRateTest;
+
 public:
 
 	/** Overrides the default camera view target calculation */
@@ -21,6 +26,9 @@ public:
 
 public:
 
+	/** Max number of players the shared camera can frame at once */
+	static constexpr int32 MaxFramingTargets = 8;
+
 	/** How close we want to stay to the view target */
 	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera", meta=(ClampMin=0, ClampMax=10000, Units="cm"))
 	float CurrentZoom = 1000.0f;
@@ -37,6 +45,65 @@ public:
 	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera", meta=(ClampMin=-100000, ClampMax=100000, Units="cm"))
 	float CameraXMaxBounds = 10000.0f;
 
+	/** Fixed camera rotation. Looks down the side scrolling plane by default */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera")
+	FRotator CameraRotation = FRotator(0.0f, -90.0f, 0.0f);
+
+	/** Camera horizontal field of view */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera", meta=(ClampMin=5, ClampMax=170, Units="deg"))
+	float CameraFOV = 65.0f;
+
+	/** If true, the camera frames all player pawns instead of only the view target. Ignored while in split-screen */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera|Multi Target")
+	bool bFrameAllPlayers = false;
+
+	/** Extra space to keep between the framed players and the edges of the screen */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera|Multi Target", meta=(ClampMin=0, ClampMax=10000, Units="cm"))
+	float FramingPadding = 300.0f;
+
+	/** Max distance the camera can pull back to keep all players in view */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera|Multi Target", meta=(ClampMin=0, ClampMax=100000, Units="cm"))
+	float MaxFramingZoom = 3000.0f;
+
+	/** Fixed rate the camera smoothing is simulated at, independent of the frame rate */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera|Smoothing", meta=(ClampMin=10, ClampMax=1000, Units="Hz"))
+	float SimulationRate = 120.0f;
+
+	/** Max number of simulation steps to run in a single frame. Time past this limit is dropped to recover from hitches */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera|Smoothing", meta=(ClampMin=1, ClampMax=1000))
+	int32 MaxSimulationSteps = 30;
+
+	/** If true, the camera follows its goal with a critically damped spring. Otherwise it uses exponential interpolation */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera|Smoothing")
+	bool bUseSpringSmoothing = true;
+
+	/** Approximate time for the spring to catch up with its goal */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling Camera|Smoothing", meta=(ClampMin=0.01, ClampMax=10, Units="s", EditCondition="bUseSpringSmoothing"))
+	float SpringSmoothTime = 0.5f;
+
+protected:
+
+	/** Returns true if this camera should frame all players instead of its own view target */
+	bool ShouldFrameAllPlayers() const;
+
+	/** Copies the locations of all player pawns into the framing buffers. Returns the number of targets found */
+	int32 GatherFramingTargets();
+
+	/** Reduces the framing buffers into a bounding box center and half extents on the XZ plane */
+	void ComputeFramingBounds(FVector& OutCenter, FVector2D& OutHalfExtent) const;
+
+	/** Updates the camera so it frames all gathered targets */
+	void UpdateMultiTargetView(FTViewTarget& OutVT, float DeltaTime);
+
+	/** Snaps the camera simulation to the provided location and clears its velocity */
+	void ResetCameraSimulation(const FVector& Location);
+
+	/** Advances the camera simulation in fixed steps towards the goal and returns the camera location interpolated between the last two steps */
+	FVector UpdateCameraSimulation(float GoalX, float GoalY, float HeightGoal, bool bBlendHeight, float DeltaTime);
+
+	/** Moves a value towards a goal with a critically damped spring over a single time step. Updates the velocity in place */
+	static FVector StepCriticallyDampedSpring(const FVector& Current, FVector& Velocity, const FVector& Goal, float SmoothTime, float DeltaTime);
+
 protected:
 
 	/** Last cached camera vertical location. The camera only adjusts its height if necessary. */
@@ -44,4 +111,24 @@ protected:
 
 	/** First-time update camera setup flag */
 	bool bSetup = true;
+
+	/** Framing target locations, stored as separate component arrays so the bounds can be reduced four lanes at a time */
+	float FramingX[MaxFramingTargets];
+	float FramingY[MaxFramingTargets];
+	float FramingZ[MaxFramingTargets];
+
+	/** Number of valid entries in the framing buffers */
+	int32 NumFramingTargets = 0;
+
+	/** Frame time not yet consumed by a camera simulation step */
+	float SimulationTimeAccumulator = 0.0f;
+
+	/** Camera location at the previous simulation step */
+	FVector PreviousSimulatedLocation = FVector::ZeroVector;
+
+	/** Camera location at the latest simulation step */
+	FVector SimulatedLocation = FVector::ZeroVector;
+
+	/** Current camera spring velocity */
+	FVector SimulatedVelocity = FVector::ZeroVector;
 };
@@ -2,7 +2,7 @@
 
 
 #include "SideScrollingCharacter.h"
-#include "GameFramework/CharacterMovementComponent.h"
+#include "PlatformingMovementComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Camera/CameraComponent.h"
 #include "Components/InputComponent.h"
@@ -11,10 +11,10 @@
 #include "InputAction.h"
 #include "Engine/World.h"
 #include "SideScrollingInteractable.h"
-#include "Kismet/KismetMathLibrary.h"
-#include "TimerManager.h"
+#include "SideScrollingSoftPlatformSubsystem.h"
 
-ASideScrollingCharacter::ASideScrollingCharacter()
+ASideScrollingCharacter::ASideScrollingCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UPlatformingMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -55,16 +55,41 @@ ASideScrollingCharacter::ASideScrollingCharacter()
 	GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0.0f, 1.0f, 0.0f));
 	GetCharacterMovement()->bConstrainToPlane = true;
 
+	// walls are traced with a line in the direction of the movement input
+	GetPlatformingMovement()->WallJumpTraceRadius = 0.0f;
+	GetPlatformingMovement()->bWallJumpRequiresInput = true;
+
 	// enable double jump and coyote time
 	JumpMaxCount = 3;
 }
 
+void ASideScrollingCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// pass the wall jump and coyote time settings to the movement component, so Blueprint overrides apply
+	GetPlatformingMovement()->WallJumpTraceDistance = WallJumpTraceDistance;
+	GetPlatformingMovement()->WallJumpHorizontalSpeed = WallJumpHorizontalImpulse;
+	GetPlatformingMovement()->WallJumpVerticalSpeed = GetCharacterMovement()->JumpZVelocity * WallJumpVerticalMultiplier;
+	GetPlatformingMovement()->DelayBetweenWallJumps = DelayBetweenWallJumps;
+	GetPlatformingMovement()->MaxCoyoteTime = MaxCoyoteTime;
+
+	// let the soft platform manager handle our soft collision
+	if (USideScrollingSoftPlatformSubsystem* SoftPlatforms = GetWorld()->GetSubsystem<USideScrollingSoftPlatformSubsystem>())
+	{
+		SoftPlatforms->RegisterCharacter(this);
+	}
+}
+
 void ASideScrollingCharacter::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
-	// clear the wall jump timer
-	GetWorld()->GetTimerManager().ClearTimer(WallJumpTimer);
+	// stop soft collision management
+	if (USideScrollingSoftPlatformSubsystem* SoftPlatforms = GetWorld()->GetSubsystem<USideScrollingSoftPlatformSubsystem>())
+	{
+		SoftPlatforms->UnregisterCharacter(this);
+	}
 }
 
 void ASideScrollingCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
@@ -115,24 +140,6 @@ void ASideScrollingCharacter::NotifyHit(class UPrimitiveComponent* MyComp, AActo
 	}
 }
 
-void ASideScrollingCharacter::Landed(const FHitResult& Hit)
-{
-	// reset the double jump
-	bHasDoubleJumped = false;
-}
-
-void ASideScrollingCharacter::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode /*= 0*/)
-{
-	Super::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
-
-	// are we falling?
-	if (GetCharacterMovement()->MovementMode == EMovementMode::MOVE_Falling)
-	{
-		// save the game time when we started falling, so we can check it later for coyote time jumps
-		LastFallTime = GetWorld()->GetTimeSeconds();
-	}
-}
-
 void ASideScrollingCharacter::Move(const FInputActionValue& Value)
 {
 	FVector2D MoveVector = Value.Get<FVector2D>();
@@ -156,7 +163,7 @@ void ASideScrollingCharacter::DropReleased(const FInputActionValue& Value)
 void ASideScrollingCharacter::DoMove(float Forward)
 {
 	// is movement temporarily disabled after wall jumping?
-	if (!bHasWallJumped)
+	if (!GetPlatformingMovement()->HasWallJumped())
 	{
 		// save the movement values
 		ActionValueY = Forward;
@@ -234,70 +241,8 @@ void ASideScrollingCharacter::MultiJump()
 		return;
 	}
 
-	// if we have a horizontal input, try for wall jump first
-	if (!bHasWallJumped && !FMath::IsNearlyZero(ActionValueY))
-	{
-		// trace ahead of the character for walls
-		FHitResult OutHit;
-
-		const FVector Start = GetActorLocation();
-		const FVector End = Start + (FVector(ActionValueY > 0.0f ? 1.0f : -1.0f, 0.0f, 0.0f) * WallJumpTraceDistance);
-
-		FCollisionQueryParams QueryParams;
-		QueryParams.AddIgnoredActor(this);
-
-		GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, ECC_Visibility, QueryParams);
-
-		if (OutHit.bBlockingHit)
-		{
-			// rotate to the bounce direction
-			const FRotator BounceRot = UKismetMathLibrary::MakeRotFromX(OutHit.ImpactNormal);
-			SetActorRotation(FRotator(0.0f, BounceRot.Yaw, 0.0f));
-
-			// calculate the impulse vector
-			FVector WallJumpImpulse = OutHit.ImpactNormal * WallJumpHorizontalImpulse;
-			WallJumpImpulse.Z = GetCharacterMovement()->JumpZVelocity * WallJumpVerticalMultiplier;
-
-			// launch the character away from the wall
-			LaunchCharacter(WallJumpImpulse, true, true);
-
-			// enable wall jump lockout for a bit
-			bHasWallJumped = true;
-
-			// schedule wall jump lockout reset
-			GetWorld()->GetTimerManager().SetTimer(WallJumpTimer, this, &ASideScrollingCharacter::ResetWallJump, DelayBetweenWallJumps, false);
-
-			return;
-		}
-	}
-
-
-
-	// test for double jump only if we haven't already tested for wall jump
-	if (!bHasWallJumped)
-	{
-		// are we still within coyote time frames?
-		if (GetWorld()->GetTimeSeconds() - LastFallTime < MaxCoyoteTime)
-		{
-			UE_LOG(LogTemp, Warning, TEXT("Coyote Jump"));
-
-			// use the built-in CMC functionality to do the jump
-			Jump();
-
-		// no coyote time jump
-		} else {
-		
-			// The movement component handles double jump but we still need to manage the flag for animation
-			if (!bHasDoubleJumped)
-			{
-				// raise the double jump flag
-				bHasDoubleJumped = true;
-
-				// let the CMC handle jump
-				Jump();
-			}
-		}
-	}
+	// let the movement component decide between a wall jump, coyote time jump or double jump as part of a predicted move
+	GetPlatformingMovement()->RequestAirJump();
 }
 
 void ASideScrollingCharacter::CheckForSoftCollision()
@@ -305,34 +250,13 @@ void ASideScrollingCharacter::CheckForSoftCollision()
 	// reset the drop value
 	DropValue = 0.0f;
 
-	// trace down 
-	FHitResult OutHit;
-
-	const FVector Start = GetActorLocation();
-	const FVector End = Start + (FVector::DownVector * SoftCollisionTraceDistance);
-
-	FCollisionObjectQueryParams ObjectParams;
-	ObjectParams.AddObjectTypesToQuery(SoftCollisionObjectType);
-
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(this);
-
-	GetWorld()->LineTraceSingleByObjectType(OutHit, Start, End, ObjectParams, QueryParams);
-
-	// did we hit a soft floor?
-	if (OutHit.GetActor())
+	// ask the soft platform manager to drop us through the floor, if it's a soft platform
+	if (USideScrollingSoftPlatformSubsystem* SoftPlatforms = GetWorld()->GetSubsystem<USideScrollingSoftPlatformSubsystem>())
 	{
-		// drop through the floor
-		SetSoftCollision(true);
+		SoftPlatforms->RequestDrop(this, SoftCollisionTraceDistance);
 	}
 }
 
-void ASideScrollingCharacter::ResetWallJump()
-{
-	// reset the wall jump flag
-	bHasWallJumped = false;
-}
-
 void ASideScrollingCharacter::SetSoftCollision(bool bEnabled)
 {
 	// enable or disable collision response to the soft collision channel
@@ -341,10 +265,15 @@ void ASideScrollingCharacter::SetSoftCollision(bool bEnabled)
 
 bool ASideScrollingCharacter::HasDoubleJumped() const
 {
-	return bHasDoubleJumped;
+	return GetPlatformingMovement()->HasDoubleJumped();
 }
 
 bool ASideScrollingCharacter::HasWallJumped() const
 {
-	return bHasWallJumped;
+	return GetPlatformingMovement()->HasWallJumped();
+}
+
+UPlatformingMovementComponent* ASideScrollingCharacter::GetPlatformingMovement() const
+{
+	return GetCharacterMovement<UPlatformingMovementComponent>();
 }
@@ -9,6 +9,7 @@
 class UCameraComponent;
 class UInputAction;
 struct FInputActionValue;
+class UPlatformingMovementComponent;
 
 /**
  *  A player-controllable character side scrolling game
@@ -64,46 +65,37 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Side Scrolling|Wall Jump")
 	float WallJumpVerticalMultiplier = 1.4f;
 
-	/** Collision object type to use for soft collision traces (dropping down floors) */
+	/** Max amount of time that can pass since we started falling when we allow a regular jump */
+	UPROPERTY(EditAnywhere, Category="Side Scrolling|Coyote Time", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
+	float MaxCoyoteTime = 0.16f;
+
+	/** Collision object type used by soft platforms (dropping down floors) */
 	UPROPERTY(EditAnywhere, Category="Side Scrolling|Soft Platforms")
 	TEnumAsByte<ECollisionChannel> SoftCollisionObjectType;
 
-	/** Distance to trace down during soft collision checks */
+	/** Max distance below the character to look for a soft platform to drop through */
 	UPROPERTY(EditAnywhere, Category="Side Scrolling|Soft Platforms")
 	float SoftCollisionTraceDistance = 1000.0f;
 
-	/** Last recorded time when this character started falling */
-	float LastFallTime = 0.0f;
-
-	/** Max amount of time that can pass since we started falling when we allow a regular jump */
-	UPROPERTY(EditAnywhere, Category="Side Scrolling|Coyote Time", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
-	float MaxCoyoteTime = 0.16f;
-
-	/** Wall jump lockout timer */
-	FTimerHandle WallJumpTimer;
-
 	/** Last captured horizontal movement input value */
 	float ActionValueY = 0.0f;
 
 	/** Last captured platform drop axis value */
 	float DropValue = 0.0f;
 
-	/** If true, this character has already wall jumped */
-	bool bHasWallJumped = false;
-
-	/** If true, this character has already double jumped */
-	bool bHasDoubleJumped = false;
-
 	/** If true, this character is moving along the side scrolling axis */
 	bool bMovingHorizontally = false;
 
 public:
 	
-	/** Constructor */
-	ASideScrollingCharacter();
+	/** Constructor. Replaces the default movement component with the platforming movement component */
+	ASideScrollingCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 
+	/** Gameplay initialization */
+	virtual void BeginPlay() override;
+
 	/** Gameplay cleanup */
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 
@@ -113,12 +105,6 @@ protected:
 	/** Collision handling */
 	virtual void NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit) override;
 
-	/** Landing handling */
-	virtual void Landed(const FHitResult& Hit) override;
-
-	/** Handle movement mode changes to keep track of coyote time jumps */
-	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
-
 protected:
 
 	/** Called for movement input */
@@ -160,9 +146,6 @@ protected:
 	/** Checks for soft collision with platforms */
 	void CheckForSoftCollision();
 
-	/** Resets wall jump lockout. Called from timer after a wall jump */
-	void ResetWallJump();
-
 public:
 
 	/** Sets the soft collision response. True passes, False blocks */
@@ -177,4 +160,7 @@ public:
 	/** Returns true if the character has just wall jumped */
 	UFUNCTION(BlueprintPure, Category="Side Scrolling")
 	bool HasWallJumped() const;
+
+	/** Returns the platforming movement component */
+	UPlatformingMovementComponent* GetPlatformingMovement() const;
 };
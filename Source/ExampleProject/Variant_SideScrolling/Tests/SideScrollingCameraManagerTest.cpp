@@ -0,0 +1,142 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SideScrollingCameraManager.h"
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace SideScrollingCameraTest
+{
+	/** Frame times are counted in ticks of 1/720s, so every tested frame rate lands exactly on the sample times */
+	constexpr int32 TicksPerSecond = 720;
+
+	/** The camera location is compared every 1/6s */
+	constexpr int32 TicksPerSample = 120;
+
+	/** Length of the replayed path */
+	constexpr int32 DurationTicks = 4 * TicksPerSecond;
+
+	/** Recorded pawn path: runs right while jumping, stops, then walks back */
+	FVector SamplePawnPath(double Time)
+	{
+		double X;
+
+		if (Time < 2.0)
+		{
+			X = 600.0 * Time;
+
+		} else if (Time < 2.5) {
+
+			X = 1200.0;
+
+		} else {
+
+			X = 1200.0 - 400.0 * (Time - 2.5);
+		}
+
+		double Z = 0.0;
+
+		if (Time >= 0.5 && Time < 1.35)
+		{
+			const double JumpTime = Time - 0.5;
+			Z = FMath::Max(0.0, 420.0 * JumpTime - 490.0 * JumpTime * JumpTime);
+		}
+
+		return FVector(X, 0.0, Z);
+	}
+
+	/** Replays the pawn path through the camera simulation and returns the camera location at every sample time */
+	TMap<int32, FVector> ReplayPath(ASideScrollingCameraManager* Camera, TFunctionRef<int32(int32)> GetFrameTicks)
+	{
+		const FVector StartLocation = SamplePawnPath(0.0);
+
+		Camera->CurrentZ = StartLocation.Z + Camera->CameraZOffset;
+		Camera->ResetCameraSimulation(FVector(StartLocation.X, StartLocation.Y + Camera->CurrentZoom, Camera->CurrentZ));
+
+		TMap<int32, FVector> Samples;
+
+		int32 Ticks = 0;
+
+		for (int32 Frame = 0; Ticks < DurationTicks; ++Frame)
+		{
+			const int32 FrameTicks = GetFrameTicks(Frame);
+			Ticks += FrameTicks;
+
+			const FVector PawnLocation = SamplePawnPath(static_cast<double>(Ticks) / TicksPerSecond);
+			const FVector CameraLocation = Camera->UpdateCameraSimulation(PawnLocation.X, PawnLocation.Y + Camera->CurrentZoom, PawnLocation.Z, true, static_cast<float>(FrameTicks) / TicksPerSecond);
+
+			if (Ticks % TicksPerSample == 0)
+			{
+				Samples.Add(Ticks, CameraLocation);
+			}
+		}
+
+		return Samples;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSideScrollingCameraFrameRateTest, "ExampleProject.SideScrolling.Camera.FrameRateIndependence", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FSideScrollingCameraFrameRateTest::RunTest(const FString& Parameters)
+{
+	using namespace SideScrollingCameraTest;
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	ASideScrollingCameraManager* Camera = World->SpawnActor<ASideScrollingCameraManager>();
+
+	if (TestNotNull(TEXT("Camera manager"), Camera))
+	{
+		// 240 fps is close enough to the 120 Hz simulation to act as the reference camera path
+		const TMap<int32, FVector> Reference = ReplayPath(Camera, [](int32) { return 3; });
+
+		struct FScenario
+		{
+			const TCHAR* Name;
+			TFunction<int32(int32)> GetFrameTicks;
+			float Tolerance;
+		};
+
+		const FScenario Scenarios[] =
+		{
+			{ TEXT("30 fps"), [](int32) { return 24; }, 15.0f },
+			{ TEXT("60 fps"), [](int32) { return 12; }, 15.0f },
+			{ TEXT("144 fps"), [](int32) { return 5; }, 15.0f },
+			{ TEXT("Varying frame rate"), [](int32 Frame) { const int32 FrameTicks[] = { 5, 12, 24 }; return FrameTicks[Frame % 3]; }, 15.0f },
+
+			// a 200ms hitch every second. The goal jumps ahead during the hitch, so allow a little more drift
+			{ TEXT("60 fps with hitches"), [](int32 Frame) { return Frame % 60 == 59 ? 144 : 12; }, 30.0f }
+		};
+
+		for (const FScenario& Scenario : Scenarios)
+		{
+			const TMap<int32, FVector> Samples = ReplayPath(Camera, Scenario.GetFrameTicks);
+
+			int32 NumCompared = 0;
+			float MaxError = 0.0f;
+
+			for (const TPair<int32, FVector>& Sample : Samples)
+			{
+				if (const FVector* ReferenceLocation = Reference.Find(Sample.Key))
+				{
+					MaxError = FMath::Max(MaxError, static_cast<float>(FVector::Dist(Sample.Value, *ReferenceLocation)));
+					++NumCompared;
+				}
+			}
+
+			TestTrue(FString::Printf(TEXT("%s compared samples"), Scenario.Name), NumCompared > 0);
+			TestTrue(FString::Printf(TEXT("%s max camera error %.2fcm within %.2fcm"), Scenario.Name, MaxError, Scenario.Tolerance), MaxError <= Scenario.Tolerance);
+		}
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS